@@ -0,0 +1,47 @@
+//    drive.h - the drive kinematics of a robot
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Each robot that supports ROBOT_EVENT_CMD_KINEMATICS has a
+// common/drive_<robot>.c which is linked into both its controller and its
+// robot binary, so the drive mix is the same whichever end runs it.
+//
+// Normally the controller runs the mix and sends MOTOR events. With
+// kinematics on, the controller only forwards axis and button events and
+// the robot runs the mix on its own control tick, writing the motors
+// directly. The axis numbers are the controller's joystick profile, so the
+// robot has to be started with the same -j.
+
+#ifndef DRIVE_H
+#define DRIVE_H
+
+#include "events.h"
+#include "mixer.h"
+
+// drive_on_robot - set on the controller by -k to have the robot mix
+extern int drive_on_robot;
+
+// drive_setup - configures the mixer for the robot's drive
+extern void drive_setup(mixer *m);
+
+// drive_button - follows the buttons that change the drive, eg. turbo
+extern void drive_button(mixer *m, const robot_event *ev);
+
+// drive_tick - works out and sends the drive outputs, once per control tick
+extern void drive_tick(mixer *m);
+
+#endif // !DRIVE_H
@@ -0,0 +1,138 @@
+//    drive_colonel.c - swerve drive kinematics for colonel
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <stdlib.h>
+#include "profile.h"
+#include "swerve.h"
+#include "drive.h"
+
+// Swerve steering isn't linear, so the mixer only supplies the axis
+// snapshot, the turbo presets and the output limits. The outputs are
+// worked out in drive_tick.
+#define IN_X 0        // strafe, right
+#define IN_Y 1        // strafe, forward
+#define IN_R 2        // twist
+#define IN_THROTTLE 3
+
+#define OUT_FRONT 0
+#define OUT_FRONT2 1
+#define OUT_REAR 2
+#define OUT_REAR2 3
+#define OUT_STEER_FRONT 4
+#define OUT_STEER_REAR 5
+
+static int turbo = 0;
+
+void drive_setup(mixer *m) {
+	int p;
+
+	mixer_init(m, 4, 6);
+	mixer_map_input(m, IN_X, CON_RAXIS, 0);
+	mixer_map_input(m, IN_Y, CON_ZAXIS, 0);
+	mixer_map_input(m, IN_R, CON_XAXIS, 1);
+	mixer_map_input(m, IN_THROTTLE, CON_YAXIS, 1);
+	// as the old handler read them: clipped to 1..254 and centred on 128,
+	// except twist, which it read as 127 - value
+	mixer_center_input(m, IN_X, 128, 1);
+	mixer_center_input(m, IN_Y, 128, 1);
+	mixer_center_input(m, IN_R, MIXER_CENTER, 1);
+	mixer_center_input(m, IN_THROTTLE, 128, 1);
+	// turning a module round from 500 gives SWERVE_TURN itself, which has
+	// always gone out as it is
+	mixer_map_output(m, OUT_STEER_FRONT, ROBOT_EVENT_MOTOR, 6, 0, 0, SWERVE_TURN);
+	mixer_map_output(m, OUT_STEER_REAR, ROBOT_EVENT_MOTOR, 7, 0, 0, SWERVE_TURN);
+	// the second motor on each end only runs with turbo, which also halves
+	// twist in drive_tick
+	for(p = 0; p < 3; p++) {
+		m->preset[p].out_scale[OUT_FRONT2] = p * MIXER_ONE / 2;
+		m->preset[p].out_scale[OUT_REAR2] = p * MIXER_ONE / 2;
+	}
+	turbo = 0;
+}
+
+void drive_button(mixer *m, const robot_event *ev) {
+	if(ev->index != CON_TURBO1 && ev->index != CON_TURBO2)
+		return;
+	if(ev->value && turbo < 2)
+		turbo++;
+	else if(!ev->value && turbo > 0)
+		turbo--;
+	mixer_select_preset(m, turbo);
+}
+
+void drive_tick(mixer *m) {
+	static int lastfront = 0, lastrear = 0; // steering values last sent
+	static int frontswap = 0, rearswap = 0; // module turned round, drive reversed
+	int front, rear, tempfront, temprear;
+	int rNew, throttle, strafe, frontdrive, reardrive;
+
+	mixer_tick(m); // no weights, this just schedules the periodic resend
+	rNew = mixer_input_value(m, IN_R);
+	if(turbo)
+		rNew >>= 1; // rounding down, as it always did
+	throttle = mixer_input_value(m, IN_THROTTLE);
+	strafe = swerve_strafe(mixer_input_value(m, IN_X), mixer_input_value(m, IN_Y));
+
+	front = strafe - swerve_twist(rNew);
+	rear = strafe + swerve_twist(rNew);
+	if(front > 999)
+		front -= 1000;
+	if(front < 0)
+		front += 1000;
+	if(rear > 999)
+		rear -= 1000;
+	if(rear < 0)
+		rear += 1000;
+
+	// While stopped, each module may point either way round, whichever
+	// is the shorter turn. Once moving it keeps that choice.
+	if(abs(throttle) < 10){
+		tempfront = (front > 500 ? front - 500 : front + 500);
+		temprear = (rear > 500 ? rear - 500 : rear + 500);
+		if(abs(lastfront - front) < abs(lastfront - tempfront)){
+			frontswap = 0;
+		} else {
+			frontswap = 1;
+			front = tempfront;
+		}
+		if(abs(lastrear - rear) < abs(lastrear - temprear)){
+			rearswap = 0;
+		} else {
+			rearswap = 1;
+			rear = temprear;
+		}
+	} else {
+		if(frontswap == 1)
+			front = (front > 500 ? front - 500 : front + 500);
+		if(rearswap == 1)
+			rear = (rear > 500 ? rear - 500 : rear + 500);
+	}
+	// throttle is 255 - value less 127, so reversed it is value less 127
+	frontdrive = (frontswap == 0 ? throttle : 1 - throttle);
+	reardrive = (rearswap == 0 ? 1 - throttle : throttle);
+
+	mixer_set_output(m, OUT_FRONT, frontdrive);
+	mixer_set_output(m, OUT_FRONT2, frontdrive);
+	mixer_set_output(m, OUT_REAR, reardrive);
+	mixer_set_output(m, OUT_REAR2, reardrive);
+
+	lastfront = front;
+	mixer_set_output(m, OUT_STEER_FRONT, front);
+	lastrear = rear;
+	mixer_set_output(m, OUT_STEER_REAR, rear);
+}
@@ -0,0 +1,177 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "profile.h"
+#include "swerve.h"
+#include "drive.h"
+
+// Checks drive_colonel.c against the on_axis_change it replaced. Which way
+// round each module points depends on where it pointed before, so this
+// follows both through the same random run of stick moves and turbo
+// presses rather than a grid.
+
+#define STEPS 2000000
+
+void test_run();
+void old_axis(int axis, int v, int turbo);
+int capture(robot_event *ev);
+int assert_equal(int expect, int given, char *msg);
+
+static mixer m;
+static int motor[8];
+
+// the old handler's state, from the mixer's resting values, as it didn't
+// have any until every axis had moved
+static unsigned char xAxis = 128, yAxis = 128, rAxis = 128;
+static int throttle = 127;
+static int lastfront = 0, lastrear = 0, frontswap = 0, rearswap = 0;
+static int old[8];
+
+int main() {
+
+	setProfile('p');
+	drive_setup(&m);
+	m.sink = capture;
+
+	printf("test_run()\n");
+	test_run();
+
+	printf("Yoohoo! no tests failed!\n");
+	return 0;
+}
+
+void test_run() {
+	static const int motors[6] = { 0, 1, 2, 3, 6, 7 };
+	int axes[4];
+	robot_event ev;
+	int step, i, turbo = 0, want, v;
+
+	axes[0] = CON_XAXIS;
+	axes[1] = CON_YAXIS;
+	axes[2] = CON_RAXIS;
+	axes[3] = CON_ZAXIS;
+	srand(1);
+	for(step = 0; step < STEPS; step++) {
+		if(rand() % 50 == 0) {
+			want = rand() % 3;
+			ev.command = ROBOT_EVENT_JOY_BUTTON;
+			ev.index = CON_TURBO1;
+			for(; turbo < want; turbo++) {
+				ev.value = 1;
+				drive_button(&m, &ev);
+			}
+			for(; turbo > want; turbo--) {
+				ev.value = 0;
+				drive_button(&m, &ev);
+			}
+		}
+
+		// the ends, around the throttle dead zone, and anywhere
+		if(rand() % 8 == 0)
+			v = (rand() % 2 ? 0 : 255);
+		else if(rand() % 4 == 0)
+			v = 118 + rand() % 20;
+		else
+			v = rand() % 256;
+		ev.command = ROBOT_EVENT_JOY_AXIS;
+		ev.index = axes[rand() % 4];
+		ev.value = v;
+		mixer_axis(&m, &ev);
+		for(i = 0; i < m.num_outputs; i++) {
+			m.out[i].resend = 1;
+		}
+		drive_tick(&m);
+
+		old_axis(ev.index, v, turbo);
+		for(i = 0; i < 6; i++) {
+			if(motor[motors[i]] != old[motors[i]]) {
+				printf("step %d axis %d value %d turbo %d motor %d: %d, was %d\n",
+						step, ev.index, v, turbo, motors[i],
+						motor[motors[i]], old[motors[i]]);
+			}
+			assert_equal(old[motors[i]], motor[motors[i]], "Motor differs from the old mix.");
+		}
+	}
+}
+
+// old_axis - the motor values the controller sent before the mixer, with
+// 	the integer swerve_strafe and swerve_twist in place of atan()
+void old_axis(int axis, int v, int turbo) {
+	unsigned char value = v;
+	int xNew, yNew, rNew, strafe, front, rear, tempfront, temprear;
+	int frontdrive, reardrive;
+
+	if(value == 255) value = 254;
+	if(value == 0) value = 1;
+	if(axis == CON_ZAXIS)
+		yAxis = value;
+	if(axis == CON_RAXIS)
+		xAxis = value;
+	if(axis == CON_XAXIS)
+		rAxis = 255 - value;
+	if(axis == CON_YAXIS)
+		throttle = 255 - value;
+	xNew = (int)xAxis - 128;
+	yNew = (int)yAxis - 128;
+	rNew = (int)rAxis - 128;
+	rNew = (turbo == 0 ? rNew : rNew >> 1);
+
+	strafe = swerve_strafe(xNew, yNew);
+	front = strafe - swerve_twist(rNew);
+	rear = strafe + swerve_twist(rNew);
+	if(front > 999)
+		front -= 1000;
+	if(front < 0)
+		front += 1000;
+	if(rear > 999)
+		rear -= 1000;
+	if(rear < 0)
+		rear += 1000;
+	if(throttle < 137 && throttle > 117) {
+		tempfront = (front > 500 ? front - 500 : front + 500);
+		temprear = (rear > 500 ? rear - 500 : rear + 500);
+		if(abs(lastfront - front) < abs(lastfront - tempfront)) {
+			frontswap = 0;
+		} else {
+			frontswap = 1;
+			front = tempfront;
+		}
+		if(abs(lastrear - rear) < abs(lastrear - temprear)) {
+			rearswap = 0;
+		} else {
+			rearswap = 1;
+			rear = temprear;
+		}
+	} else {
+		if(frontswap == 1)
+			front = (front > 500 ? front - 500 : front + 500);
+		if(rearswap == 1)
+			rear = (rear > 500 ? rear - 500 : rear + 500);
+	}
+	frontdrive = (frontswap == 0 ? throttle : 255 - throttle);
+	reardrive = (rearswap == 0 ? 255 - throttle : throttle);
+
+	old[0] = frontdrive;
+	old[1] = (((frontdrive - 127) * turbo) / 2) + 127;
+	old[2] = reardrive;
+	old[3] = (((reardrive - 127) * turbo) / 2) + 127;
+	lastfront = front;
+	old[6] = front;
+	lastrear = rear;
+	old[7] = rear;
+}
+
+// capture - the mixer's sink, keeps the motor values
+int capture(robot_event *ev) {
+	if(ev->command == ROBOT_EVENT_MOTOR && ev->index < 8) {
+		motor[ev->index] = ev->value;
+	}
+	return 1;
+}
+
+int assert_equal(int expect, int given, char *msg) {
+	if(expect != given) {
+		printf("%s\n", msg);
+		exit(1);
+	}
+	return 1;
+}
@@ -0,0 +1,75 @@
+//    drive_roslund.c - mecanum drive kinematics for roslund
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "profile.h"
+#include "drive.h"
+
+// Mecanum drive: x strafes, y drives, r turns. Each row is one wheel.
+#define IN_X 0
+#define IN_Y 1
+#define IN_R 2
+
+static const int drive_matrix[4][3] = {
+	{  MIXER_ONE, -MIXER_ONE, -MIXER_ONE },
+	{  MIXER_ONE,  MIXER_ONE, -MIXER_ONE },
+	{ -MIXER_ONE, -MIXER_ONE, -MIXER_ONE },
+	{ -MIXER_ONE,  MIXER_ONE, -MIXER_ONE },
+};
+
+// Half speed normally, two thirds with one turbo button, full with both
+static const int turbo_scale[3] = {
+	MIXER_ONE / 2, MIXER_ONE * 2 / 3, MIXER_ONE
+};
+
+static int turbo = 0;
+
+void drive_setup(mixer *m) {
+	int p, o;
+
+	mixer_init(m, 3, 4);
+	mixer_map_input(m, IN_X, CON_XAXIS, 0);
+	mixer_map_input(m, IN_Y, CON_YAXIS, 0);
+	mixer_map_input(m, IN_R, CON_RAXIS, 1);
+	// as the old handler read them: clipped to 1..254, and r negated as
+	// an unsigned char, 256 - value, which puts its center at 129
+	mixer_center_input(m, IN_X, MIXER_CENTER, 1);
+	mixer_center_input(m, IN_Y, MIXER_CENTER, 1);
+	mixer_center_input(m, IN_R, 129, 1);
+	mixer_set_matrix(m, &drive_matrix[0][0]);
+	m->normalize = 127;
+	for(p = 0; p < 3; p++) {
+		for(o = 0; o < 4; o++) {
+			m->preset[p].out_scale[o] = turbo_scale[p];
+		}
+	}
+	turbo = 0;
+}
+
+void drive_button(mixer *m, const robot_event *ev) {
+	if(ev->index != CON_TURBO1 && ev->index != CON_TURBO2)
+		return;
+	if(ev->value && turbo < 2)
+		turbo++;
+	else if(!ev->value && turbo > 0)
+		turbo--;
+	mixer_select_preset(m, turbo);
+}
+
+void drive_tick(mixer *m) {
+	mixer_tick(m);
+}
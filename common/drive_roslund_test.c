@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "profile.h"
+#include "drive.h"
+
+// Checks drive_roslund.c against the on_axis_change it replaced, for every
+// position of the three sticks at each turbo level.
+
+void test_grid();
+void old_mix(int x, int y, int r, int turbo, int *mot);
+int capture(robot_event *ev);
+int assert_equal(int expect, int given, char *msg);
+
+static mixer m;
+static int motor[4];
+
+int main() {
+
+	setProfile('p');
+	drive_setup(&m);
+	m.sink = capture;
+
+	printf("test_grid()\n");
+	test_grid();
+
+	printf("Yoohoo! no tests failed!\n");
+	return 0;
+}
+
+void test_grid() {
+	robot_event ev;
+	int x, y, r, turbo, i;
+	int mot[4];
+
+	for(turbo = 0; turbo < 3; turbo++) {
+		if(turbo > 0) {
+			ev.command = ROBOT_EVENT_JOY_BUTTON;
+			ev.index = (turbo == 1 ? CON_TURBO1 : CON_TURBO2);
+			ev.value = 1;
+			drive_button(&m, &ev);
+		}
+		ev.command = ROBOT_EVENT_JOY_AXIS;
+		for(x = 0; x < 256; x++) {
+			for(y = 0; y < 256; y++) {
+				for(r = 0; r < 256; r++) {
+					ev.index = CON_XAXIS;
+					ev.value = x;
+					mixer_axis(&m, &ev);
+					ev.index = CON_YAXIS;
+					ev.value = y;
+					mixer_axis(&m, &ev);
+					ev.index = CON_RAXIS;
+					ev.value = r;
+					mixer_axis(&m, &ev);
+					for(i = 0; i < 4; i++) {
+						m.out[i].resend = 1;
+					}
+					drive_tick(&m);
+
+					old_mix(x, y, r, turbo, mot);
+					for(i = 0; i < 4; i++) {
+						if(motor[i] != mot[i]) {
+							printf("x %d y %d r %d turbo %d motor %d: %d, was %d\n",
+									x, y, r, turbo, i, motor[i], mot[i]);
+						}
+						assert_equal(mot[i], motor[i], "Motor differs from the old mix.");
+					}
+				}
+			}
+		}
+	}
+}
+
+// old_mix - the motor values the controller sent before the mixer
+void old_mix(int x, int y, int r, int turbo, int *mot) {
+	unsigned char xAxis, yAxis, rAxis;
+	int xNew, yNew, rNew, max, i;
+
+	if(x == 255) x = 254;
+	if(x == 0) x = 1;
+	if(y == 255) y = 254;
+	if(y == 0) y = 1;
+	if(r == 255) r = 254;
+	if(r == 0) r = 1;
+	xAxis = x;
+	yAxis = y;
+	rAxis = -r;
+	xNew = (int)xAxis - 127;
+	yNew = (int)yAxis - 127;
+	rNew = (int)rAxis - 127;
+	mot[0] = -(yNew - xNew + rNew);
+	mot[1] = (yNew + xNew - rNew);
+	mot[2] = -(yNew + xNew + rNew);
+	mot[3] = (yNew - xNew - rNew);
+	if(abs(mot[0]) > 127 || abs(mot[1]) > 127 || abs(mot[2]) > 127 || abs(mot[3]) > 127) {
+		max = 0;
+		for(i = 0; i < 4; i++) {
+			if(abs(mot[i]) > max)
+				max = abs(mot[i]);
+		}
+		for(i = 0; i < 4; i++) {
+			mot[i] = (int)((float)mot[i] / max * 127);
+		}
+	}
+	for(i = 0; i < 4; i++) {
+		mot[i] = (mot[i] * 2) / (4 - turbo) + 127;
+	}
+}
+
+// capture - the mixer's sink, keeps the motor values
+int capture(robot_event *ev) {
+	if(ev->command == ROBOT_EVENT_MOTOR && ev->index < 4) {
+		motor[ev->index] = ev->value;
+	}
+	return 1;
+}
+
+int assert_equal(int expect, int given, char *msg) {
+	if(expect != given) {
+		printf("%s\n", msg);
+		exit(1);
+	}
+	return 1;
+}
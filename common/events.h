@@ -39,11 +39,21 @@ enum {
     ROBOT_EVENT_NET_STATUS_OK       = ROBOT_EVENT_NET | 0x00, // OK
     ROBOT_EVENT_NET_STATUS_ERR      = ROBOT_EVENT_NET | 0x01, // Error
     ROBOT_EVENT_NET_STATUS_NOTICE   = ROBOT_EVENT_NET | 0x02, // Notice
+    ROBOT_EVENT_NET_REL_DATA        = ROBOT_EVENT_NET | 0x08, // Reliable event, see robot_rel.h
+    ROBOT_EVENT_NET_REL_ACK         = ROBOT_EVENT_NET | 0x09, // Reliable acknowledgement
+    ROBOT_EVENT_NET_TELEMETRY       = ROBOT_EVENT_NET | 0x0A, // Telemetry frame, see telemetry.h
+    ROBOT_EVENT_NET_PING            = ROBOT_EVENT_NET | 0x0B, // Link probe, see link.h
+    ROBOT_EVENT_NET_PONG            = ROBOT_EVENT_NET | 0x0C, // Link probe echoed back
+    ROBOT_EVENT_NET_MULTIPATH       = ROBOT_EVENT_NET | 0x0D, // Event sent down two paths, see robot_mp.h
+    ROBOT_EVENT_NET_TIMED           = ROBOT_EVENT_NET | 0x0E, // Event with the sender's clock, see robot_jb.h
 
     ROBOT_EVENT_CMD_NOOP            = ROBOT_EVENT_CMD | 0x00, // No op
     ROBOT_EVENT_CMD_START           = ROBOT_EVENT_CMD | 0x01, // Start
     ROBOT_EVENT_CMD_STOP            = ROBOT_EVENT_CMD | 0x02, // Stop
     ROBOT_EVENT_CMD_REBOOT          = ROBOT_EVENT_CMD | 0x03, // Reboot
+    ROBOT_EVENT_CMD_KINEMATICS      = ROBOT_EVENT_CMD | 0x04, // value 1: robot mixes the drive from axes
+
+    ROBOT_EVENT_READ_VAR_SUBSCRIBE  = ROBOT_EVENT_READ_VAR | 0x01, // index: variable, value: rate (Hz) << 8 | change threshold
 };
 
 // The user should implement these
@@ -93,4 +103,8 @@ extern void on_1hz_timer(robot_event *ev);
 
 extern void on_10hz_timer(robot_event *ev);
 
+// on_control_tick runs TIMER_CONTROL_HZ times a second on the controller,
+// this is where the drive mixer is evaluated
+extern void on_control_tick(robot_event *ev);
+
 #endif // !EVENTS_H
@@ -0,0 +1,222 @@
+//    link.c - estimates the quality of the radio link
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <string.h>
+#include <time.h>
+#include <semaphore.h>
+#include "robot_comm.h"
+#include "robot_log.h"
+#include "link.h"
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+// The main loop pings and the network thread takes the pongs, so all of it
+// is under lock.
+static sem_t lock;
+
+static const char *const names[] = { "good", "fair", "poor", "down" };
+
+static unsigned char next_seq = 0;
+static char outstanding[256];       // by sequence number
+static int now = 0;                 // 10 Hz ticks
+static int last_pong = 0;           // tick the last pong arrived
+
+static unsigned int outcomes = 0;   // a bit per ping, newest lowest, set if lost
+static int samples = 0;             // pings in outcomes, up to LINK_WINDOW
+static int srtt = -1;               // smoothed round trip time in ms, -1 before any
+
+static int state = LINK_DOWN;
+static int better_ticks = 0;        // ticks a better state has held
+static int measured = 0;            // a pong has ever moved the state
+
+static unsigned int count_pings = 0;
+static unsigned int count_lost = 0;
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// loss - percent of the pings in the window that went unanswered
+static int loss() {
+	unsigned int bits;
+	int lost = 0;
+
+	if(samples == 0) {
+		return 0;
+	}
+	for(bits = outcomes; bits; bits >>= 1) {
+		lost += bits & 1;
+	}
+	return lost * 100 / samples;
+}
+
+// note - adds a ping's outcome to the window
+static void note(int lost) {
+	outcomes = ((outcomes << 1) | lost) & ((1 << LINK_WINDOW) - 1);
+	if(samples < LINK_WINDOW) {
+		samples++;
+	}
+	if(lost) {
+		count_lost++;
+	}
+}
+
+// assess - the state the latest figures call for
+static int assess() {
+	int l = loss();
+
+	if(srtt < 0 || now - last_pong >= LINK_DOWN_TICKS) {
+		return LINK_DOWN;
+	}
+	if(l >= 20 || srtt >= 250) {
+		return LINK_POOR;
+	}
+	if(l >= 5 || srtt >= 80) {
+		return LINK_FAIR;
+	}
+	return LINK_GOOD;
+}
+
+// change - moves to a new state, logging it with the time of day so it can
+// 	be lined up with what happened on the field
+static void change(int to) {
+	char when[16];
+	time_t t = time(NULL);
+
+	strftime(when, sizeof(when), "%H:%M:%S", localtime(&t));
+	log_string(1, "link: %s %s -> %s, %d%% loss, %d ms round trip",
+			when, names[state], names[to], loss(), srtt);
+	state = to;
+	better_ticks = 0;
+	if(to != LINK_DOWN) {
+		measured = 1;
+	}
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void link_init() {
+	sem_init(&lock, 0, 1);
+}
+
+void link_tick() {
+	robot_ping_frame f;
+	unsigned char old;
+	int to;
+
+	sem_wait(&lock);
+	now++;
+	old = next_seq - LINK_TIMEOUT_TICKS;
+	if(outstanding[old]) {
+		outstanding[old] = 0;
+		note(1);
+	}
+
+	to = assess();
+	if(to > state) {
+		change(to);
+	} else if(to < state) {
+		// nothing to flap from at startup, so the first pongs count at once
+		if(!measured || ++better_ticks >= LINK_RECOVER_TICKS) {
+			change(to);
+		}
+	} else {
+		better_ticks = 0;
+	}
+
+	memset(&f, 0, sizeof(f));
+	f.command = ROBOT_EVENT_NET_PING;
+	f.seq = next_seq;
+	outstanding[next_seq++] = 1;
+	count_pings++;
+	sem_post(&lock);
+
+	timebase_stamp(timebase_local(), &f.sent);
+	if(!send_datagram(&f, sizeof(f))) {
+		// eg. no controller yet, which says nothing about the link
+		sem_wait(&lock);
+		outstanding[f.seq] = 0;
+		count_pings--;
+		sem_post(&lock);
+	}
+}
+
+void link_receive(robot_ping_frame *f, long long now_us) {
+	long long sent, received, replied;
+	int rtt, fresh;
+
+	if(f->command == ROBOT_EVENT_NET_PING) {
+		f->command = ROBOT_EVENT_NET_PONG;
+		timebase_stamp(now_us, &f->received);
+		timebase_stamp(timebase_local(), &f->replied);
+		send_datagram(f, sizeof(*f));
+		return;
+	}
+
+	sent = timebase_unstamp(&f->sent);
+	received = timebase_unstamp(&f->received);
+	replied = timebase_unstamp(&f->replied);
+	// not counting the time the other end took to answer
+	rtt = ((now_us - sent) - (replied - received)) / 1000;
+
+	sem_wait(&lock);
+	fresh = outstanding[f->seq];
+	if(fresh) { // late ones were already counted lost
+		outstanding[f->seq] = 0;
+		note(0);
+		srtt = srtt < 0 ? rtt : srtt + (rtt - srtt) / 8;
+		last_pong = now;
+	}
+	sem_post(&lock);
+
+	if(fresh) {
+		timebase_sample(sent, received, replied, now_us);
+	}
+}
+
+int link_state() {
+	int s;
+
+	sem_wait(&lock);
+	s = state;
+	sem_post(&lock);
+	return s;
+}
+
+int link_scale() {
+	switch(link_state()) {
+		case LINK_GOOD:
+			return 1;
+		case LINK_FAIR:
+			return 2;
+		default:
+			return 4;
+	}
+}
+
+void link_log_stats(int level) {
+	sem_wait(&lock);
+	log_string(level, "link: %s, %d%% loss, %d ms round trip, %u pings, %u lost",
+			names[state], loss(), srtt, count_pings, count_lost);
+	count_pings = 0;
+	count_lost = 0;
+	sem_post(&lock);
+}
@@ -0,0 +1,80 @@
+//    link.h - estimates the quality of the radio link
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Both ends send a robot_ping_frame on the 10 Hz timer, alongside the NOOP
+// heartbeat. The other end's network thread stamps it and sends it straight
+// back as a pong. Its times also keep the clocks in step, see timebase.h.
+// The loss over the last LINK_WINDOW pings and a smoothed round trip time
+// give the link a state. A worse state takes effect at once, a better one only
+// after it has held for LINK_RECOVER_TICKS, so the rates don't flap. The
+// first state measured after startup also takes effect at once.
+//
+// The senders of discretionary traffic divide their rates by link_scale():
+// robot_tx flushes less often, the robot sends fewer telemetry frames and
+// robot_rel keeps fewer frames in flight. Commands, buttons, status codes,
+// the heartbeat and the pings themselves are never held back.
+
+#ifndef LINK_H
+#define LINK_H
+
+#include "events.h"
+#include "timebase.h"
+
+#define LINK_WINDOW 20          // pings the loss is measured over
+#define LINK_TIMEOUT_TICKS 5    // 10 Hz ticks before a ping counts as lost
+#define LINK_DOWN_TICKS 10      // 10 Hz ticks without a pong before the link is down
+#define LINK_RECOVER_TICKS 20   // 10 Hz ticks a better state must hold
+
+enum {
+	LINK_GOOD = 0,  // under 5% loss and 80 ms
+	LINK_FAIR,      // under 20% loss and 250 ms
+	LINK_POOR,
+	LINK_DOWN       // no pong for LINK_DOWN_TICKS
+};
+
+typedef struct {
+	unsigned char command;  // ROBOT_EVENT_NET_PING or _PONG
+	unsigned char seq;
+	unsigned short unused;
+	robot_stamp sent;       // pinger's clock
+	robot_stamp received;   // the other end's clock, pong only
+	robot_stamp replied;    // the other end's clock, pong only
+} robot_ping_frame;
+
+// link_init - sets up the estimate, called by the network thread
+extern void link_init();
+
+// link_tick - sends a ping, counts the ones gone unanswered and updates the
+// 	state, on the 10 Hz timer
+extern void link_tick();
+
+// link_receive - answers a ping or takes a pong, from the network thread
+// 	at local time now, just after it arrived
+extern void link_receive(robot_ping_frame *f, long long now);
+
+// link_state - one of LINK_GOOD to LINK_DOWN
+extern int link_state();
+
+// link_scale - what to divide discretionary rates by: 1 when the link is
+// 	good, 2 when fair, 4 when poor or down
+extern int link_scale();
+
+// link_log_stats - logs the state, loss and round trip time
+extern void link_log_stats(int level);
+
+#endif //!LINK_H
@@ -0,0 +1,270 @@
+//    mixer.c - table driven mixing of joystick axes into robot outputs
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// mixer.c
+//
+// Every robot turns a few joystick axes into motor values with some sums,
+// a normalization step and a turbo button. Axis events only update the
+// latest reading of their input; the outputs are worked out once per
+// control tick, so a stick sweep that produces dozens of axis events still
+// costs one evaluation and at most one event per output.
+//
+#include <stdlib.h>
+#include <string.h>
+#include "robot_comm.h"
+#include "mixer.h"
+
+//---------------------------------------------------------------------------//
+// Private Function Prototypes
+//
+static int shape_input(mixer *m, int input);
+static void send_output(mixer *m, int output, int value);
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void mixer_init(mixer *m, int num_inputs, int num_outputs) {
+	int i, j;
+
+	memset(m, 0, sizeof(*m));
+	if (num_inputs > MIXER_MAX_INPUTS) {
+		num_inputs = MIXER_MAX_INPUTS;
+	}
+	if (num_outputs > MIXER_MAX_OUTPUTS) {
+		num_outputs = MIXER_MAX_OUTPUTS;
+	}
+	m->num_inputs = num_inputs;
+	m->num_outputs = num_outputs;
+	m->sink = send_event;
+
+	for(i = 0; i < MIXER_MAX_INPUTS; i++) {
+		m->in[i].axis = -1;
+		m->in[i].center = MIXER_CENTER;
+		m->in[i].db_ref = -1;
+		m->in[i].db_div = 1;
+	}
+	for(i = 0; i < MIXER_MAX_OUTPUTS; i++) {
+		m->out[i].command = ROBOT_EVENT_MOTOR;
+		m->out[i].index = i;
+		m->out[i].center = MIXER_CENTER;
+		m->out[i].min = -MIXER_CENTER;
+		m->out[i].max = 255 - MIXER_CENTER;
+		m->out[i].resend = 1;
+	}
+	for(i = 0; i < MIXER_MAX_PRESETS; i++) {
+		for(j = 0; j < MIXER_MAX_INPUTS; j++) {
+			m->preset[i].in_scale[j] = MIXER_ONE;
+		}
+		for(j = 0; j < MIXER_MAX_OUTPUTS; j++) {
+			m->preset[i].out_scale[j] = MIXER_ONE;
+		}
+	}
+}
+
+void mixer_map_input(mixer *m, int input, int axis, int invert) {
+	if (input < 0 || input >= m->num_inputs) {
+		return;
+	}
+	m->in[input].axis = axis;
+	m->in[input].invert = invert;
+}
+
+void mixer_center_input(mixer *m, int input, int center, int clip) {
+	if (input < 0 || input >= m->num_inputs) {
+		return;
+	}
+	m->in[input].center = center;
+	m->in[input].clip = clip;
+}
+
+void mixer_map_output(mixer *m, int output, unsigned char command,
+		unsigned char index, int center, int min, int max) {
+	if (output < 0 || output >= m->num_outputs) {
+		return;
+	}
+	m->out[output].command = command;
+	m->out[output].index = index;
+	m->out[output].center = center;
+	m->out[output].min = min;
+	m->out[output].max = max;
+	m->out[output].resend = 1;
+}
+
+void mixer_set_matrix(mixer *m, const int *weights) {
+	int i, j;
+
+	for(i = 0; i < m->num_outputs; i++) {
+		for(j = 0; j < m->num_inputs; j++) {
+			m->weight[i][j] = weights[i * m->num_inputs + j];
+		}
+	}
+}
+
+void mixer_select_preset(mixer *m, int preset) {
+	if (preset < 0) {
+		preset = 0;
+	}
+	if (preset >= MIXER_MAX_PRESETS) {
+		preset = MIXER_MAX_PRESETS - 1;
+	}
+	m->active = preset;
+}
+
+int mixer_axis(mixer *m, const robot_event *ev) {
+	int i, value;
+	int used = 0;
+
+	for(i = 0; i < m->num_inputs; i++) {
+		if (m->in[i].axis == ev->index) {
+			value = ev->value;
+			if (m->in[i].clip && value > 254) {
+				value = 254;
+			}
+			if (m->in[i].clip && value < 1) {
+				value = 1;
+			}
+			value -= m->in[i].center;
+			m->in[i].raw = m->in[i].invert ? -value : value;
+			used = 1;
+		}
+	}
+	return used;
+}
+
+int mixer_input_value(mixer *m, int input) {
+	if (input < 0 || input >= m->num_inputs) {
+		return 0;
+	}
+	return shape_input(m, input);
+}
+
+void mixer_send_axes(mixer *m) {
+	robot_event ev;
+	int i;
+
+	for(i = 0; i < m->num_inputs; i++) {
+		if (m->in[i].axis < 0) {
+			continue;
+		}
+		ev.command = ROBOT_EVENT_JOY_AXIS;
+		ev.index = m->in[i].axis;
+		ev.value = (m->in[i].invert ? -m->in[i].raw : m->in[i].raw) + m->in[i].center;
+		m->sink(&ev);
+	}
+}
+
+void mixer_tick(mixer *m) {
+	int in[MIXER_MAX_INPUTS];
+	int out[MIXER_MAX_OUTPUTS];
+	int used[MIXER_MAX_OUTPUTS];
+	int i, j, peak;
+
+	// outputs are only sent when they change, so once in a while send
+	// everything again in case a datagram went missing
+	if (++m->ticks >= MIXER_REFRESH_TICKS) {
+		m->ticks = 0;
+		for(i = 0; i < m->num_outputs; i++) {
+			m->out[i].resend = 1;
+		}
+	}
+
+	for(j = 0; j < m->num_inputs; j++) {
+		in[j] = shape_input(m, j);
+	}
+
+	peak = 0;
+	for(i = 0; i < m->num_outputs; i++) {
+		out[i] = 0;
+		used[i] = 0;
+		for(j = 0; j < m->num_inputs; j++) {
+			if (m->weight[i][j] != 0) {
+				out[i] += m->weight[i][j] * in[j];
+				used[i] = 1;
+			}
+		}
+		out[i] /= MIXER_ONE;
+		if (used[i] && abs(out[i]) > peak) {
+			peak = abs(out[i]);
+		}
+	}
+
+	// scale everything down by the same amount so the direction of travel
+	// is kept when the sticks ask for more than the motors can give
+	if (m->normalize > 0 && peak > m->normalize) {
+		for(i = 0; i < m->num_outputs; i++) {
+			out[i] = out[i] * m->normalize / peak;
+		}
+	}
+
+	for(i = 0; i < m->num_outputs; i++) {
+		if (used[i]) {
+			mixer_set_output(m, i, out[i]);
+		}
+	}
+}
+
+void mixer_set_output(mixer *m, int output, int value) {
+	if (output < 0 || output >= m->num_outputs) {
+		return;
+	}
+	value = value * m->preset[m->active].out_scale[output] / MIXER_ONE;
+	send_output(m, output, value);
+}
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+static int shape_input(mixer *m, int input) {
+	mixer_input *in = &m->in[input];
+	const mixer_preset *p = &m->preset[m->active];
+	int deadband = in->deadband;
+
+	if (in->db_ref >= 0 && in->db_ref < m->num_inputs && in->db_div != 0) {
+		deadband += abs(m->in[in->db_ref].raw * p->in_scale[in->db_ref] / MIXER_ONE) / in->db_div;
+	}
+	if (abs(in->raw) < deadband) {
+		return 0;
+	}
+	return in->raw * p->in_scale[input] / MIXER_ONE;
+}
+
+static void send_output(mixer *m, int output, int value) {
+	mixer_output *o = &m->out[output];
+	robot_event ev;
+
+	if (value > o->max) {
+		value = o->max;
+	}
+	if (value < o->min) {
+		value = o->min;
+	}
+	value += o->center;
+
+	if (value == o->last && !o->resend) {
+		return;
+	}
+	ev.command = o->command;
+	ev.index = o->index;
+	ev.value = value;
+	if (m->sink(&ev)) {
+		o->last = value;
+		o->resend = 0;
+	}
+}
@@ -0,0 +1,124 @@
+//    mixer.h - table driven mixing of joystick axes into robot outputs
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef MIXER_H
+#define MIXER_H
+
+#include "events.h"
+
+#define MIXER_MAX_INPUTS 8
+#define MIXER_MAX_OUTPUTS 8
+#define MIXER_MAX_PRESETS 4
+#define MIXER_ONE 384 // weight or scale of 1.0, so that halves, thirds,
+                      // quarters, sixths and eighths are exact
+#define MIXER_CENTER 127 // joystick axis center
+#define MIXER_REFRESH_TICKS 50 // resend unchanged outputs this often
+
+// How a mixer input is read from the latest joystick axis values.
+// Inputs are centred on 0 and run from -127 to 128.
+typedef struct {
+	int axis;       // joystick axis number, -1 if the input is unused
+	int invert;     // non-zero if pushing the axis up/right reads negative
+	int center;     // axis value read as 0, MIXER_CENTER by default
+	int clip;       // non-zero to read axis values 0 and 255 as 1 and 254
+	int deadband;   // readings closer than this to 0 are taken as 0
+	int db_ref;     // input whose (scaled) magnitude widens the deadband, or -1
+	int db_div;     // the deadband grows by |db_ref| / db_div
+	int raw;        // latest reading, before the deadband and preset scale
+} mixer_input;
+
+// Where a mixer output is sent and how far it may move.
+typedef struct {
+	unsigned char command; // ROBOT_EVENT_MOTOR, ROBOT_EVENT_SET_VAR...
+	unsigned char index;   // motor or variable number
+	int center;     // added to the mixed value before sending
+	int min;        // limits on the mixed value, before center is added
+	int max;
+	int last;       // last value sent
+	int resend;     // send at the next chance even if unchanged
+} mixer_output;
+
+// A set of scale factors, eg. normal/turbo/superboost. Inputs are scaled
+// before mixing, outputs after normalization.
+typedef struct {
+	int in_scale[MIXER_MAX_INPUTS];
+	int out_scale[MIXER_MAX_OUTPUTS];
+} mixer_preset;
+
+typedef struct {
+	int num_inputs;
+	int num_outputs;
+	mixer_input in[MIXER_MAX_INPUTS];
+	mixer_output out[MIXER_MAX_OUTPUTS];
+	int weight[MIXER_MAX_OUTPUTS][MIXER_MAX_INPUTS]; // MIXER_ONE = 1.0
+	int normalize;  // if non-zero, outputs are scaled down together so
+	                // that none is larger than this
+	mixer_preset preset[MIXER_MAX_PRESETS];
+	int active;     // preset in use
+	int ticks;      // ticks since outputs were last all resent
+	int (*sink)(robot_event *ev); // where outputs go, send_event by default
+} mixer;
+
+// mixer_init - sets up a mixer with no weights, unused inputs, unlimited
+// 	motor outputs centred on MIXER_CENTER, every preset scale at
+// 	MIXER_ONE and outputs going to send_event. The robot's on_init then
+// 	fills in what it needs.
+extern void mixer_init(mixer *m, int num_inputs, int num_outputs);
+
+// mixer_map_input - feeds input from a joystick axis
+extern void mixer_map_input(mixer *m, int input, int axis, int invert);
+
+// mixer_center_input - reads input as 0 at axis value center rather than
+// 	MIXER_CENTER, and with clip set, reads 0 and 255 as 1 and 254. For
+// 	matching the outputs of the handlers the mixer replaced.
+extern void mixer_center_input(mixer *m, int input, int center, int clip);
+
+// mixer_map_output - sends output as the given event and limits it to
+// 	min..max about center
+extern void mixer_map_output(mixer *m, int output, unsigned char command,
+		unsigned char index, int center, int min, int max);
+
+// mixer_set_matrix - copies num_outputs rows of num_inputs weights
+extern void mixer_set_matrix(mixer *m, const int *weights);
+
+// mixer_select_preset - switches to another preset, out of range values
+// 	are clamped
+extern void mixer_select_preset(mixer *m, int preset);
+
+// mixer_axis - records a joystick axis event. Returns non-zero if the
+// 	axis feeds one of the inputs. Nothing is sent until mixer_tick.
+extern int mixer_axis(mixer *m, const robot_event *ev);
+
+// mixer_input_value - the latest reading of an input after the deadband
+// 	and the active preset's scale
+extern int mixer_input_value(mixer *m, int input);
+
+// mixer_send_axes - sends a JOY_AXIS event to the sink with the latest
+// 	reading of every mapped input, so the other end can rebuild the snapshot
+extern void mixer_send_axes(mixer *m);
+
+// mixer_tick - evaluates the matrix over the latest axis values and sends
+// 	the outputs that changed. Call once per control tick.
+extern void mixer_tick(mixer *m);
+
+// mixer_set_output - limits, scales by the active preset and sends a value
+// 	for an output computed outside the matrix (eg. swerve steering), if
+// 	it changed. Outputs with all-zero weights are left alone by mixer_tick.
+extern void mixer_set_output(mixer *m, int output, int value);
+
+#endif // !MIXER_H
@@ -0,0 +1,21 @@
+#!/usr/bin/python
+# Generates atanlut[] for swerve.c
+#
+# atanlut[i] = atan(i / 256) in steering units (1000 per turn), with 4
+# fractional bits. i runs from 0 to 256 inclusive so swerve.c can
+# interpolate up to a ratio of exactly 1.
+from math import atan, pi
+import sys
+
+N = 256
+FRAC = 4
+
+def entry(i):
+    return int(round(atan(float(i) / N) * 500.0 / pi * (1 << FRAC)))
+
+sys.stdout.write("static const short atanlut[%d] = {" % (N + 1))
+for i in range(0, N + 1):
+    if i % 10 == 0: sys.stdout.write('\n   ')
+    sys.stdout.write(' %4d' % entry(i))
+    if i != N: sys.stdout.write(',')
+sys.stdout.write('\n};\n')
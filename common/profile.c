@@ -14,36 +14,65 @@ int		  CON_XAXIS,
 		  CON_EXTRA,
 		  CON_REAR;
 
-void setProfile(char data){
+// fillProfile - puts the button or axis number of each role for a
+// joystick type into map
+static void fillProfile(char data, int *map){
 	switch(data) {
 		case 'x':
-			CON_XAXIS 		= 0x00;
-			CON_YAXIS 		= 0x01;
-			CON_RAXIS 		= 0x03;
-			CON_ZAXIS		= 0x02;
-			CON_TURBO1 		= 0x07;
-			CON_TURBO2 		= 0x08;
-			CON_ARM_UP 		= 0x09;
-			CON_ARM_DOWN 	= 0x06;
-			CON_GRIP 		= 0x00;
-			CON_FRONT		= 0x02;
-			CON_REAR		= 0x03;
-			CON_EXTRA		= 0x01;
+			map[CON_ROLE_XAXIS] 		= 0x00;
+			map[CON_ROLE_YAXIS] 		= 0x01;
+			map[CON_ROLE_RAXIS] 		= 0x03;
+			map[CON_ROLE_ZAXIS]		= 0x02;
+			map[CON_ROLE_TURBO1] 		= 0x07;
+			map[CON_ROLE_TURBO2] 		= 0x08;
+			map[CON_ROLE_ARM_UP] 		= 0x09;
+			map[CON_ROLE_ARM_DOWN] 	= 0x06;
+			map[CON_ROLE_GRIP] 		= 0x00;
+			map[CON_ROLE_FRONT]		= 0x02;
+			map[CON_ROLE_REAR]		= 0x03;
+			map[CON_ROLE_EXTRA]		= 0x01;
 			break;
 		case 'p':
 		default:
-			CON_XAXIS 		= 0x00;
-			CON_YAXIS 		= 0x01;
-			CON_RAXIS 		= 0x02;
-			CON_ZAXIS		= 0x03;
-			CON_TURBO1 		= 0x05;
-			CON_TURBO2 		= 0x07;
-			CON_ARM_UP 		= 0x04;
-			CON_ARM_DOWN 		= 0x06;
-			CON_GRIP 		= 0x01;
-			CON_FRONT		= 0x02;
-			CON_EXTRA		= 0x08; 
-			CON_REAR	    	= 0x03;
+			map[CON_ROLE_XAXIS] 		= 0x00;
+			map[CON_ROLE_YAXIS] 		= 0x01;
+			map[CON_ROLE_RAXIS] 		= 0x02;
+			map[CON_ROLE_ZAXIS]		= 0x03;
+			map[CON_ROLE_TURBO1] 		= 0x05;
+			map[CON_ROLE_TURBO2] 		= 0x07;
+			map[CON_ROLE_ARM_UP] 		= 0x04;
+			map[CON_ROLE_ARM_DOWN] 		= 0x06;
+			map[CON_ROLE_GRIP] 		= 0x01;
+			map[CON_ROLE_FRONT]		= 0x02;
+			map[CON_ROLE_EXTRA]		= 0x08; 
+			map[CON_ROLE_REAR]	    	= 0x03;
 			break;
 	}
 }
+
+void setProfile(char data){
+	int map[CON_ROLES];
+
+	fillProfile(data, map);
+	CON_XAXIS		= map[CON_ROLE_XAXIS];
+	CON_YAXIS		= map[CON_ROLE_YAXIS];
+	CON_RAXIS		= map[CON_ROLE_RAXIS];
+	CON_ZAXIS		= map[CON_ROLE_ZAXIS];
+	CON_TURBO1		= map[CON_ROLE_TURBO1];
+	CON_TURBO2		= map[CON_ROLE_TURBO2];
+	CON_ARM_UP		= map[CON_ROLE_ARM_UP];
+	CON_ARM_DOWN	= map[CON_ROLE_ARM_DOWN];
+	CON_GRIP		= map[CON_ROLE_GRIP];
+	CON_FRONT		= map[CON_ROLE_FRONT];
+	CON_EXTRA		= map[CON_ROLE_EXTRA];
+	CON_REAR		= map[CON_ROLE_REAR];
+}
+
+int profileIndex(char data, int role){
+	int map[CON_ROLES];
+
+	if(role < 0 || role >= CON_ROLES)
+		return -1;
+	fillProfile(data, map);
+	return map[role];
+}
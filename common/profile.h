@@ -1,5 +1,27 @@
+// Roles, in the same order as the CON_ variables. The first
+// CON_ROLE_AXES are axes, the rest buttons.
+enum {
+	CON_ROLE_XAXIS,
+	CON_ROLE_YAXIS,
+	CON_ROLE_RAXIS,
+	CON_ROLE_ZAXIS,
+	CON_ROLE_TURBO1,
+	CON_ROLE_TURBO2,
+	CON_ROLE_ARM_UP,
+	CON_ROLE_ARM_DOWN,
+	CON_ROLE_GRIP,
+	CON_ROLE_FRONT,
+	CON_ROLE_EXTRA,
+	CON_ROLE_REAR,
+	CON_ROLES
+};
+#define CON_ROLE_AXES 4
+
 extern void setProfile(char data);
 
+// profileIndex - the axis or button number a joystick type uses for a role
+extern int profileIndex(char data, int role);
+
 extern int CON_XAXIS,
 			  CON_YAXIS,
 			  CON_RAXIS,
@@ -19,9 +19,12 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/ip.h>
 #include <netdb.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -29,6 +32,10 @@
 #include "robot_queue.h"
 #include "robot_log.h"
 #include "events.h"
+#include "telemetry.h"
+#include "link.h"
+#include "timebase.h"
+#include "robot_jb.h"
 
 // These values should be read-only after the thread has started
 // Therefore we do not need to lock them
@@ -40,6 +47,14 @@ static struct sockaddr_in server; // server machine
 // protect it using a semaphore
 static struct sockaddr_in client; // client machine
 static sem_t sem_client; // client semaphore
+static int low_latency = 0; // set before the thread starts
+
+// receive statistics, from the network thread to the 1 Hz timer
+static sem_t sem_stats;
+static unsigned int count_received = 0;
+static unsigned int count_stamped = 0;
+static long long handled_sum = 0;
+static int handled_max = 0;
 
 //------------------------------------------------------------------------------
 // Local function prototypes
@@ -60,10 +75,20 @@ static int open_udp_server(unsigned short port);
 //
 static int open_udp_client(char *hostname, unsigned short port);
 
-// recv_event - receive a robot comm datagram
-// 	event - pointer to datagram to overwrite
-// 	return - 0 on failure, no-zero otherwise
-static int recv_event(robot_event *ev);
+// tune_socket - applies the low latency profile, logging and going on
+// 	without any option the kernel refuses
+static void tune_socket();
+
+// recv_datagram - receive a robot comm datagram, a bare robot_event, a
+// 	robot_rel_frame, a robot_mp_frame, a robot_timed_frame, a
+// 	robot_ping_frame or a telemetry frame
+// 	buf - where to put it
+// 	size - the size of buf
+// 	arrived - set to when it arrived on timebase_local(), by the kernel's
+// 		  stamp if there is one
+// 	return - the length of the datagram, or < 0 on failure
+static int recv_datagram(void *buf, size_t size, long long *arrived);
+
 
 // close_udp - closes the socket
 // 	return - 0 on failure, non-zero otherwise
@@ -78,9 +103,19 @@ void log_event(robot_event *ev, char was_received);
 //------------------------------------------------------------------------------
 // Function Implementation
 
+void net_set_low_latency(int on) {
+	low_latency = on;
+}
+
 int net_thread_server_create(robot_queue *q, unsigned short port) {
 	// initialize the semaphores
 	sem_init(&sem_client, 0, 1);
+	sem_init(&sem_stats, 0, 1);
+	rel_init();
+	telemetry_init();
+	link_init();
+	mp_init();
+	timebase_init(0);
 
 	// open up the port
 	if (open_udp_server(port) < 0) {
@@ -97,6 +132,12 @@ int net_thread_server_create(robot_queue *q, unsigned short port) {
 int net_thread_client_create(robot_queue *q, char *hostname, unsigned short port) {
 	// initialize the semaphores
 	sem_init(&sem_client, 0, 1);
+	sem_init(&sem_stats, 0, 1);
+	rel_init();
+	telemetry_init();
+	link_init();
+	mp_init();
+	timebase_init(1); // the controller's clock is the common one
 
 	// open the port
 	if (open_udp_client(hostname, port) < 0) {
@@ -131,11 +172,55 @@ int net_thread_destroy() {
 
 void *net_thread_main(void *arg) {
     robot_queue *q = (robot_queue *)arg;
+    union {
+        robot_event ev;
+        robot_rel_frame frame;
+        robot_mp_frame mp;
+        robot_timed_frame timed;
+        robot_ping_frame ping;
+        unsigned char bytes[TELEMETRY_MAX_FRAME];
+    } buf;
     robot_event ev;
+    long long arrived;
+    int len, handled;
 
 	while(1) {
-		recv_event(&ev);
-        robot_queue_enqueue(q, &ev);
+		len = recv_datagram(&buf, sizeof(buf), &arrived);
+		if(len == sizeof(robot_event)) {
+			jb_order(&buf.ev, q);
+			robot_queue_enqueue(q, &buf.ev);
+		} else if(len <= 0) {
+			continue;
+		} else if(buf.bytes[0] == ROBOT_EVENT_NET_TELEMETRY) {
+			telemetry_receive(buf.bytes, len, arrived);
+		} else if(buf.bytes[0] == ROBOT_EVENT_NET_MULTIPATH &&
+				len == sizeof(robot_mp_frame)) {
+			if(mp_receive(&buf.mp, &ev)) {
+				jb_order(&ev, q);
+				robot_queue_enqueue(q, &ev);
+			}
+		} else if((buf.bytes[0] == ROBOT_EVENT_NET_PING ||
+					buf.bytes[0] == ROBOT_EVENT_NET_PONG) &&
+				len == sizeof(robot_ping_frame)) {
+			link_receive(&buf.ping, arrived);
+		} else if(buf.bytes[0] == ROBOT_EVENT_NET_TIMED &&
+				len == sizeof(robot_timed_frame)) {
+			jb_receive(&buf.timed, q, arrived);
+		} else if(len == sizeof(robot_rel_frame)) {
+			if(buf.frame.command == ROBOT_EVENT_NET_REL_DATA) {
+				jb_order(&buf.frame.ev, q);
+			}
+			rel_receive(&buf.frame, q);
+		}
+
+		handled = timebase_local() - arrived;
+		sem_wait(&sem_stats);
+		count_received++;
+		handled_sum += handled;
+		if(handled > handled_max) {
+			handled_max = handled;
+		}
+		sem_post(&sem_stats);
 	}
 }
 
@@ -154,6 +239,9 @@ int open_udp_server(unsigned short port) {
 		log_errno(1, "Error opening socket");
 		return -1;
 	}
+	if(low_latency) {
+		tune_socket();
+	}
 
 	// bind to the socket
 	bzero(&server, sizeof(server)); // make a clean memory area
@@ -191,6 +279,9 @@ int open_udp_client(char *hostname, unsigned short port) {
 		log_errno(1, "Error opening socket");
 		return -1;
 	}
+	if(low_latency) {
+		tune_socket();
+	}
 
 	// get the server's address
 	if ((server_attr = gethostbyname(hostname)) == NULL) {
@@ -212,6 +303,28 @@ int open_udp_client(char *hostname, unsigned short port) {
 // 	value - optional value associated with some commands
 // 	return - 0 on failure, non-zero otherwise
 int send_event(robot_event *ev) {
+	if(mp_enabled()) {
+		if(!mp_send(ev)) {
+			return 0;
+		}
+	} else if(!send_datagram(ev, sizeof(robot_event))) {
+		return 0;
+	}
+	log_event_sent(ev);
+	return 1;
+}
+
+int send_frame(robot_rel_frame *f) {
+	if(!send_datagram(f, sizeof(robot_rel_frame))) {
+		return 0;
+	}
+	if(f->command == ROBOT_EVENT_NET_REL_DATA) {
+		log_event_sent(&f->ev);
+	}
+	return 1;
+}
+
+int send_datagram(const void *buf, size_t len) {
 	struct sockaddr_in remote;
 
 	if(client_mode) {
@@ -221,44 +334,124 @@ int send_event(robot_event *ev) {
 		remote = client;
 		sem_post(&sem_client);
 	}
+	return send_datagram_to(buf, len, &remote);
+}
 
+int send_datagram_to(const void *buf, size_t len, const struct sockaddr_in *to) {
 	if(sockfd < 0) {
 		return 0;
 	}
-	if (remote.sin_addr.s_addr == 0) {
+	if (to->sin_addr.s_addr == 0) {
 		log_errno(-1, "Unknown remote host, no clients have connected yet.");
 		return 0;
 	}
 
-	if(sendto(sockfd, ev, sizeof(robot_event), 0, (struct sockaddr *)&remote , sizeof(remote)) < 0) {
+	if(sendto(sockfd, buf, len, 0, (struct sockaddr *)to, sizeof(*to)) < 0) {
 		log_errno(0, "Error sending on socket.");
 		return 0;
 	}
+	return 1;
+}
 
-	log_event_sent(ev);
+// tune_socket - applies the low latency profile, logging and going on
+// 	without any option the kernel refuses
+void tune_socket() {
+	int val;
 
-	return 1;
-		
+	val = NET_RCVBUF;
+	if(setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &val, sizeof(val)) < 0) {
+		log_errno(1, "Error sizing the receive buffer");
+	}
+	val = NET_DSCP << 2; // the low two bits of the old TOS byte are ECN
+	if(setsockopt(sockfd, IPPROTO_IP, IP_TOS, &val, sizeof(val)) < 0) {
+		log_errno(1, "Error marking the socket's DSCP");
+	}
+	val = NET_PRIORITY;
+	if(setsockopt(sockfd, SOL_SOCKET, SO_PRIORITY, &val, sizeof(val)) < 0) {
+		log_errno(1, "Error setting the socket's priority");
+	}
+#ifdef SO_TIMESTAMPNS
+	val = 1;
+	if(setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &val, sizeof(val)) < 0) {
+		log_errno(1, "Error turning on receive timestamps");
+	}
+#else
+	log_string(1, "No SO_TIMESTAMPNS, timing datagrams as they are read");
+#endif
+#ifdef SO_BUSY_POLL
+	// raising it past net.core.busy_read needs CAP_NET_ADMIN
+	val = NET_BUSY_POLL_US;
+	if(setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val)) < 0) {
+		log_errno(1, "Error turning on busy polling");
+	}
+#else
+	log_string(1, "No SO_BUSY_POLL, receiving without it");
+#endif
 }
 
-// recv_event - receive a robot comm datagram
-// 	event - pointer to datagram to overwrite
-// 	return - 0 on failure, no-zero otherwise
-int recv_event(robot_event *ev) {
+// recv_datagram - receive a robot comm datagram
+// 	return - the length of the datagram, or < 0 on failure
+int recv_datagram(void *buf, size_t size, long long *arrived) {
 	struct sockaddr_in remote;
-	socklen_t remotelen;
-
-	remotelen = sizeof(remote); // needs to be initialized
+	struct iovec iov;
+	struct msghdr msg;
+	char control[64];
+	int len;
+#ifdef SO_TIMESTAMPNS
+	struct cmsghdr *cmsg;
+	struct timespec stamp, wall;
+	long long ago;
+#endif
 
 	if(sockfd < 0) {
-		return 0;
+		return -1;
 	}
 
+	iov.iov_base = buf;
+	iov.iov_len = size;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &remote;
+	msg.msg_namelen = sizeof(remote); // needs to be initialized
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
 	// wait until we receive a packet
-	if (recvfrom(sockfd, ev, sizeof(robot_event), 0, (struct sockaddr *)&remote, &remotelen)  < 0) {
-		return 0;
+	if ((len = recvmsg(sockfd, &msg, 0))  < 0) {
+		return -1;
 	} else {
-		log_event_received(ev); // log it
+		*arrived = timebase_local();
+#ifdef SO_TIMESTAMPNS
+		for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			if(cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS) {
+				continue;
+			}
+			// the kernel stamps on the wall clock, so go by how long ago
+			memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+			clock_gettime(CLOCK_REALTIME, &wall);
+			ago = (wall.tv_sec - stamp.tv_sec) * 1000000LL +
+				(wall.tv_nsec - stamp.tv_nsec) / 1000;
+			if(ago >= 0) { // unless the wall clock was just set back
+				*arrived -= ago;
+				sem_wait(&sem_stats);
+				count_stamped++;
+				sem_post(&sem_stats);
+			}
+		}
+#endif
+		if(len == sizeof(robot_event)) {
+			log_event_received((robot_event *)buf); // log it
+		} else if(len == sizeof(robot_rel_frame) &&
+				((robot_rel_frame *)buf)->command == ROBOT_EVENT_NET_REL_DATA) {
+			log_event_received(&((robot_rel_frame *)buf)->ev);
+		} else if(len == sizeof(robot_mp_frame) &&
+				((robot_mp_frame *)buf)->command == ROBOT_EVENT_NET_MULTIPATH) {
+			log_event_received(&((robot_mp_frame *)buf)->ev);
+		} else if(len == sizeof(robot_timed_frame) &&
+				((robot_timed_frame *)buf)->command == ROBOT_EVENT_NET_TIMED) {
+			log_event_received(&((robot_timed_frame *)buf)->ev);
+		}
 		if(!client_mode) { // server mode - we don't know who our controller is, so set the remote
 				   // machine to the last person who wrote us something.
 			sem_wait(&sem_client);
@@ -266,10 +459,49 @@ int recv_event(robot_event *ev) {
 			sem_post(&sem_client);
 		} // otherwise do nothing with remote
 	}
-	return 1;
+	return len;
 
 }
 
+unsigned char net_session() {
+	struct timespec ts;
+	unsigned char s;
+	int fd;
+
+	if((fd = open("/dev/urandom", O_RDONLY)) >= 0) {
+		if(read(fd, &s, 1) == 1) {
+			close(fd);
+			return s;
+		}
+		close(fd);
+	}
+	log_errno(0, "Error reading /dev/urandom, taking a session from the clock");
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned char)(ts.tv_nsec ^ (ts.tv_nsec >> 8) ^ getpid());
+}
+
+void net_log_stats(int level) {
+	unsigned int received, stamped;
+	long long sum;
+	int max;
+
+	sem_wait(&sem_stats);
+	received = count_received;
+	stamped = count_stamped;
+	sum = handled_sum;
+	max = handled_max;
+	count_received = 0;
+	count_stamped = 0;
+	handled_sum = 0;
+	handled_max = 0;
+	sem_post(&sem_stats);
+
+	if(received > 0) {
+		log_string(level, "net: %u datagrams, %u stamped by the kernel, arrival to handled %lld us mean, %d us max",
+				received, stamped, sum / received, max);
+	}
+}
+
 // close_udp - closes the socket
 // 	return - 0 on failure, non-zero otherwise
 int close_udp() {
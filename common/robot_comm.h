@@ -24,15 +24,57 @@
 #include <netinet/in.h>
 #include "robot_queue.h"
 #include "events.h"
+#include "robot_rel.h"
+#include "robot_mp.h"
 
 
+// The low latency profile (robot and controller -L) tunes the socket:
+// busy polling for a while before the network thread sleeps in recv, kernel
+// receive timestamps, which the link, clock, telemetry and playout
+// measurements then go by instead of when the thread got round to the
+// datagram, expedited forwarding DSCP and interactive priority on what is
+// sent, and a receive buffer sized for a burst rather than a backlog.
+// Everything on the socket is control traffic, so it is all marked.
+#define NET_BUSY_POLL_US 50     // us to busy poll the device queue
+#define NET_RCVBUF 32768        // bytes, the kernel doubles it for overhead
+#define NET_DSCP 46             // expedited forwarding
+#define NET_PRIORITY 6          // interactive, the highest without CAP_NET_ADMIN
+
+// net_set_low_latency - turns the low latency profile on, before the thread
+// 	is created
+extern void net_set_low_latency(int on);
+
 extern int net_thread_server_create(robot_queue *q, unsigned short port);
 extern int net_thread_client_create(robot_queue *q, char *hostname, unsigned short port);
 extern int net_thread_destroy();
 
-// send_dgm - send a robot communication datagram
+// send_dgm - send a robot communication datagram, down both paths if
+// 	multipath is on, see robot_mp.h
 // 	dgm - pointer to the datagram to send
 // 	return - 0 on failure, non-zero otherwise
 extern int send_event(robot_event *ev);
 
+// send_datagram - sends a datagram that isn't a robot_event, eg. a
+// 	telemetry frame
+// 	return - 0 on failure, non-zero otherwise
+extern int send_datagram(const void *buf, size_t len);
+
+// send_datagram_to - sends a datagram to another address of the remote
+// 	end, eg. its second radio
+// 	return - 0 on failure, non-zero otherwise
+extern int send_datagram_to(const void *buf, size_t len, const struct sockaddr_in *to);
+
+// send_frame - sends a frame of the reliable channel, see robot_rel.h
+// 	return - 0 on failure, non-zero otherwise
+extern int send_frame(robot_rel_frame *f);
+
+// net_session - a random byte for the reliable and multipath channels to
+// 	tell this run of the program from the last one. From /dev/urandom, as
+// 	the Gumstix has no clock that survives a reboot to seed from.
+extern unsigned char net_session();
+
+// net_log_stats - logs how many datagrams the kernel stamped and how long
+// 	they took from arriving to being handled
+extern void net_log_stats(int level);
+
 #endif //!ROBOT_COMM_H
@@ -0,0 +1,169 @@
+//    robot_comm_bench.c - times events from the socket to the event queue
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// robot_comm_bench.c
+//
+// Runs the robot's side of robot_comm twice, with the default socket and
+// then with the low latency profile, while a thread sends it a button event
+// every interval. Buttons, as the queue would fold axis events together.
+// Each is timed from just before sendto to when robot_queue_wait_event
+// hands it over, which is what the robot's main loop sees. The net stats
+// after each run say how much of that the kernel's receive stamps account
+// for.
+//
+// Over loopback there is no device queue for SO_BUSY_POLL to poll, so what
+// it saves only shows on a real interface.
+//
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "robot_comm.h"
+#include "robot_queue.h"
+#include "robot_log.h"
+#include "timebase.h"
+#include "events.h"
+
+#define BENCH_MAX 65536
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static unsigned short port = 31338;
+static int events = 2000;
+static int interval = 2000;         // us between events
+static long long sent[BENCH_MAX];   // timebase_local() of each send
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+static int compare(const void *a, const void *b) {
+	return *(const int *)a - *(const int *)b;
+}
+
+// send_thread_main - sends the events to the bench's port on loopback
+static void *send_thread_main(void *arg) {
+	struct sockaddr_in to;
+	robot_event ev;
+	int fd, i;
+
+	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+		log_errno(1, "Error opening socket");
+		return 0;
+	}
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	to.sin_port = htons(port);
+
+	ev.command = ROBOT_EVENT_JOY_BUTTON;
+	ev.index = 0;
+	for(i = 0; i < events; i++) {
+		ev.value = i;
+		sent[i] = timebase_local();
+		sendto(fd, &ev, sizeof(ev), 0, (struct sockaddr *)&to, sizeof(to));
+		usleep(interval);
+	}
+	close(fd);
+	return 0;
+}
+
+// run - times one pass of events through robot_comm
+// 	return - 0 on failure
+static int run(int low_latency) {
+	static int latency[BENCH_MAX];
+	robot_queue q;
+	robot_event ev;
+	pthread_t tid;
+	int n = 0;
+	long long sum = 0;
+
+	robot_queue_create(&q);
+	net_set_low_latency(low_latency);
+	if(!net_thread_server_create(&q, port)) {
+		return 0;
+	}
+	if(pthread_create(&tid, NULL, send_thread_main, NULL) != 0) {
+		return 0;
+	}
+	// a lost datagram would leave this waiting, but not over loopback
+	while(n < events && robot_queue_wait_event(&q, &ev)) {
+		latency[n] = timebase_local() - sent[ev.value];
+		sum += latency[n];
+		n++;
+	}
+	pthread_join(tid, NULL);
+
+	qsort(latency, n, sizeof(latency[0]), compare);
+	printf("%s socket: %d events, send to dequeue %lld us mean, %d us median,"
+			" %d us 99th percentile, %d us max\n",
+			low_latency ? "low latency" : "default", n, sum / n,
+			latency[n / 2], latency[n * 99 / 100], latency[n - 1]);
+	fflush(stdout); // before the stats on stderr
+	net_log_stats(1);
+
+	net_thread_destroy();
+	robot_queue_destroy(&q);
+	return 1;
+}
+
+static void usage(char *progname) {
+	fprintf(stderr, "Usage: %s [-p port (31338)] [-n events (2000)] [-i interval us (2000)]\n",
+			progname);
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+int main(int argc, char **argv) {
+	int opt;
+
+	while((opt = getopt(argc, argv, "p:n:i:")) != -1) {
+		switch(opt) {
+			case 'p':
+				port = atoi(optarg);
+				break;
+			case 'n':
+				events = atoi(optarg);
+				break;
+			case 'i':
+				interval = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if(events < 1 || events > BENCH_MAX || interval < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	log_level = 1;
+
+	if(!run(0) || !run(1)) {
+		fprintf(stderr, "Error starting the network thread\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,365 @@
+//    robot_jb.c - plays control events out at the cadence they were sent
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// robot_jb.c
+//
+// The two clocks aren't synchronised, so only the transit time relative to
+// its running mean is used: an event that took the mean time to arrive is
+// held for exactly the delay, a quicker one for longer, a slower one for
+// less. The jitter is the smoothed difference between the transit times of
+// successive events, as RTP measures it.
+//
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include "robot_comm.h"
+#include "robot_log.h"
+#include "robot_jb.h"
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	robot_event ev;
+	unsigned int play;  // when to queue it, ms on the monotonic clock
+} jb_entry;
+
+typedef struct {
+	unsigned char command;
+	unsigned char index;
+	unsigned short sent;    // sent time of the newest value scheduled
+} jb_key;
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static int stamping = 0;
+
+// Set up before the threads start
+static int enabled = 0;
+static int min_delay = 0;
+static int max_delay = JB_MAX_DELAY;
+static pthread_t tid = 0;
+static volatile int running = 0;
+
+// The network thread schedules and the playout thread plays
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond;
+static jb_entry buf[JB_SIZE];       // ring, in play order
+static int head = 0;
+static int count = 0;
+
+static int have = 0;                // transit times have been seen
+static unsigned short mean;         // running mean transit time
+static int mean_rest = 0;           // what hasn't made it into mean yet
+static unsigned short last_transit;
+static int jitter16 = 0;            // jitter in 1/16 ms
+static int cur_delay = -1;          // ms, -1 before the first event
+static unsigned short last_sent;    // sent time of the last event scheduled
+static unsigned int last_play = 0;
+static jb_key keys[JB_SIZE];
+static int num_keys = 0;
+
+static unsigned int count_played = 0;
+static unsigned int count_late = 0;
+static unsigned int count_stale = 0;
+static unsigned int count_resync = 0;
+static unsigned int count_flushed = 0;
+static int max_held = 0;
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+static unsigned int now_ms() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// target - what the jitter says to hold an event of mean transit time for
+static int target() {
+	int d = 3 * jitter16 / 16;
+
+	if(d < min_delay) {
+		d = min_delay;
+	}
+	if(d > max_delay) {
+		d = max_delay;
+	}
+	return d;
+}
+
+// stale - whether a newer value of the same event was already scheduled,
+// 	noting f's sent time if not
+static int stale(const robot_timed_frame *f) {
+	int i;
+
+	for(i = 0; i < num_keys; i++) {
+		if(keys[i].command == f->ev.command && keys[i].index == f->ev.index) {
+			break;
+		}
+	}
+	if(i == num_keys) {
+		if(num_keys == JB_SIZE) {
+			return 0;
+		}
+		num_keys++;
+		keys[i].command = f->ev.command;
+		keys[i].index = f->ev.index;
+	} else if((short)(f->sent - keys[i].sent) < 0) {
+		return 1;
+	}
+	keys[i].sent = f->sent;
+	return 0;
+}
+
+// schedule - works out when to play an event, with the lock held
+// 	return - the time, or 0 if the event is stale and should be dropped
+static unsigned int schedule(const robot_timed_frame *f, unsigned int now) {
+	unsigned short transit = now - f->sent;
+	short off = transit - mean;
+	short step;
+	unsigned int play;
+
+	if(!have || off > JB_RESYNC_MS || off < -JB_RESYNC_MS) {
+		// first event, or the controller restarted
+		if(have) {
+			count_resync++;
+		}
+		have = 1;
+		num_keys = 0;
+		cur_delay = target();
+		mean = transit;
+		mean_rest = 0;
+		last_transit = transit;
+		last_sent = f->sent - 1;
+		off = 0;
+	}
+	if(stale(f)) {
+		count_stale++;
+		return 0;
+	}
+
+	// a flush sends several events at once, count it once
+	if(f->sent != last_sent) {
+		last_sent = f->sent;
+		step = transit - last_transit;
+		jitter16 += abs(step) - jitter16 / 16;
+		last_transit = transit;
+		mean_rest += off;
+		mean += mean_rest / 64;
+		mean_rest %= 64;
+		// a millisecond a flush at most, or the cadence would bunch up
+		// or stretch while the delay moves
+		if(cur_delay < target()) {
+			cur_delay++;
+		} else if(cur_delay > target()) {
+			cur_delay--;
+		}
+	}
+
+	play = now - off + cur_delay;
+	if((int)(play - now) <= 0) {
+		count_late++;
+		play = now;
+	}
+	// never overtake what is already waiting
+	if(count > 0 && (int)(play - last_play) < 0) {
+		play = last_play;
+	}
+	last_play = play;
+	return play;
+}
+
+// jb_thread_main - queues each event when its time comes
+static void *jb_thread_main(void *arg) {
+	robot_queue *q = (robot_queue *)arg;
+	struct timespec until;
+	int wait;
+
+	pthread_mutex_lock(&lock);
+	while(running) {
+		if(count == 0) {
+			pthread_cond_wait(&cond, &lock);
+			continue;
+		}
+		wait = buf[head].play - now_ms();
+		if(wait > 0) {
+			clock_gettime(CLOCK_MONOTONIC, &until);
+			until.tv_nsec += wait * 1000000L;
+			until.tv_sec += until.tv_nsec / 1000000000;
+			until.tv_nsec %= 1000000000;
+			pthread_cond_timedwait(&cond, &lock, &until);
+			continue;
+		}
+		// queued with the lock held, so jb_order can't slip an action
+		// in ahead of it
+		robot_queue_enqueue(q, &buf[head].ev);
+		head = (head + 1) % JB_SIZE;
+		count--;
+		count_played++;
+	}
+	pthread_mutex_unlock(&lock);
+	return 0;
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void jb_set_stamping(int on) {
+	stamping = on;
+}
+
+int jb_stamping() {
+	return stamping;
+}
+
+int jb_send(const robot_event *ev) {
+	robot_timed_frame f;
+
+	f.command = ROBOT_EVENT_NET_TIMED;
+	f.unused = 0;
+	f.sent = now_ms();
+	f.ev = *ev;
+	return send_datagram(&f, sizeof(f));
+}
+
+int jb_configure(const char *spec) {
+	char *end;
+	long lo, hi;
+
+	lo = strtol(spec, &end, 10);
+	if(end == spec || lo < 0) {
+		return 0;
+	}
+	hi = lo > JB_MAX_DELAY ? lo : JB_MAX_DELAY;
+	if(*end == ':') {
+		spec = end + 1;
+		hi = strtol(spec, &end, 10);
+		if(end == spec || hi < lo) {
+			return 0;
+		}
+	}
+	if(*end != '\0') {
+		return 0;
+	}
+	min_delay = lo;
+	max_delay = hi;
+	enabled = 1;
+	return 1;
+}
+
+int jb_thread_create(robot_queue *q) {
+	pthread_condattr_t attr;
+
+	if(!enabled) {
+		return 1;
+	}
+	// the play times are on the monotonic clock, so wait on it too
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	running = 1;
+	if(pthread_create(&tid, NULL, jb_thread_main, q) != 0) {
+		running = 0;
+		enabled = 0;
+		return 0;
+	}
+	return 1;
+}
+
+int jb_thread_destroy() {
+	if(tid <= 0) {
+		return 0;
+	}
+	pthread_mutex_lock(&lock);
+	running = 0;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&lock);
+	if(pthread_join(tid, NULL) != 0) {
+		return 0;
+	}
+	tid = 0;
+	return 1;
+}
+
+void jb_receive(const robot_timed_frame *f, robot_queue *q, long long arrived) {
+	unsigned int play;
+
+	if(!running) {
+		robot_queue_enqueue(q, &f->ev);
+		return;
+	}
+	pthread_mutex_lock(&lock);
+	if(count == JB_SIZE) {
+		count_late++;
+		pthread_mutex_unlock(&lock);
+		robot_queue_enqueue(q, &f->ev); // better early than lost
+		return;
+	}
+	// the same monotonic clock as now_ms()
+	if((play = schedule(f, (unsigned int)(arrived / 1000))) != 0) {
+		buf[(head + count) % JB_SIZE].ev = f->ev;
+		buf[(head + count) % JB_SIZE].play = play;
+		if(++count > max_held) {
+			max_held = count;
+		}
+		pthread_cond_signal(&cond);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void jb_order(const robot_event *ev, robot_queue *q) {
+	int n;
+
+	// the heartbeat and status codes don't act on anything
+	if(!running || ev->command == ROBOT_EVENT_CMD_NOOP ||
+			(ev->command & 0xF0) == ROBOT_EVENT_NET) {
+		return;
+	}
+	pthread_mutex_lock(&lock);
+	for(n = 0; count > 0; n++) {
+		robot_queue_enqueue(q, &buf[head].ev);
+		head = (head + 1) % JB_SIZE;
+		count--;
+	}
+	count_played += n;
+	count_flushed += n;
+	pthread_mutex_unlock(&lock);
+}
+
+void jb_log_stats(int level) {
+	pthread_mutex_lock(&lock);
+	if(running && have) {
+		log_string(level, "jb: delay %d ms, jitter %d ms, %u played, %u played early for an action, %u late, %u stale, %u resynced, %d held at most",
+				cur_delay, jitter16 / 16, count_played, count_flushed, count_late,
+				count_stale, count_resync, max_held);
+	}
+	count_played = 0;
+	count_flushed = 0;
+	count_late = 0;
+	count_stale = 0;
+	count_resync = 0;
+	max_held = 0;
+	pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,89 @@
+//    robot_jb.h - plays control events out at the cadence they were sent
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Wi-Fi tends to deliver datagrams in clumps, and the robot then moves the
+// motors in bursts. With stamping on (controller -s), robot_tx sends the
+// stick, motor and variable values it holds in a robot_timed_frame carrying
+// the controller's clock. With the playout buffer on (robot -b), the robot
+// holds each one back so that it reaches the queue at
+//
+// 	sent + mean transit time + delay
+//
+// which spaces the events out as they were sent. The delay follows three
+// times the measured jitter, between the configured minimum and maximum.
+// A value that arrives after a newer one for any held event is dropped, and
+// one that arrives too late to keep its place plays straight away.
+//
+// Commands, buttons and status codes aren't stamped and are never held
+// back. So that an action never overtakes the sticks it was pressed with,
+// as robot_tx promises, a command or button plays everything still held
+// straight away before it is queued itself. Without -b the robot queues
+// stamped events as they arrive.
+
+#ifndef ROBOT_JB_H
+#define ROBOT_JB_H
+
+#include "robot_queue.h"
+#include "events.h"
+
+#define JB_SIZE 64              // events waiting to be played
+#define JB_MAX_DELAY 100        // ms, unless -b gives a maximum
+#define JB_RESYNC_MS 500        // a transit time this far off starts over
+
+typedef struct {
+	unsigned char command;  // ROBOT_EVENT_NET_TIMED
+	unsigned char unused;
+	unsigned short sent;    // sender's clock in ms
+	robot_event ev;
+} robot_timed_frame;
+
+// jb_set_stamping - whether jb_stamping() says to stamp, the controller's -s
+extern void jb_set_stamping(int on);
+
+// jb_stamping - whether held events should go out through jb_send
+extern int jb_stamping();
+
+// jb_send - sends ev in a robot_timed_frame
+// 	return - 0 on failure
+extern int jb_send(const robot_event *ev);
+
+// jb_configure - turns the playout buffer on from a "-b" command line
+// 	argument: min_ms[:max_ms]. Call before jb_thread_create.
+// 	return - 0 if spec is invalid
+extern int jb_configure(const char *spec);
+
+// jb_thread_create - starts playing out into q if jb_configure was called
+// 	return - 0 on failure
+extern int jb_thread_create(robot_queue *q);
+
+// jb_thread_destroy - stops playing out, dropping what is still held
+extern int jb_thread_destroy();
+
+// jb_receive - schedules a stamped event, from the network thread, which
+// 	got it at arrived on timebase_local()
+extern void jb_receive(const robot_timed_frame *f, robot_queue *q, long long arrived);
+
+// jb_order - plays everything held right away if ev, an unstamped event
+// 	about to be queued, is an action the held values mustn't play after.
+// 	From the network thread.
+extern void jb_order(const robot_event *ev, robot_queue *q);
+
+// jb_log_stats - logs the delay and what was played, late or dropped
+extern void jb_log_stats(int level);
+
+#endif //!ROBOT_JB_H
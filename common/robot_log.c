@@ -22,8 +22,27 @@
 #include <errno.h>
 #include <netdb.h>
 #include "robot_log.h"
+#include "timebase.h"
 
 int log_level = 0;
+int log_times = 0;
+
+//-----------------------------------------------------------------------------
+// Private functions
+//
+
+// log_time - starts a line with the time on the controller's clock, marked
+// 	with a ? on the robot until its clock is in step
+static void log_time() {
+	long long ms;
+
+	if (!log_times) {
+		return;
+	}
+	ms = timebase_now() / 1000;
+	fprintf(stderr, "%lld.%03lld%s ", ms / 1000, ms % 1000,
+			timebase_synced() ? "" : "?");
+}
 
 //-----------------------------------------------------------------------------
 // Public functions
@@ -32,6 +51,7 @@ void log_string(int level, char *format, ...) {
 	va_list argp;
 
 	if (log_level <= level) {
+		log_time();
 
 		va_start(argp, format);
 		vfprintf(stderr, format, argp);
@@ -43,27 +63,31 @@ void log_string(int level, char *format, ...) {
 
 void log_errno(int level, char *format, ...) {
 	va_list argp;
+	int saved = errno; // the clock could clobber it
 
 	if (log_level <= level) {
+		log_time();
 
 		va_start(argp, format);
 		vfprintf(stderr, format, argp);
 		va_end(argp);
 
-		fprintf(stderr, ": %s\n", strerror(errno));
+		fprintf(stderr, ": %s\n", strerror(saved));
 	}
 }
 
 void log_dns_error(int level, char *format, ...) {
 	va_list argp;
+	int saved = h_errno;
 
 	if (log_level <= level) {
+		log_time();
 
 		va_start(argp, format);
 		vfprintf(stderr, format, argp);
 		va_end(argp);
 
 
-		fprintf(stderr, ": DNS error %d\n", h_errno);
+		fprintf(stderr, ": DNS error %d\n", saved);
 	}
 }
@@ -20,6 +20,7 @@
 //-----------------------------------------------------------------------------
 //
 extern int log_level;
+extern int log_times; // start each line with the time, see timebase.h
 
 //-----------------------------------------------------------------------------
 // Public functions
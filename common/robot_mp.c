@@ -0,0 +1,291 @@
+//    robot_mp.c - sends each event twice, over two paths
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <netdb.h>
+#include <semaphore.h>
+#include "robot_comm.h"
+#include "robot_log.h"
+#include "robot_mp.h"
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	robot_mp_frame f;
+	int due;        // control tick to send it on
+} mp_late;
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+// send_event runs on the main loop and, for pongs, on the network thread,
+// so the sender is under lock. The receiver is only used by the network
+// thread, but the stats are read from the main loop.
+static sem_t lock;
+
+// sender
+static int enabled = 0;
+static int delay = 0;               // control ticks, 0 if path 1 is alt
+static const char *alt_host = NULL;
+static struct sockaddr_in alt;
+static unsigned char session;
+static unsigned short next_seq = 0;
+static mp_late late[MP_DELAY_QUEUE]; // ring, oldest first
+static int late_head = 0;
+static int late_count = 0;
+static int now = 0;                 // control ticks
+
+// receiver
+static int in_session = -1;         // the sender's session, -1 before any
+static unsigned short top;          // newest sequence number delivered
+static int far_behind = 0;          // frames in a row MP_DEDUP or more behind
+static unsigned short seen[MP_DEDUP]; // by seq % MP_DEDUP
+static char seen_valid[MP_DEDUP];
+static unsigned short seen_ms[MP_DEDUP]; // when the first copy arrived
+static unsigned short path_last[MP_PATHS];
+static char path_have[MP_PATHS];
+
+static unsigned int count_sent[MP_PATHS];
+static unsigned int count_received[MP_PATHS];
+static unsigned int count_lost[MP_PATHS];
+static unsigned int count_first[MP_PATHS];
+static unsigned int count_behind[MP_PATHS];
+static unsigned int behind_ms[MP_PATHS]; // summed over count_behind
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+static unsigned short now_ms() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// send_path - sends a copy down its path, with the lock held
+static int send_path(robot_mp_frame *f, int path) {
+	f->path = path;
+	count_sent[path]++;
+	if(path == 1 && delay == 0) {
+		return send_datagram_to(f, sizeof(*f), &alt);
+	}
+	return send_datagram(f, sizeof(*f));
+}
+
+// reset - forgets the sequence numbers of an earlier session
+static void reset(unsigned char s) {
+	int i;
+
+	log_string(-1, "mp: new session %02X", s);
+	in_session = s;
+	for(i = 0; i < MP_DEDUP; i++) {
+		seen_valid[i] = 0;
+	}
+	for(i = 0; i < MP_PATHS; i++) {
+		path_have[i] = 0;
+	}
+}
+
+// note_path - counts a copy arriving on its path and the ones before it
+// 	that never did
+static void note_path(const robot_mp_frame *f) {
+	short ahead = f->seq - path_last[f->path];
+
+	count_received[f->path]++;
+	if(!path_have[f->path]) {
+		path_have[f->path] = 1;
+		path_last[f->path] = f->seq;
+	} else if(ahead > 0) {
+		count_lost[f->path] += ahead - 1;
+		path_last[f->path] = f->seq;
+	}
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+int mp_configure(const char *spec) {
+	char *end;
+	long n;
+
+	n = strtol(spec, &end, 10);
+	if(end != spec && *end == '\0') {
+		if(n < 1 || n > MP_DELAY_QUEUE) {
+			return 0;
+		}
+		delay = n;
+	} else if(*spec != '\0') {
+		alt_host = spec;
+		delay = 0;
+	} else {
+		return 0;
+	}
+	enabled = 1;
+	return 1;
+}
+
+void mp_init() {
+	sem_init(&lock, 0, 1);
+	session = net_session();
+}
+
+int mp_start(unsigned short port) {
+	struct hostent *h;
+
+	if(!enabled || delay > 0) {
+		return 1;
+	}
+	if((h = gethostbyname(alt_host)) == NULL) {
+		log_dns_error(1, "mp: no such host \"%s\"", alt_host);
+		enabled = 0;
+		return 0;
+	}
+	memset(&alt, 0, sizeof(alt));
+	alt.sin_family = AF_INET;
+	memcpy(&alt.sin_addr.s_addr, h->h_addr_list[0], h->h_length);
+	alt.sin_port = htons(port);
+	return 1;
+}
+
+int mp_enabled() {
+	return enabled;
+}
+
+int mp_send(const robot_event *ev) {
+	robot_mp_frame f;
+	mp_late *l;
+	int ok;
+
+	sem_wait(&lock);
+	f.command = ROBOT_EVENT_NET_MULTIPATH;
+	f.seq = next_seq++;
+	f.session = session;
+	f.unused = 0;
+	f.ev = *ev;
+	ok = send_path(&f, 0);
+	if(delay == 0) {
+		ok |= send_path(&f, 1);
+	} else {
+		if(late_count == MP_DELAY_QUEUE) {
+			// rather early than not at all, and oldest first so no late
+			// copy is ever more than MP_DELAY_QUEUE behind
+			send_path(&late[late_head].f, 1);
+			late_head = (late_head + 1) % MP_DELAY_QUEUE;
+			late_count--;
+		}
+		l = &late[(late_head + late_count++) % MP_DELAY_QUEUE];
+		l->f = f;
+		l->due = now + delay;
+	}
+	sem_post(&lock);
+	return ok;
+}
+
+void mp_tick() {
+	mp_late *l;
+
+	sem_wait(&lock);
+	now++;
+	while(late_count > 0) {
+		l = &late[late_head];
+		if(now - l->due <= 0) { // at least delay whole ticks
+			break;
+		}
+		send_path(&l->f, 1);
+		late_head = (late_head + 1) % MP_DELAY_QUEUE;
+		late_count--;
+	}
+	sem_post(&lock);
+}
+
+int mp_receive(const robot_mp_frame *f, robot_event *ev) {
+	int slot = f->seq % MP_DEDUP;
+	short ahead;
+	int first;
+
+	if(f->path >= MP_PATHS) {
+		return 0;
+	}
+	sem_wait(&lock);
+	// the session could repeat across a restart, so a run of sequence
+	// numbers long past, which no late or reordered copy can be, is taken
+	// as one too
+	ahead = f->seq - top;
+	far_behind = (ahead <= -MP_DEDUP ? far_behind + 1 : 0);
+	if(f->session != in_session || far_behind >= MP_RESTART) {
+		reset(f->session);
+		top = f->seq - 1;
+		far_behind = 0;
+	}
+	note_path(f);
+
+	ahead = f->seq - top;
+	if(ahead <= -MP_DEDUP) {
+		first = 0;  // too old to tell, and stale anyway
+	} else if(seen_valid[slot] && seen[slot] == f->seq) {
+		first = 0;
+		count_behind[f->path]++;
+		behind_ms[f->path] += (unsigned short)(now_ms() - seen_ms[slot]);
+	} else {
+		first = 1;
+		seen[slot] = f->seq;
+		seen_valid[slot] = 1;
+		seen_ms[slot] = now_ms();
+		count_first[f->path]++;
+		if(ahead > 0) {
+			top = f->seq;
+		}
+	}
+	sem_post(&lock);
+
+	*ev = f->ev;
+	return first;
+}
+
+void mp_log_stats(int level) {
+	int p, lost;
+
+	if(!enabled && in_session < 0) {
+		return;
+	}
+	sem_wait(&lock);
+	for(p = 0; p < MP_PATHS; p++) {
+		if(count_sent[p]) {
+			log_string(level, "mp: path %d: %u sent", p, count_sent[p]);
+		}
+		if(count_received[p]) {
+			lost = count_lost[p] * 100 / (count_received[p] + count_lost[p]);
+			log_string(level, "mp: path %d: %u received, %u lost (%d%%), %u first, %u behind by %u ms on average",
+					p, count_received[p], count_lost[p], lost,
+					count_first[p], count_behind[p],
+					count_behind[p] ? behind_ms[p] / count_behind[p] : 0);
+		}
+		count_sent[p] = 0;
+		count_received[p] = 0;
+		count_lost[p] = 0;
+		count_first[p] = 0;
+		count_behind[p] = 0;
+		behind_ms[p] = 0;
+	}
+	sem_post(&lock);
+}
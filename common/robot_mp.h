@@ -0,0 +1,86 @@
+//    robot_mp.h - sends each event twice, over two paths
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// With multipath on, send_event wraps each event in a robot_mp_frame with a
+// sequence number and sends it twice: once as usual (path 0) and once more
+// (path 1), either to a second address of the other end, eg. its second
+// radio, or over the same route a few control ticks later. Either copy
+// getting through is enough, so a lost STOP costs nothing and nobody waits
+// on a resend.
+//
+// The receiver delivers the first copy of each sequence number and drops
+// the second. Since every event goes down both paths, a gap in the
+// sequence numbers one path delivers is a loss on that path, and the time
+// between the two copies arriving shows which path is faster.
+//
+// Frames on the reliable channel and telemetry aren't duplicated.
+
+#ifndef ROBOT_MP_H
+#define ROBOT_MP_H
+
+#include "events.h"
+
+#define MP_PATHS 2
+#define MP_DELAY_QUEUE 64       // copies waiting to go out late
+#define MP_DEDUP 256            // sequence numbers remembered for duplicates,
+                                // well over the MP_DELAY_QUEUE a late copy
+                                // can be behind
+#define MP_RESTART 8            // frames in a row too far behind to be late
+                                // copies, taken as the sender restarting
+
+typedef struct {
+	unsigned char command;  // ROBOT_EVENT_NET_MULTIPATH
+	unsigned char path;     // the path this copy took
+	unsigned short seq;     // the same on both copies
+	unsigned char session;  // picked at random by the sender on startup,
+	                        // see net_session
+	unsigned char unused;
+	robot_event ev;
+} robot_mp_frame;
+
+// mp_configure - turns multipath on from a "-m" command line argument: a
+// 	number of control ticks to send the second copy late by, or the host
+// 	name of the other end's second address
+// 	return - 0 if spec is invalid
+extern int mp_configure(const char *spec);
+
+// mp_init - sets up the sender and receiver, called by the network thread
+extern void mp_init();
+
+// mp_start - looks up the second address, if there is one, on port
+// 	return - 0 if it can't be found
+extern int mp_start(unsigned short port);
+
+// mp_enabled - whether send_event should go through mp_send
+extern int mp_enabled();
+
+// mp_send - sends ev down both paths
+// 	return - 0 if neither copy could be sent
+extern int mp_send(const robot_event *ev);
+
+// mp_tick - sends the late copies that are due, once per control tick
+extern void mp_tick();
+
+// mp_receive - takes a frame from the network thread
+// 	return - 1 with the event in ev if it is the first copy, 0 otherwise
+extern int mp_receive(const robot_mp_frame *f, robot_event *ev);
+
+// mp_log_stats - logs and resets the per path counts
+extern void mp_log_stats(int level);
+
+#endif //!ROBOT_MP_H
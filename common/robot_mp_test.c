@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "robot_mp.h"
+#include "robot_log.h"
+
+void test_first_copy();
+void test_late_copies();
+void test_far_behind();
+void test_restart();
+int deliver(int session, int path, int seq);
+int assert_equal(int expect, int given, char *msg);
+
+int main() {
+
+	mp_init();
+
+	printf("test_first_copy()\n");
+	test_first_copy();
+	printf("test_late_copies()\n");
+	test_late_copies();
+	printf("test_far_behind()\n");
+	test_far_behind();
+	printf("test_restart()\n");
+	test_restart();
+
+	printf("Yoohoo! no tests failed!\n");
+	return 0;
+}
+
+// Each session starts from its own byte so the tests don't see each other.
+
+void test_first_copy() {
+	assert_equal(1, deliver(1, 0, 0), "First copy not delivered.");
+	assert_equal(0, deliver(1, 1, 0), "Second copy delivered.");
+	assert_equal(1, deliver(1, 1, 1), "First copy on path 1 not delivered.");
+	assert_equal(0, deliver(1, 0, 1), "Second copy on path 0 delivered.");
+}
+
+// "-m <ticks>": a full delay queue of events goes out before the first
+// late copy does
+void test_late_copies() {
+	int i, n = 0;
+
+	for(i = 0; i < 100; i++) {
+		n += deliver(2, 0, i);
+	}
+	assert_equal(100, n, "Path 0 not all delivered.");
+	for(i = 0; i < 10; i++) {
+		n += deliver(2, 1, i);
+	}
+	assert_equal(100, n, "Late copies delivered again.");
+	assert_equal(0, deliver(2, 0, 50), "Reordered copy delivered again.");
+}
+
+// copies too old to check for are dropped, not taken as a restart
+void test_far_behind() {
+	int i, n = 0;
+
+	for(i = 0; i < MP_DEDUP * 2; i++) {
+		deliver(3, 0, i);
+	}
+	for(i = 0; i < MP_RESTART - 1; i++) {
+		n += deliver(3, 1, i);
+	}
+	assert_equal(0, n, "Stale copies delivered.");
+	assert_equal(1, deliver(3, 0, MP_DEDUP * 2), "Next event not delivered.");
+}
+
+// a restarted sender that drew the same session byte starts over
+// after MP_RESTART frames
+void test_restart() {
+	int i, n = 0;
+
+	for(i = 0; i < 1000; i++) {
+		deliver(4, 0, i);
+	}
+	for(i = 0; i < MP_RESTART - 1; i++) {
+		n += deliver(4, 0, i);
+	}
+	assert_equal(0, n, "Restart taken too soon.");
+	assert_equal(1, deliver(4, 0, MP_RESTART - 1), "Restart not taken.");
+	assert_equal(1, deliver(4, 0, MP_RESTART), "Restarted sender not delivered.");
+	assert_equal(0, deliver(4, 1, MP_RESTART), "Second copy delivered after restart.");
+}
+
+// deliver - passes a frame to mp_receive
+// 	return - 1 if it was delivered
+int deliver(int session, int path, int seq) {
+	robot_mp_frame f;
+	robot_event ev;
+
+	f.command = ROBOT_EVENT_NET_MULTIPATH;
+	f.path = path;
+	f.seq = seq;
+	f.session = session;
+	f.unused = 0;
+	f.ev.command = ROBOT_EVENT_MOTOR;
+	f.ev.index = 0;
+	f.ev.value = seq;
+	if(!mp_receive(&f, &ev)) {
+		return 0;
+	}
+	assert_equal(seq, ev.value, "Delivered the wrong event.");
+	return 1;
+}
+
+int assert_equal(int expect, int given, char *msg) {
+	if(expect != given) {
+		printf("%s\n", msg);
+		exit(1);
+	}
+	return 1;
+}
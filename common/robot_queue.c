@@ -41,6 +41,7 @@ static int inc_tail_index(robot_queue *q);
 static int inc_head_index(robot_queue *q);
 static int lock (robot_queue *q);
 static int unlock (robot_queue *q);
+static void wake (robot_queue *q);
 
 // robot_queue_create -- initiaizes a new queue
 void robot_queue_create(robot_queue *q) {
@@ -48,6 +49,7 @@ void robot_queue_create(robot_queue *q) {
 	q->tail_index = 0;
 	q->length = 0;
 	sem_init(&(q->lock), 0, 1);
+	sem_init(&(q->ready), 0, 0);
 }
 
 // robot_queue_destroy -- frees resources created associated with a queue
@@ -62,6 +64,7 @@ void robot_queue_destroy(robot_queue *q) {
 
 	if (lock(q)) {
 		sem_destroy(&(q->lock));
+		sem_destroy(&(q->ready));
 		// unblock signals
 		pthread_sigmask(SIG_UNBLOCK, &signal_mask, NULL);
 	}
@@ -101,6 +104,17 @@ static int unlock (robot_queue *q) {
 	}
 }
 
+// wake - lets a waiting robot_queue_wait_event go. The waiter looks at the
+// queue again each time it wakes, so one post is enough however many events
+// went in, and a spare one only costs it a look.
+static void wake (robot_queue *q) {
+	int posted;
+
+	if (sem_getvalue(&(q->ready), &posted) == 0 && posted <= 0) {
+		sem_post(&(q->ready));
+	}
+}
+
 // robot_queue_enqueue - adds an event to the back of the queue
 int robot_queue_enqueue(robot_queue *q, const robot_event *const ev) {
 	int tail_index, head_index, i;
@@ -114,6 +128,7 @@ int robot_queue_enqueue(robot_queue *q, const robot_event *const ev) {
 					if(q->array[i].command == ev->command && q->array[i].index == ev->index){
 						q->array[i].value = ev->value;
 						unlock(q);
+						wake(q);
 						return 1;
 					}
 					i++;
@@ -127,6 +142,7 @@ int robot_queue_enqueue(robot_queue *q, const robot_event *const ev) {
 
 		inc_tail_index(q);
 		unlock(q);
+		wake(q);
 		return 1;
 	} else {
 		return 0;
@@ -162,7 +178,7 @@ int robot_queue_poll_event(robot_queue *q, robot_event *ev) {
 // waits for an event to occur from the event queue and then returns the event.
 int robot_queue_wait_event(robot_queue *q, robot_event *ev) {
 	while(!robot_queue_poll_event(q, ev)) {
-		usleep(10000); // sleep for 10 microseconds
+		sem_wait(&(q->ready)); // until the next enqueue, or a signal
 	}
 
 	return 1;
@@ -30,6 +30,7 @@ typedef struct {
 	int tail_index;
 	int length;
     sem_t lock;
+    sem_t ready; // posted on enqueue, wakes robot_queue_wait_event
 } robot_queue;
 
 // robot_queue_create -- initiaizes a new queue
@@ -1,11 +1,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "robot_queue.h"
 
 void test_none();
 void test_one();
 void test_mid();
+void test_wake();
 void test_overflow();
 void test_wait();
 int assert_equal(int expect, int given, char *msg);
@@ -25,6 +28,8 @@ int main() {
 	test_one();
 	printf("test_mid()\n");
 	test_mid();
+	printf("test_wake()\n");
+	test_wake();
 	printf("test_overflow()\n");
 	test_overflow();
 	printf("test_wait()\n");
@@ -120,6 +125,27 @@ void test_overflow() {
 	robot_queue_destroy(&q);
 }
 
+void *enqueue_later(void *arg) {
+	usleep(50000);
+	robot_queue_enqueue((robot_queue *)arg, &ev[5]);
+	return 0;
+}
+
+void test_wake() {
+	robot_queue q;
+	robot_event temp_ev;
+	pthread_t tid;
+
+	robot_queue_create(&q);
+
+	assert_equal(0, pthread_create(&tid, NULL, enqueue_later, &q), "Thread create failed.");
+	assert_true(robot_queue_wait_event(&q, &temp_ev), "Wait event failed");
+	assert_equal(ev[5].command, temp_ev.command, "Dequeued item incorrect.");
+	pthread_join(tid, NULL);
+
+	robot_queue_destroy(&q);
+}
+
 void test_wait() {
 	robot_queue q;
 	robot_event temp_ev;
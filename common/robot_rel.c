@@ -0,0 +1,268 @@
+//    robot_rel.c - reliable, in order delivery of robot events
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <semaphore.h>
+#include "robot_comm.h"
+#include "robot_log.h"
+#include "robot_rel.h"
+#include "link.h"
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	robot_event ev;
+	int sent;       // tick it was last sent, -1 if it hasn't been
+	int acked;      // acknowledged out of order, waiting on an earlier one
+} rel_slot;
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+// The main loop sends and the network thread takes the acks, so all of it
+// is under lock.
+static sem_t lock;
+
+// sender
+static unsigned char session;
+static rel_slot out[REL_QUEUE];    // ring, oldest first
+static int out_head = 0;
+static int out_count = 0;
+static unsigned short out_base = 0; // sequence number of out[out_head]
+static int now = 0;                 // control ticks
+static int window = REL_WINDOW;     // frames allowed in flight
+
+// receiver
+static int in_session = -1;         // the sender's session, -1 before any
+static unsigned short in_next;      // next sequence number to deliver
+static robot_event in_buf[REL_WINDOW]; // out of order frames, by seq % REL_WINDOW
+static int in_have[REL_WINDOW];
+
+static unsigned int count_sent = 0;
+static unsigned int count_resent = 0;
+static unsigned int count_acked = 0;
+static unsigned int count_delivered = 0;
+static unsigned int count_duplicate = 0;
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// send_slot - sends the i'th queued frame, with the lock held
+static void send_slot(int i) {
+	robot_rel_frame f;
+	rel_slot *s = &out[(out_head + i) % REL_QUEUE];
+
+	f.command = ROBOT_EVENT_NET_REL_DATA;
+	f.session = session;
+	f.seq = out_base + i;
+	f.base = out_base;
+	f.ev = s->ev;
+	if(s->sent >= 0) {
+		count_resent++;
+	}
+	count_sent++;
+	s->sent = now;
+	send_frame(&f);
+}
+
+// send_window - sends the frames in the window that haven't been sent yet
+static void send_window() {
+	int i;
+
+	for(i = 0; i < out_count && i < window; i++) {
+		if(out[(out_head + i) % REL_QUEUE].sent < 0) {
+			send_slot(i);
+		}
+	}
+}
+
+// queue - adds an event to the back of the queue, with the lock held
+static int queue(const robot_event *ev) {
+	rel_slot *s;
+
+	if(out_count == REL_QUEUE) {
+		return 0;
+	}
+	s = &out[(out_head + out_count) % REL_QUEUE];
+	s->ev = *ev;
+	s->sent = -1;
+	s->acked = 0;
+	out_count++;
+	return 1;
+}
+
+static void receive_ack(const robot_rel_frame *f) {
+	unsigned short done = f->seq - out_base;
+	unsigned short seq;
+	int i, j;
+
+	if(f->session != session || done > out_count) {
+		return; // stale, or from before a restart
+	}
+	count_acked += done;
+	out_head = (out_head + done) % REL_QUEUE;
+	out_count -= done;
+	out_base = f->seq;
+
+	for(j = 0; j < REL_WINDOW - 1; j++) {
+		seq = f->seq + 1 + j;
+		i = (unsigned short)(seq - out_base);
+		if((f->ev.value & (1 << j)) && i < out_count) {
+			out[(out_head + i) % REL_QUEUE].acked = 1;
+		}
+	}
+	send_window();
+}
+
+static void receive_data(const robot_rel_frame *f, robot_queue *q) {
+	robot_rel_frame ack;
+	unsigned short ahead;
+	int slot, j;
+
+	// the sender never holds more than REL_QUEUE frames, so a base
+	// outside that is a restart, even if the session byte repeats
+	if(f->session != in_session ||
+			(unsigned short)(in_next - f->base) > REL_QUEUE) {
+		log_string(-1, "rel: new session %02X from sequence %d", f->session, f->base);
+		in_session = f->session;
+		in_next = f->base;
+		for(j = 0; j < REL_WINDOW; j++) {
+			in_have[j] = 0;
+		}
+	}
+
+	ahead = f->seq - in_next;
+	slot = f->seq % REL_WINDOW;
+	if(ahead >= REL_WINDOW || in_have[slot]) {
+		count_duplicate++; // already delivered, or acked and resent anyway
+	} else {
+		in_buf[slot] = f->ev;
+		in_have[slot] = 1;
+	}
+
+	while(in_have[in_next % REL_WINDOW]) {
+		in_have[in_next % REL_WINDOW] = 0;
+		robot_queue_enqueue(q, &in_buf[in_next % REL_WINDOW]);
+		count_delivered++;
+		in_next++;
+	}
+
+	ack.command = ROBOT_EVENT_NET_REL_ACK;
+	ack.session = f->session;
+	ack.seq = in_next;
+	ack.base = 0;
+	ack.ev.command = 0;
+	ack.ev.index = 0;
+	ack.ev.value = 0;
+	for(j = 0; j < REL_WINDOW - 1; j++) {
+		if(in_have[(unsigned short)(in_next + 1 + j) % REL_WINDOW]) {
+			ack.ev.value |= 1 << j;
+		}
+	}
+	send_frame(&ack);
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void rel_init() {
+	sem_init(&lock, 0, 1);
+	session = net_session();
+}
+
+int rel_send(const robot_event *ev) {
+	int ok;
+
+	sem_wait(&lock);
+	ok = queue(ev);
+	send_window();
+	sem_post(&lock);
+	if(!ok) {
+		log_string(0, "rel: queue full, dropped %02X:%02X", ev->command, ev->index);
+	}
+	return ok;
+}
+
+int rel_send_table(const robot_event *table, int n) {
+	int i;
+	int ok = 1;
+
+	sem_wait(&lock);
+	for(i = 0; i < n && ok; i++) {
+		ok = queue(&table[i]);
+	}
+	send_window();
+	sem_post(&lock);
+	if(!ok) {
+		log_string(0, "rel: queue full, dropped %d of %d", n - i + 1, n);
+	}
+	return ok;
+}
+
+int rel_pending() {
+	int n;
+
+	sem_wait(&lock);
+	n = out_count;
+	sem_post(&lock);
+	return n;
+}
+
+void rel_tick() {
+	rel_slot *s;
+	int i;
+
+	sem_wait(&lock);
+	now++;
+	// fewer in flight on a bad link, so a burst doesn't all get lost
+	window = REL_WINDOW / link_scale();
+	for(i = 0; i < out_count && i < window; i++) {
+		s = &out[(out_head + i) % REL_QUEUE];
+		if(!s->acked && (s->sent < 0 || now - s->sent >= REL_TIMEOUT_TICKS)) {
+			send_slot(i);
+		}
+	}
+	sem_post(&lock);
+}
+
+void rel_receive(const robot_rel_frame *f, robot_queue *q) {
+	sem_wait(&lock);
+	if(f->command == ROBOT_EVENT_NET_REL_ACK) {
+		receive_ack(f);
+	} else if(f->command == ROBOT_EVENT_NET_REL_DATA) {
+		receive_data(f, q);
+	}
+	sem_post(&lock);
+}
+
+void rel_log_stats(int level) {
+	sem_wait(&lock);
+	if(count_sent || count_delivered || count_duplicate) {
+		log_string(level, "rel: %u sent, %u resent, %u acked, %d pending; %u delivered, %u duplicate",
+				count_sent, count_resent, count_acked, out_count,
+				count_delivered, count_duplicate);
+	}
+	count_sent = 0;
+	count_resent = 0;
+	count_acked = 0;
+	count_delivered = 0;
+	count_duplicate = 0;
+	sem_post(&lock);
+}
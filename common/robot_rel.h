@@ -0,0 +1,75 @@
+//    robot_rel.h - reliable, in order delivery of robot events
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Most events are sent bare and a lost one is simply replaced by the next.
+// Parameter writes aren't repeated, so they go through rel_send instead,
+// which wraps them in a robot_rel_frame with a sequence number. The other
+// end acknowledges what it has and delivers the events to its queue in
+// order. Up to REL_WINDOW events are in flight at once and the rest wait
+// their turn; unacknowledged ones are resent every REL_TIMEOUT_TICKS. The
+// window shrinks by link_scale() when the link is bad, see link.h.
+//
+// An acknowledgement carries the next sequence number expected plus a bit
+// for each of the REL_WINDOW after it that has already arrived, so a
+// single loss only costs a resend of the one frame.
+
+#ifndef ROBOT_REL_H
+#define ROBOT_REL_H
+
+#include "robot_queue.h"
+#include "events.h"
+
+#define REL_WINDOW 16         // frames in flight, at most 16 (the ack bitmap)
+#define REL_QUEUE 64          // frames queued or in flight
+#define REL_TIMEOUT_TICKS 5   // control ticks before a frame is resent
+
+typedef struct {
+	unsigned char command;  // ROBOT_EVENT_NET_REL_DATA or _ACK
+	unsigned char session;  // picked at random by the sender on startup
+	unsigned short seq;     // data: this frame; ack: next expected
+	unsigned short base;    // data: oldest frame not yet acknowledged
+	robot_event ev;         // data: the event; ack: value is the bitmap
+} robot_rel_frame;
+
+// rel_init - sets up the sender and receiver, called by the network thread
+extern void rel_init();
+
+// rel_send - queues an event for reliable delivery and sends it if the
+// 	window allows
+// 	return - 0 if the queue is full
+extern int rel_send(const robot_event *ev);
+
+// rel_send_table - queues n events, eg. the parameters sent at startup,
+// 	filling the window straight away
+// 	return - 0 if they didn't all fit
+extern int rel_send_table(const robot_event *table, int n);
+
+// rel_pending - the number of events not yet acknowledged
+extern int rel_pending();
+
+// rel_tick - resends what has timed out, once per control tick
+extern void rel_tick();
+
+// rel_receive - handles a frame from the network thread, acknowledging
+// 	data and enqueuing the events that are now in order
+extern void rel_receive(const robot_rel_frame *f, robot_queue *q);
+
+// rel_log_stats - logs and resets the delivery statistics
+extern void rel_log_stats(int level);
+
+#endif //!ROBOT_REL_H
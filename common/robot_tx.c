@@ -0,0 +1,188 @@
+//    robot_tx.c - coalesces and paces the events sent to the robot
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "robot_comm.h"
+#include "robot_log.h"
+#include "timer.h"
+#include "link.h"
+#include "robot_jb.h"
+#include "robot_tx.h"
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	unsigned char command;
+	unsigned char index;
+	unsigned short value;   // latest value
+	unsigned short sent;    // value last sent
+	int pending;            // value is waiting for the next flush
+} tx_slot;
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static tx_slot slots[TX_SLOTS];
+static int num_slots = 0;
+static int ticks_per_flush = 1;  // 0 to send straight away
+static int ticks = 0;            // since the last flush
+static int flushes = 0;          // since every slot was last resent
+
+static unsigned int count_sent = 0;
+static unsigned int count_merged = 0;
+static unsigned int count_unchanged = 0;
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// is_held - whether only the latest value of an event matters
+static int is_held(const robot_event *ev) {
+	switch(ev->command & 0xF0) {
+		case ROBOT_EVENT_JOY_AXIS:
+		case ROBOT_EVENT_MOTOR:
+		case ROBOT_EVENT_SET_VAR:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static int send_now(robot_event *ev) {
+	count_sent++;
+	if(jb_stamping() && is_held(ev)) {
+		return jb_send(ev); // for the robot's playout buffer
+	}
+	return send_event(ev);
+}
+
+// send_slot - sends a held value, leaving it pending for the next flush
+// 	if that fails
+static void send_slot(tx_slot *s) {
+	robot_event ev;
+
+	ev.command = s->command;
+	ev.index = s->index;
+	ev.value = s->value;
+	if(!send_now(&ev)) {
+		s->pending = 1;
+		return;
+	}
+	s->sent = s->value;
+	s->pending = 0;
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void tx_set_rate(int hz) {
+	if(hz <= 0) {
+		ticks_per_flush = 0;
+		tx_flush();
+	} else if(hz >= TIMER_CONTROL_HZ) {
+		ticks_per_flush = 1;
+	} else {
+		ticks_per_flush = TIMER_CONTROL_HZ / hz;
+	}
+}
+
+int tx_send(robot_event *ev) {
+	int i;
+
+	if(ticks_per_flush == 0 || !is_held(ev)) {
+		tx_flush();
+		return send_now(ev);
+	}
+
+	for(i = 0; i < num_slots; i++) {
+		if(slots[i].command == ev->command && slots[i].index == ev->index) {
+			break;
+		}
+	}
+	if(i == num_slots) {
+		if(num_slots == TX_SLOTS) {
+			log_string(-1, "tx: no slot for %02X:%02X, sending it directly",
+					ev->command, ev->index);
+			return send_now(ev);
+		}
+		num_slots++;
+		slots[i].command = ev->command;
+		slots[i].index = ev->index;
+		slots[i].pending = 1;
+	} else if(slots[i].pending) {
+		count_merged++;
+	} else if(slots[i].sent == ev->value) {
+		count_unchanged++;
+		return 1;
+	} else {
+		slots[i].pending = 1;
+	}
+	slots[i].value = ev->value;
+	return 1;
+}
+
+void tx_flush() {
+	int i;
+
+	for(i = 0; i < num_slots; i++) {
+		if(slots[i].pending) {
+			send_slot(&slots[i]);
+		}
+	}
+}
+
+void tx_tick() {
+	int every; // control ticks between flushes
+	int i;
+
+	if(ticks_per_flush == 0) {
+		return;
+	}
+	// flush less often on a bad link, but not so rarely that the sticks lag
+	every = ticks_per_flush * link_scale();
+	if(every > TIMER_CONTROL_HZ / TX_MIN_HZ) {
+		every = ticks_per_flush > TIMER_CONTROL_HZ / TX_MIN_HZ ?
+				ticks_per_flush : TIMER_CONTROL_HZ / TX_MIN_HZ;
+	}
+	if(++ticks < every) {
+		return;
+	}
+	ticks = 0;
+
+	// a lost datagram would otherwise leave the robot on a stale value
+	// until the next change
+	if(++flushes >= TIMER_CONTROL_HZ / every / TX_REFRESH_HZ) {
+		flushes = 0;
+		for(i = 0; i < num_slots; i++) {
+			send_slot(&slots[i]);
+		}
+	} else {
+		tx_flush();
+	}
+}
+
+void tx_log_stats(int level) {
+	if(count_merged || count_unchanged) {
+		log_string(level, "tx: %u sent, %u merged, %u unchanged",
+				count_sent, count_merged, count_unchanged);
+	}
+	count_sent = 0;
+	count_merged = 0;
+	count_unchanged = 0;
+}
@@ -0,0 +1,59 @@
+//    robot_tx.h - coalesces and paces the events sent to the robot
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// The controller's handlers send through tx_send instead of send_event.
+// Axis, motor and variable events only keep the latest value for their
+// (command, index), which goes out at the next flush if it differs from
+// what was last sent. Commands, status codes and buttons flush what is
+// held and then go out straight away, so a discrete action is never
+// delayed and never overtakes the stick it was pressed with.
+//
+// With jb_set_stamping on, held values go out stamped with the time, see
+// robot_jb.h.
+//
+// Everything here runs on the main loop; it isn't thread safe.
+
+#ifndef ROBOT_TX_H
+#define ROBOT_TX_H
+
+#include "events.h"
+
+#define TX_SLOTS 64 // (command, index) pairs that can be held
+#define TX_REFRESH_HZ 1 // every held value is resent this often
+#define TX_MIN_HZ 10 // the slowest a bad link stretches the flushes to, see link.h
+
+// tx_set_rate - flushes hz times a second, off the control tick. 0 sends
+// 	everything as it comes, as before. Defaults to TIMER_CONTROL_HZ.
+extern void tx_set_rate(int hz);
+
+// tx_send - queues or sends an event, see above
+// 	return - 0 if it had to be sent and sending failed
+extern int tx_send(robot_event *ev);
+
+// tx_flush - sends the values that have changed since they were last sent
+extern void tx_flush();
+
+// tx_tick - flushes when it is time to, once per control tick. The rate is
+// 	divided by link_scale(), down to TX_MIN_HZ.
+extern void tx_tick();
+
+// tx_log_stats - logs how many events were sent, merged into a later value
+// 	and dropped as unchanged, then resets the counts
+extern void tx_log_stats(int level);
+
+#endif //!ROBOT_TX_H
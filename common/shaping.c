@@ -0,0 +1,189 @@
+//    shaping.c - per axis input shaping tables
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// shaping.c
+//
+// Deadband, expo and scaling curves are worked out once, in floating
+// point, into a 256 entry table per axis (the same idea as dvmaxlut in
+// robot/mklut.py, but built at startup so a profile file can change them).
+// Shaping an axis event is then a single lookup.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "robot_log.h"
+#include "shaping.h"
+
+//---------------------------------------------------------------------------//
+// Private Function Prototypes
+//
+static int parse_line(char *line, int *axis, shape_params *p);
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static unsigned char table[SHAPE_AXES][256];
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void shaping_init() {
+	int axis, i;
+
+	for(axis = 0; axis < SHAPE_AXES; axis++) {
+		for(i = 0; i < 256; i++) {
+			table[axis][i] = i;
+		}
+	}
+}
+
+void shaping_set(int axis, const shape_params *p) {
+	int i, x, out;
+	double mag, span, e;
+
+	if (axis < 0 || axis >= SHAPE_AXES) {
+		return;
+	}
+	e = p->expo / 100.0;
+	span = SHAPE_CENTER - p->deadband;
+	for(i = 0; i < 256; i++) {
+		x = i - SHAPE_CENTER;
+		if (abs(x) <= p->deadband || span <= 0) {
+			mag = 0;
+		} else {
+			// rescale what is left outside the deadband to 0..1 so the
+			// output doesn't jump at its edge
+			mag = (abs(x) - p->deadband) / span;
+			if (mag > 1) {
+				mag = 1;
+			}
+			mag = (1 - e) * mag + e * mag * mag * mag;
+		}
+		out = (int)(mag * SHAPE_CENTER * p->scale / 100.0 + 0.5);
+		if (x < 0) {
+			out = -out;
+		}
+		if (p->invert) {
+			out = -out;
+		}
+		out += SHAPE_CENTER;
+		if (out < p->min) {
+			out = p->min;
+		}
+		if (out > p->max) {
+			out = p->max;
+		}
+		if (out < 0) {
+			out = 0;
+		}
+		if (out > 255) {
+			out = 255;
+		}
+		table[axis][i] = out;
+	}
+}
+
+int shaping_load(const char *filename) {
+	FILE *f;
+	char line[256];
+	int lineno = 0;
+	int axis;
+	shape_params p;
+
+	f = fopen(filename, "r");
+	if (f == NULL) {
+		log_errno(2, "Cannot open shaping profile");
+		return 0;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		lineno++;
+		if (!parse_line(line, &axis, &p)) {
+			log_string(2, "%s:%d: bad shaping line", filename, lineno);
+			fclose(f);
+			return 0;
+		}
+		if (axis >= 0) {
+			shaping_set(axis, &p);
+			log_string(-1, "axis %d: deadband %d expo %d scale %d%s clamp %d-%d",
+					axis, p.deadband, p.expo, p.scale,
+					p.invert ? " inverted" : "", p.min, p.max);
+		}
+	}
+	fclose(f);
+	return 1;
+}
+
+unsigned char shaping_apply(int axis, unsigned char value) {
+	if (axis < 0 || axis >= SHAPE_AXES) {
+		return value;
+	}
+	return table[axis][value];
+}
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// parse_line - fills in axis and p from one profile line. Sets axis to -1
+// 	for blank and comment lines. Returns 0 if the line is malformed.
+static int parse_line(char *line, int *axis, shape_params *p) {
+	char *tok;
+	char key[32];
+	int value;
+
+	p->deadband = 0;
+	p->expo = 0;
+	p->scale = 100;
+	p->invert = 0;
+	p->min = 0;
+	p->max = 255;
+	*axis = -1;
+
+	tok = strtok(line, " \t\r\n");
+	if (tok == NULL || tok[0] == '#') {
+		return 1;
+	}
+	if (sscanf(tok, "%d", axis) != 1 || *axis < 0 || *axis >= SHAPE_AXES) {
+		return 0;
+	}
+	while ((tok = strtok(NULL, " \t\r\n")) != NULL) {
+		if (tok[0] == '#') {
+			break;
+		}
+		if (sscanf(tok, "%31[^=]=%d", key, &value) != 2) {
+			return 0;
+		}
+		if (strcmp(key, "deadband") == 0 && value >= 0 && value < SHAPE_CENTER) {
+			p->deadband = value;
+		} else if (strcmp(key, "expo") == 0 && value >= 0 && value <= 100) {
+			p->expo = value;
+		} else if (strcmp(key, "scale") == 0 && value >= 0 && value <= 100) {
+			p->scale = value;
+		} else if (strcmp(key, "invert") == 0) {
+			p->invert = value;
+		} else if (strcmp(key, "min") == 0 && value >= 0 && value <= 255) {
+			p->min = value;
+		} else if (strcmp(key, "max") == 0 && value >= 0 && value <= 255) {
+			p->max = value;
+		} else {
+			return 0;
+		}
+	}
+	return 1;
+}
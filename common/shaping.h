@@ -0,0 +1,50 @@
+//    shaping.h - per axis input shaping tables
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef SHAPING_H
+#define SHAPING_H
+
+#define SHAPE_AXES 16 // joystick axes that can be shaped
+#define SHAPE_CENTER 127
+
+typedef struct {
+	int deadband;   // counts either side of center that read as center
+	int expo;       // 0 is linear, 100 is a pure cubic curve
+	int scale;      // percent of full travel reached at the ends
+	int invert;     // non-zero to swap the ends
+	int min;        // clamp on the shaped value, 0-255
+	int max;
+} shape_params;
+
+// shaping_init - sets every axis to pass through unchanged
+extern void shaping_init();
+
+// shaping_set - builds the table for one axis
+extern void shaping_set(int axis, const shape_params *p);
+
+// shaping_load - reads a profile file. Each line gives an axis followed by
+// 	any of deadband=, expo=, scale=, invert=, min= and max=, eg.
+// 		3 deadband=4 expo=30 scale=80
+// 	Blank lines and lines starting with # are ignored. Returns 1 on
+// 	success, 0 if the file can't be read or a line doesn't parse.
+extern int shaping_load(const char *filename);
+
+// shaping_apply - shapes one axis reading (0-255, centred on 127)
+extern unsigned char shaping_apply(int axis, unsigned char value);
+
+#endif // !SHAPING_H
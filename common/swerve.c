@@ -0,0 +1,100 @@
+//    swerve.c - integer swerve drive kinematics
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// swerve.c
+//
+// Steering angles used to come from atan() in double precision on every
+// axis event. The Gumstix has no FPU, and neither do the cheaper laptops
+// running the controller very quickly, so the angle is now found with a
+// table of atan over one octant plus integer arithmetic.
+//
+#include <stdlib.h>
+#include "swerve.h"
+
+#define ATAN_STEPS 256 //atanlut covers ratios 0 to 1 in this many steps
+#define ATAN_FRAC 4    //fractional bits in atanlut
+
+// atanlut[i] = atan(i / 256) * 500 / PI in 1/16ths. Generated by mkatanlut.py
+static const short atanlut[257] = {
+       0,   10,   20,   30,   40,   50,   60,   70,   80,   89,
+      99,  109,  119,  129,  139,  149,  159,  169,  179,  189,
+     199,  208,  218,  228,  238,  248,  258,  268,  277,  287,
+     297,  307,  317,  326,  336,  346,  356,  366,  375,  385,
+     395,  404,  414,  424,  433,  443,  453,  462,  472,  482,
+     491,  501,  510,  520,  529,  539,  548,  558,  567,  577,
+     586,  596,  605,  614,  624,  633,  643,  652,  661,  670,
+     680,  689,  698,  707,  717,  726,  735,  744,  753,  762,
+     771,  780,  789,  798,  807,  816,  825,  834,  843,  852,
+     861,  870,  879,  887,  896,  905,  914,  922,  931,  940,
+     948,  957,  966,  974,  983,  991, 1000, 1008, 1017, 1025,
+    1033, 1042, 1050, 1059, 1067, 1075, 1083, 1092, 1100, 1108,
+    1116, 1124, 1132, 1141, 1149, 1157, 1165, 1173, 1181, 1189,
+    1197, 1204, 1212, 1220, 1228, 1236, 1244, 1251, 1259, 1267,
+    1274, 1282, 1290, 1297, 1305, 1312, 1320, 1327, 1335, 1342,
+    1350, 1357, 1364, 1372, 1379, 1386, 1394, 1401, 1408, 1415,
+    1422, 1430, 1437, 1444, 1451, 1458, 1465, 1472, 1479, 1486,
+    1493, 1500, 1506, 1513, 1520, 1527, 1534, 1540, 1547, 1554,
+    1561, 1567, 1574, 1580, 1587, 1594, 1600, 1607, 1613, 1619,
+    1626, 1632, 1639, 1645, 1651, 1658, 1664, 1670, 1676, 1683,
+    1689, 1695, 1701, 1707, 1713, 1719, 1725, 1732, 1738, 1743,
+    1749, 1755, 1761, 1767, 1773, 1779, 1785, 1791, 1796, 1802,
+    1808, 1813, 1819, 1825, 1830, 1836, 1842, 1847, 1853, 1858,
+    1864, 1869, 1875, 1880, 1886, 1891, 1897, 1902, 1907, 1913,
+    1918, 1923, 1928, 1934, 1939, 1944, 1949, 1954, 1960, 1965,
+    1970, 1975, 1980, 1985, 1990, 1995, 2000
+};
+
+// atan(small / large) in 1/16ths of a steering unit, 0 <= small <= large
+static int atan_octant(int small, int large) {
+	int idx = (small * ATAN_STEPS) / large;
+	int rem = (small * ATAN_STEPS) % large;
+
+	if (idx >= ATAN_STEPS) {
+		return atanlut[ATAN_STEPS];
+	}
+	return atanlut[idx] + ((atanlut[idx + 1] - atanlut[idx]) * rem) / large;
+}
+
+int swerve_strafe(int x, int y) {
+	int ax = abs(x), ay = abs(y);
+	int a, v;
+
+	if (x == 0) {
+		return (y <= 0) ? 0 : SWERVE_TURN / 2;
+	}
+
+	// atan(y / x), folded into the first octant
+	if (ay <= ax) {
+		a = atan_octant(ay, ax);
+	} else {
+		a = ((SWERVE_TURN / 4) << ATAN_FRAC) - atan_octant(ax, ay);
+	}
+	if ((x < 0) != (y < 0)) {
+		a = -a;
+	}
+
+	// left half is offset back by a quarter turn, right half forward
+	v = a + ((x < 0 ? -SWERVE_TURN / 4 : SWERVE_TURN / 4) << ATAN_FRAC);
+
+	// truncate toward zero like the (int) cast it replaces
+	return v >= 0 ? v >> ATAN_FRAC : -((-v) >> ATAN_FRAC);
+}
+
+int swerve_twist(int r) {
+	return (r * 200) / 127;
+}
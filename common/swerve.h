@@ -0,0 +1,33 @@
+//    swerve.h - integer swerve drive kinematics
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef SWERVE_H
+#define SWERVE_H
+
+#define SWERVE_TURN 1000 //Steering units in a full turn of a module
+
+// swerve_strafe - module direction for the stick position (x, y), both
+// 	centered on 0. x > 0 gives 0 to 500 and x < 0 gives -500 to 0, with
+// 	x = 0 giving 0 (y <= 0) or 500 (y > 0). Integer only, and within one
+// 	unit of the atan() version it replaces.
+extern int swerve_strafe(int x, int y);
+
+// swerve_twist - steering offset for the rotation axis r (-128 to 127)
+extern int swerve_twist(int r);
+
+#endif //!SWERVE_H
@@ -0,0 +1,207 @@
+//    telemetry.c - packed frames of robot state sent to the controller
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <semaphore.h>
+#include "events.h"
+#include "robot_log.h"
+#include "timebase.h"
+#include "telemetry.h"
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+// sender, only used by the robot's main loop
+static unsigned short sent[TELEMETRY_FIELDS];   // as the receiver has them
+static unsigned char next_seq = 0;
+
+// receiver, written by the network thread
+static sem_t lock;
+static unsigned short values[TELEMETRY_FIELDS];
+static char known[TELEMETRY_FIELDS];
+static int have_seq = 0;
+static unsigned char last_seq;
+static unsigned int stamp;          // of the latest frame
+static int stamp_synced = 0;
+
+static unsigned int count_frames = 0;
+static unsigned int count_bytes = 0;
+static unsigned int count_lost = 0;
+static unsigned int count_timed = 0; // frames with a one way latency
+static int latency_sum = 0;          // ms
+static int latency_max = 0;
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void telemetry_init() {
+	sem_init(&lock, 0, 1);
+}
+
+int telemetry_encode(const unsigned short *cur, int key, unsigned char *buf) {
+	int len = TELEMETRY_HEADER;
+	int n = 0;
+	int i, delta;
+	unsigned int now;
+
+	for(i = 0; i < TELEMETRY_FIELDS; i++) {
+		delta = (short)(cur[i] - sent[i]);
+		if(!key && delta == 0) {
+			continue;
+		}
+		if(!key && delta >= -128 && delta <= 127) {
+			buf[len++] = i | TELEMETRY_DELTA;
+			buf[len++] = (unsigned char)(signed char)delta;
+		} else {
+			buf[len++] = i;
+			buf[len++] = cur[i] & 0xFF;
+			buf[len++] = cur[i] >> 8;
+		}
+		sent[i] = cur[i];
+		n++;
+	}
+	if(n == 0) {
+		return 0; // four bytes would look like a robot_event anyway
+	}
+	now = timebase_now() / 1000;
+	buf[0] = ROBOT_EVENT_NET_TELEMETRY;
+	buf[1] = next_seq++;
+	buf[2] = (key ? TELEMETRY_KEYFRAME : 0) |
+			(timebase_synced() ? TELEMETRY_SYNCED : 0);
+	buf[3] = n;
+	buf[4] = now & 0xFF;
+	buf[5] = (now >> 8) & 0xFF;
+	buf[6] = (now >> 16) & 0xFF;
+	buf[7] = now >> 24;
+	return len;
+}
+
+void telemetry_receive(const unsigned char *buf, int len, long long arrived) {
+	int pos = TELEMETRY_HEADER;
+	int i, n, field, latency;
+	unsigned int now = timebase_common(arrived) / 1000;
+
+	if(len < TELEMETRY_HEADER) {
+		return;
+	}
+	sem_wait(&lock);
+	stamp = buf[4] | (buf[5] << 8) | (buf[6] << 16) | ((unsigned int)buf[7] << 24);
+	stamp_synced = (buf[2] & TELEMETRY_SYNCED) != 0;
+	if(stamp_synced) {
+		latency = now - stamp;
+		count_timed++;
+		latency_sum += latency;
+		if(latency > latency_max) {
+			latency_max = latency;
+		}
+	}
+	count_frames++;
+	count_bytes += len;
+	if(have_seq && buf[1] != (unsigned char)(last_seq + 1)) {
+		count_lost += (unsigned char)(buf[1] - last_seq - 1);
+		for(i = 0; i < TELEMETRY_FIELDS; i++) {
+			known[i] = 0;
+		}
+	}
+	have_seq = 1;
+	last_seq = buf[1];
+
+	n = buf[3];
+	for(i = 0; i < n && pos < len; i++) {
+		field = buf[pos] & ~TELEMETRY_DELTA;
+		if(buf[pos] & TELEMETRY_DELTA) {
+			if(pos + 1 >= len) {
+				break;
+			}
+			if(field < TELEMETRY_FIELDS && known[field]) {
+				values[field] += (signed char)buf[pos + 1];
+			}
+			pos += 2;
+		} else {
+			if(pos + 2 >= len) {
+				break;
+			}
+			if(field < TELEMETRY_FIELDS) {
+				values[field] = buf[pos + 1] | (buf[pos + 2] << 8);
+				known[field] = 1;
+			}
+			pos += 3;
+		}
+	}
+	sem_post(&lock);
+}
+
+int telemetry_get(int field, unsigned short *value) {
+	int ok;
+
+	if(field < 0 || field >= TELEMETRY_FIELDS) {
+		return 0;
+	}
+	sem_wait(&lock);
+	ok = known[field];
+	*value = values[field];
+	sem_post(&lock);
+	return ok;
+}
+
+int telemetry_time(unsigned int *ms) {
+	int synced;
+
+	sem_wait(&lock);
+	*ms = stamp;
+	synced = stamp_synced;
+	sem_post(&lock);
+	return synced;
+}
+
+void telemetry_log_stats(int level) {
+	unsigned short v[TELEMETRY_FIELDS];
+	unsigned int frames, bytes, lost, timed;
+	int i, sum, max;
+
+	sem_wait(&lock);
+	for(i = 0; i < TELEMETRY_FIELDS; i++) {
+		v[i] = known[i] ? values[i] : 0;
+	}
+	frames = count_frames;
+	bytes = count_bytes;
+	lost = count_lost;
+	timed = count_timed;
+	sum = latency_sum;
+	max = latency_max;
+	count_frames = count_bytes = count_lost = 0;
+	count_timed = latency_sum = latency_max = 0;
+	sem_post(&lock);
+
+	if(frames == 0) {
+		return;
+	}
+	log_string(level, "tlm: %u frames, %u bytes, %u lost", frames, bytes, lost);
+	if(timed) {
+		log_string(level, "tlm: one way latency %d ms on average, %d ms at most",
+				sum / (int)timed, max);
+	}
+	log_string(level, "tlm: motors %d %d %d %d %d %d %d %d, adc %d %d %d %d %d %d %d %d",
+			v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+			v[8], v[9], v[10], v[11], v[12], v[13], v[14], v[15]);
+	log_string(level, "tlm: vars %d %d %d %d %d %d %d %d, queue %d, i2c errors %d, loop max %d us, %d events",
+			(short)v[16], (short)v[17], (short)v[18], (short)v[19],
+			(short)v[20], (short)v[21], (short)v[22], (short)v[23],
+			v[TELEMETRY_QUEUE], v[TELEMETRY_I2C_ERRORS],
+			v[TELEMETRY_LOOP_MAX], v[TELEMETRY_EVENTS]);
+}
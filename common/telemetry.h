@@ -0,0 +1,83 @@
+//    telemetry.h - packed frames of robot state sent to the controller
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// A telemetry frame is a datagram of its own:
+//
+// 	byte 0  ROBOT_EVENT_NET_TELEMETRY
+// 	byte 1  sequence number
+// 	byte 2  TELEMETRY_KEYFRAME if every field follows, TELEMETRY_SYNCED
+// 	        if the robot's clock is in step with the controller's
+// 	byte 3  number of fields that follow
+// 	byte 4  when the frame was made, in ms on the controller's clock (see
+// 	        timebase.h), a little endian 32 bit number
+//
+// then per field its number, followed by either a little endian 16 bit
+// value, or, with TELEMETRY_DELTA set in the number, one signed byte to
+// add to the previous value. A keyframe goes out once a second; in
+// between, a frame only holds the fields that changed, and isn't sent at
+// all if none did. After a lost frame the receiver ignores deltas to a
+// field until it gets the field's value again.
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+enum {
+	TELEMETRY_MOTOR = 0,        // 8 motor outputs, as written to the robostix
+	TELEMETRY_ADC = 8,          // 8 ADC channels, as last reported
+	TELEMETRY_VAR = 16,         // 8 robostix variables chosen on the robot
+	TELEMETRY_QUEUE = 24,       // events waiting in the robot's queue
+	TELEMETRY_I2C_ERRORS = 25,  // failed bus transactions since startup
+	TELEMETRY_LOOP_MAX = 26,    // longest event handler since the last frame (us)
+	TELEMETRY_EVENTS = 27,      // events handled since the last frame
+	TELEMETRY_FIELDS = 28
+};
+#define TELEMETRY_VARS 8
+
+#define TELEMETRY_KEYFRAME 0x01
+#define TELEMETRY_SYNCED 0x02
+#define TELEMETRY_DELTA 0x80
+#define TELEMETRY_HEADER 8
+#define TELEMETRY_MAX_FRAME (TELEMETRY_HEADER + 3 * TELEMETRY_FIELDS)
+
+// telemetry_init - sets up the receiver, called by the network thread
+extern void telemetry_init();
+
+// telemetry_encode - packs a frame of the fields in cur, a keyframe if key
+// 	is set, against the values the last frame left the receiver with
+// 	return - the length of the frame, 0 if there is nothing to send
+extern int telemetry_encode(const unsigned short *cur, int key, unsigned char *buf);
+
+// telemetry_receive - unpacks a frame from the network thread, which got it
+// 	at local time arrived
+extern void telemetry_receive(const unsigned char *buf, int len, long long arrived);
+
+// telemetry_get - the latest value of a field
+// 	return - 0 if it isn't known
+extern int telemetry_get(int field, unsigned short *value);
+
+// telemetry_time - when the latest frame was made, in ms on the
+// 	controller's clock
+// 	return - 0 if the robot's clock wasn't in step
+extern int telemetry_time(unsigned int *ms);
+
+// telemetry_log_stats - logs the latest frame, the frames and bytes
+// 	received since the last call and how long they took to arrive, then
+// 	resets the counts
+extern void telemetry_log_stats(int level);
+
+#endif //!TELEMETRY_H
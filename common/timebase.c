@@ -0,0 +1,193 @@
+//    timebase.c - puts the robot's times on the controller's clock
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <time.h>
+#include <semaphore.h>
+#include "robot_log.h"
+#include "timebase.h"
+
+#define TIMEBASE_RESET_US 1000000 // an offset this far out means the other end restarted
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	long long offset;   // the other clock less ours
+	long long delay;    // round trip, less the other end's turnaround
+	long long at;       // when it was taken, on our clock
+} tb_sample;
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+// The network thread adds samples and anything may convert, so all of it
+// is under lock. log_string may ask for the time, so nothing logs with the
+// lock held.
+static sem_t lock;
+static int reference = 1;
+
+static tb_sample samples[TIMEBASE_SAMPLES];
+static int next_sample = 0;
+static int num_samples = 0;
+
+static int synced = 0;
+static tb_sample best;              // the sample converting by
+static long long drift_offset;      // offset the drift is measured from
+static long long drift_at;
+static int have_drift = 0;
+static int drift_ppm = 0;           // us a second the other clock gains on ours
+
+static unsigned int count_samples = 0;
+static unsigned int count_resets = 0;
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// predict - the offset at local time t, with the lock held
+static long long predict(long long t) {
+	return best.offset + drift_ppm * (t - best.at) / 1000000;
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void timebase_init(int is_reference) {
+	sem_init(&lock, 0, 1);
+	reference = is_reference;
+}
+
+long long timebase_local() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+long long timebase_common(long long local) {
+	long long t = local;
+
+	if(reference) {
+		return local;
+	}
+	sem_wait(&lock);
+	if(synced) {
+		t = local + predict(local);
+	}
+	sem_post(&lock);
+	return t;
+}
+
+long long timebase_now() {
+	return timebase_common(timebase_local());
+}
+
+int timebase_synced() {
+	int s;
+
+	if(reference) {
+		return 1;
+	}
+	sem_wait(&lock);
+	s = synced;
+	sem_post(&lock);
+	return s;
+}
+
+void timebase_sample(long long t1, long long t2, long long t3, long long t4) {
+	tb_sample s;
+	int i, reset = 0;
+
+	s.offset = ((t2 - t1) + (t3 - t4)) / 2;
+	s.delay = (t4 - t1) - (t3 - t2);
+	s.at = t4;
+
+	sem_wait(&lock);
+	count_samples++;
+	if(synced && (s.offset - predict(t4) > TIMEBASE_RESET_US ||
+			s.offset - predict(t4) < -TIMEBASE_RESET_US)) {
+		reset = 1;
+		count_resets++;
+		synced = 0;
+		have_drift = 0;
+		drift_ppm = 0;
+		num_samples = 0;
+		next_sample = 0;
+	}
+	samples[next_sample] = s;
+	next_sample = (next_sample + 1) % TIMEBASE_SAMPLES;
+	if(num_samples < TIMEBASE_SAMPLES) {
+		num_samples++;
+	}
+
+	// the least delayed exchange was the least lopsided
+	best = samples[0];
+	for(i = 1; i < num_samples; i++) {
+		if(samples[i].delay < best.delay) {
+			best = samples[i];
+		}
+	}
+	synced = 1;
+
+	if(!have_drift) {
+		have_drift = 1;
+		drift_offset = best.offset;
+		drift_at = best.at;
+	} else if(best.at - drift_at >= TIMEBASE_DRIFT_SECS * 1000000LL) {
+		i = (best.offset - drift_offset) * 1000000 / (best.at - drift_at);
+		drift_ppm = drift_ppm ? drift_ppm + (i - drift_ppm) / 4 : i;
+		drift_offset = best.offset;
+		drift_at = best.at;
+	}
+	sem_post(&lock);
+	if(reset) {
+		log_string(-1, "clock: offset jumped, starting over");
+	}
+}
+
+void timebase_stamp(long long us, robot_stamp *s) {
+	s->sec = us / 1000000;
+	s->usec = us % 1000000;
+}
+
+long long timebase_unstamp(const robot_stamp *s) {
+	return s->sec * 1000000LL + s->usec;
+}
+
+void timebase_log_stats(int level) {
+	long long offset, delay;
+	unsigned int exchanges, resets;
+	int was_synced, ppm;
+
+	sem_wait(&lock);
+	was_synced = synced;
+	offset = predict(timebase_local());
+	delay = best.delay;
+	ppm = drift_ppm;
+	exchanges = count_samples;
+	resets = count_resets;
+	count_samples = 0;
+	count_resets = 0;
+	sem_post(&lock);
+
+	if(was_synced) {
+		log_string(level, "clock: other end %+lld us, drift %d ppm, best round trip %lld us, %u exchanges, %u restarts",
+				offset, ppm, delay, exchanges, resets);
+	}
+}
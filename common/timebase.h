@@ -0,0 +1,73 @@
+//    timebase.h - puts the robot's times on the controller's clock
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// The controller's monotonic clock is the common timebase. Each link ping
+// (see link.h) is an NTP style exchange: the pinger's send time t1, the
+// other end's receive and reply times t2 and t3, and the pinger's receive
+// time t4 give the other clock's offset
+//
+// 	((t2 - t1) + (t3 - t4)) / 2
+//
+// which is exact when both directions take as long, so of the last
+// TIMEBASE_SAMPLES exchanges the one with the shortest round trip is used.
+// The drift between the clocks is measured across offsets at least
+// TIMEBASE_DRIFT_SECS apart, and the robot converts its times with both.
+// Times here are microseconds.
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#define TIMEBASE_SAMPLES 8      // exchanges the least delayed is picked from
+#define TIMEBASE_DRIFT_SECS 10  // how far apart offsets are to measure drift
+
+// A time on the wire, the same on every ABI unlike struct timeval
+typedef struct {
+	unsigned int sec;
+	unsigned int usec;
+} robot_stamp;
+
+// timebase_init - sets up the estimate, called by the network thread.
+// 	reference is set on the controller, whose clock is the common one.
+extern void timebase_init(int reference);
+
+// timebase_local - this machine's monotonic clock
+extern long long timebase_local();
+
+// timebase_common - a local time on the controller's clock
+extern long long timebase_common(long long local);
+
+// timebase_now - the time on the controller's clock
+extern long long timebase_now();
+
+// timebase_synced - whether timebase_common has an offset to go on;
+// 	always on the controller
+extern int timebase_synced();
+
+// timebase_sample - adds an exchange, t1 and t4 on this clock and t2 and
+// 	t3 on the other end's
+extern void timebase_sample(long long t1, long long t2, long long t3, long long t4);
+
+// timebase_stamp, timebase_unstamp - convert to and from the wire format
+extern void timebase_stamp(long long us, robot_stamp *s);
+extern long long timebase_unstamp(const robot_stamp *s);
+
+// timebase_log_stats - logs the other clock's offset, the drift and the
+// 	round trip of the exchange used
+extern void timebase_log_stats(int level);
+
+#endif //!TIMEBASE_H
@@ -20,6 +20,7 @@
 #include <semaphore.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <time.h>
 #include "timer.h"
 #include "events.h"
 #include "robot_queue.h"
@@ -33,6 +34,7 @@ static void *timer_thread_main(void *arg);
 // Private Globals
 //
 static pthread_t tid = -1; // Thread ID of the timer thread
+static int control_tick = 0; // queue TIMER index 3 events as well
 
 //---------------------------------------------------------------------------//
 // Public Function Implementations
@@ -47,6 +49,10 @@ int timer_thread_create(robot_queue *q) {
 
 }
 
+void timer_enable_control_tick() {
+	control_tick = 1;
+}
+
 int timer_thread_destroy() {
 	// kill the thread
 	if (pthread_cancel(tid) != 0) {
@@ -68,20 +74,39 @@ void *timer_thread_main(void *arg) {
 	robot_queue *q = (robot_queue*)arg;
 	robot_event ev1;
 	robot_event ev2;
+	robot_event ev3;
+	struct timespec next;
 	ev1.command = ROBOT_EVENT_TIMER;
 	ev1.index = 1;
 	ev1.value = 0;
 	ev2.command = ROBOT_EVENT_TIMER;
 	ev2.index = 2;
 	ev2.value = 0;
+	ev3.command = ROBOT_EVENT_TIMER;
+	ev3.index = 3;
+	ev3.value = 0;
 	int i;
+
+	// Sleep to absolute deadlines so time spent enqueueing doesn't add up.
+	// Every second is nine 10hz events followed by one 1hz event.
+	clock_gettime(CLOCK_MONOTONIC, &next);
 	while(1){
-		for(i = 0; i < 9; i++) {
-			robot_queue_enqueue(q, &ev1);
-			usleep(100000);
+		for(i = 0; i < TIMER_CONTROL_HZ; i++) {
+			if(control_tick) {
+				robot_queue_enqueue(q, &ev3);
+			}
+			if(i == TIMER_CONTROL_HZ - TIMER_CONTROL_HZ / 10) {
+				robot_queue_enqueue(q, &ev2);
+			} else if(i % (TIMER_CONTROL_HZ / 10) == 0) {
+				robot_queue_enqueue(q, &ev1);
+			}
+			next.tv_nsec += 1000000000 / TIMER_CONTROL_HZ;
+			if(next.tv_nsec >= 1000000000) {
+				next.tv_nsec -= 1000000000;
+				next.tv_sec++;
+			}
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
 		}
-		robot_queue_enqueue(q, &ev2);
 	}
 	return 0;
 }
-
@@ -27,5 +27,11 @@
 // Public Function Implementations
 //
 
+#define TIMER_CONTROL_HZ 50 // rate of the control tick (TIMER index 3)
+
 int timer_thread_create(robot_queue *q); 
 int timer_thread_destroy();
+
+// timer_enable_control_tick - also queue a TIMER index 3 event every
+// 	1/TIMER_CONTROL_HZ seconds. Call before timer_thread_create.
+void timer_enable_control_tick();
@@ -29,11 +29,23 @@
 #include "joystick.h"
 #include "events.h"
 #include "profile.h"
+#include "shaping.h"
+#include "joy_merge.h"
+#include "robot_tx.h"
+#include "robot_rel.h"
+#include "var_cache.h"
+#include "telemetry.h"
+#include "link.h"
+#include "robot_mp.h"
+#include "robot_jb.h"
+#include "timebase.h"
 
  
 
 static robot_queue *sig_queue;
 
+int drive_on_robot = 0; // -k, see drive.h
+
 void term_handler(int signal);
 void usage(char *program_name);
 
@@ -46,13 +58,14 @@ int main(int argc, char *argv[])
     bool shutdown = false;
 	
 	 int opt;
+	 char profile = 'p';
 
     // queue stuff
     robot_queue q;
     robot_event ev;
 	
-	 setProfile('p');
-	 while((opt = getopt(argc, argv, "j:n:p:v:")) != -1)
+	 shaping_init();
+	 while((opt = getopt(argc, argv, "c:d:j:J:kLm:n:p:r:sTv:")) != -1)
 		 switch (opt)
 		 {
 			 case 'n':
@@ -65,7 +78,41 @@ int main(int argc, char *argv[])
 				 log_level = atoi(optarg);
 			 	 break;
 			 case 'j':
-				 setProfile(optarg[0]);
+				 profile = optarg[0];
+				 break;
+			 case 'J':
+				 if(!joy_merge_configure(optarg)) {
+					 usage(argv[0]);
+					 exit(1);
+				 }
+				 break;
+			 case 'd':
+				 joy_set_device(optarg);
+				 break;
+			 case 'r':
+				 tx_set_rate(atoi(optarg));
+				 break;
+			 case 'k':
+				 drive_on_robot = 1;
+				 break;
+			 case 's':
+				 jb_set_stamping(1);
+				 break;
+			 case 'L':
+				 net_set_low_latency(1);
+				 break;
+			 case 'T':
+				 log_times = 1;
+				 break;
+			 case 'm':
+				 if(!mp_configure(optarg)) {
+					 usage(argv[0]);
+					 exit(1);
+				 }
+				 break;
+			 case 'c':
+				 if(!shaping_load(optarg))
+					 exit(1);
 				 break;
 			 case '?':
 				 usage(argv[0]);
@@ -77,6 +124,8 @@ int main(int argc, char *argv[])
 	 if(server_port == 0){
 		 server_port = 31337;
 	 }
+	 setProfile(profile);
+	 joy_merge_start(profile);
     robot_queue_create(&q);
     sig_queue = &q;
 
@@ -88,7 +137,11 @@ int main(int argc, char *argv[])
 	if(!net_thread_client_create(&q, server_name, server_port)) {
 		log_string(2, "Cannot create the network client thread");
 	}
+	if(!mp_start(server_port)) {
+		log_string(2, "Cannot find the second path, sending everything once");
+	}
 
+	timer_enable_control_tick();
 	if(!timer_thread_create(&q)) {
 		log_string(2, "cannot create the timer thread");
 	}
@@ -111,11 +164,18 @@ int main(int argc, char *argv[])
 	while(!shutdown) {
         if (!robot_queue_wait_event(&q, &ev))
             shutdown = true;
+        // the joystick events carry the device number, see joy_merge.h
+        if((ev.command & 0xF0) == ROBOT_EVENT_JOY_AXIS ||
+                (ev.command & 0xF0) == ROBOT_EVENT_JOY_BUTTON) {
+            if(!joy_merge(&ev))
+                continue;
+        }
         switch(ev.command) {
             case ROBOT_EVENT_CMD_START:
                 on_init();
                 break;
             case ROBOT_EVENT_JOY_AXIS:
+                ev.value = shaping_apply(ev.index, ev.value);
                 on_axis_change(&ev);
                 break;
             case ROBOT_EVENT_JOY_BUTTON:
@@ -131,15 +191,32 @@ int main(int argc, char *argv[])
             case ROBOT_EVENT_TIMER:
                  if(ev.index == 1) {
                      on_10hz_timer(&ev);
+                     link_tick();
                  }
                  if(ev.index == 2) {
                      on_1hz_timer(&ev);
+                     joy_log_stats(-1);
+                     tx_log_stats(-1);
+                     rel_log_stats(-1);
+                     telemetry_log_stats(-1);
+                     link_log_stats(-1);
+                     mp_log_stats(-1);
+                     timebase_log_stats(-1);
+                     net_log_stats(-1);
+                     var_cache_resubscribe();
+                 }
+                 if(ev.index == 3) {
+                     on_control_tick(&ev);
+                     tx_tick();
+                     rel_tick();
+                     mp_tick();
                  }
 		 break;
 	    case ROBOT_EVENT_ADC:
 		 on_adc_change(&ev);
 		 break;
 	    case ROBOT_EVENT_READ_VAR:
+		 var_cache_update(&ev);
 		 on_read_variable(&ev);
 		 break;
             default:
@@ -168,5 +245,5 @@ void term_handler(int signal) { // Signal handler
 
 
 void usage(char *program_name) {
-	log_string(3, "Usage: %s [-n host (192.168.1.100)] [-p port (31337)] [-v verbosity (0)]", program_name);
+	log_string(3, "Usage: %s [-n host (192.168.1.100)] [-p port (31337)] [-v verbosity (0)] [-j joystick profile (p)] [-d /dev/input/js0 or event device, instead of SDL] [-J device:profile[:drive|arm|all], per joystick] [-c shaping profile] [-k mix drive on the robot, run with this -j] [-r send rate in Hz (50), 0 for every change] [-m robot's second address, or control ticks to resend late by] [-s stamp sticks for the robot's -b] [-T time log lines] [-L low latency socket]", program_name);
 }
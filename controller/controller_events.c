@@ -14,6 +14,7 @@
 #include "robot_log.h"
 #include "joystick.h"
 #include "events.h"
+#include "robot_tx.h"
 #include "profile.h"
 
 int turbo = 0;
@@ -25,7 +26,7 @@ void on_init() {
     ev.value = 0;
 
 	log_string(-1, "Controller is initializing");
-	send_event(&ev);
+	tx_send(&ev);
 }
 
 void on_shutdown() {
@@ -35,19 +36,19 @@ void on_shutdown() {
     ev.value = 0;
 
 	log_string(-1, "Controller is shutting down");
-	send_event(&ev);
+	tx_send(&ev);
 }
 
 void on_button_up(robot_event *ev) {
 	if(ev->index == CON_TURBO1 || ev->index == CON_TURBO2)
 		turbo--;
-	send_event(ev);
+	tx_send(ev);
 }
 
 void on_button_down(robot_event *ev) {
 	if(ev->index == CON_TURBO1 || ev->index == CON_TURBO2)
 		turbo++;
-	send_event(ev);
+	tx_send(ev);
 }
 
 void on_axis_change(robot_event *ev) {
@@ -63,7 +64,7 @@ void on_axis_change(robot_event *ev) {
 	 if(value == 255) value = 254;
 	 if(value == 0) value = 1;
 	 
-	 send_event(ev);
+	 tx_send(ev);
     
 	 if(axis == CON_XAXIS || axis == CON_YAXIS || axis == CON_RAXIS) {
         if(axis == CON_YAXIS)
@@ -103,16 +104,16 @@ void on_axis_change(robot_event *ev) {
 		// send four axes out
         new_ev.command = ROBOT_EVENT_MOTOR;
         new_ev.index = 0; new_ev.value = mot1 + 127;
-		send_event(&new_ev);
+		tx_send(&new_ev);
 
         new_ev.index = 1; new_ev.value = mot2 + 127;
-		send_event(&new_ev);
+		tx_send(&new_ev);
 
         new_ev.index = 2; new_ev.value = mot3 + 127;
-		send_event(&new_ev);
+		tx_send(&new_ev);
 
         new_ev.index = 3; new_ev.value = mot4 + 127;
-		send_event(&new_ev);
+		tx_send(&new_ev);
 	}
 }
 
@@ -126,7 +127,10 @@ void on_10hz_timer(robot_event *ev) {
 	 ev1.command = ROBOT_EVENT_CMD_NOOP;
 	 ev1.index = 0;
 	 ev1.value = 0;
-	 send_event(&ev1);
+	 tx_send(&ev1);
+}
+
+void on_control_tick(robot_event *ev) {
 }
 
 
@@ -164,7 +168,7 @@ void on_command_code(robot_event *ev) {
             send_ev.index = 0;
             send_ev.value = 0;
 
-            send_event(&send_ev);
+            tx_send(&send_ev);
 			break;
 
 		case ROBOT_EVENT_CMD_START:
@@ -6,9 +6,6 @@
 // when the joystick state changes. Or when the program starts and shuts
 // down. See common/events.h for more complete information.
 //
-#define PI 3.1415926535897932384626433832
-
-#include <math.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,9 +13,20 @@
 #include "robot_log.h"
 #include "joystick.h"
 #include "events.h"
+#include "robot_tx.h"
 #include "profile.h"
+#include "drive.h"
+
+static mixer drive;
+
+static void send_kinematics() {
+	robot_event ev;
+	ev.command = ROBOT_EVENT_CMD_KINEMATICS;
+	ev.index = 0;
+	ev.value = drive_on_robot;
+	tx_send(&ev);
+}
 
-int turbo = 0;
 
 void on_init() {
     robot_event ev;
@@ -26,8 +34,12 @@ void on_init() {
     ev.index = 0;
     ev.value = 0;
 
+	drive_setup(&drive);
+	drive.sink = tx_send;
+
 	log_string(-1, "Controller is initializing");
-	send_event(&ev);
+	tx_send(&ev);
+	send_kinematics();
 }
 
 void on_shutdown() {
@@ -37,126 +49,44 @@ void on_shutdown() {
     ev.value = 0;
 
 	log_string(-1, "Controller is shutting down");
-	send_event(&ev);
+	tx_send(&ev);
 }
 
 void on_button_up(robot_event *ev) {
-	if(ev->index == CON_TURBO1 || ev->index == CON_TURBO2)
-		turbo--;
-	send_event(ev);
+	drive_button(&drive, ev);
+	tx_send(ev);
 }
 
 int shoot = 0;
 void on_button_down(robot_event *ev) {
-	if(ev->index == CON_TURBO1 || ev->index == CON_TURBO2)
-		turbo++;
+	drive_button(&drive, ev);
 
     if(ev->index == 0x00){
         shoot = 1 - shoot;
 	    robot_event new_ev;
 	    new_ev.command = ROBOT_EVENT_MOTOR;
         new_ev.index = 4; new_ev.value = (shoot ? 255 : 127);
-		send_event(&new_ev);
+		tx_send(&new_ev);
     }
-	send_event(ev);
+	tx_send(ev);
 }
 
 void on_axis_change(robot_event *ev) {
-    
-	 static int front = 0, rear = 0, lastfront = 0, lastrear = 0; //Motor and Steering values
-	 static unsigned char xAxis = 127, yAxis = 127, rAxis = 127; //x (lateral) y(forward) and r (rotational) axis values
-	 static int xNew = 0, yNew = 0, rNew =0, throttle = 0, strafe = 0; // 0 centered axis values
-     static int frontswap, rearswap, tempfront, temprear;
-
-	 robot_event new_ev;
-    unsigned char axis = ev->index;
-    unsigned char value = ev->value;
-	 if(value == 255) value = 254;
-	 if(value == 0) value = 1;
-	 send_event(ev);
-    
-	 if(axis == CON_XAXIS || axis == CON_YAXIS || axis == CON_RAXIS || axis == CON_ZAXIS) {
-        if(axis == CON_ZAXIS)
-            yAxis = value;
-        if(axis == CON_RAXIS)
-            xAxis = value;
-        if(axis == CON_XAXIS)
-            rAxis = 255 - value;
-	    if(axis == CON_YAXIS)
-	        throttle = 255 - value;
-        xNew = (int)xAxis - 128;
-        yNew = (int)yAxis - 128;
-        rNew = (int)rAxis - 128;
-        rNew = (turbo == 0 ? rNew : rNew >> 1);
-
-	    if(xNew < 0)
-	    	strafe = (int)(((double)250*(double)atan((double)yNew/(double)xNew)/((double).5*(double)PI))-250); //Left side.
-	    else if (xNew > 0)
-		    strafe = (int)(((double)(250)*(double)atan((double)yNew/(double)xNew)/((double).5*(double)PI))+250); // Right Side.
-	    else if (yNew <= 0)
-		    strafe = 0;
-	    else if (yNew > 0)
-		    strafe = 500;
-	
-	front = strafe - (int)(rNew*200.0/127.0);
-	rear = strafe + (int)(rNew*200.0/127.0);
-	if(front > 999)
-		front -= 1000;
-	if(front < 0)
-		front += 1000;
-	if(rear > 999)
-		rear -= 1000;
-	if(rear < 0)
-		rear += 1000;
-    if(throttle < 137 && throttle > 117){
-        tempfront = (front > 500 ? front - 500 : front + 500);
-        temprear = (rear > 500 ? rear - 500 : rear + 500);
-        if(abs(lastfront - front) < abs(lastfront - tempfront)){
-            frontswap = 0;
-        } else {
-            frontswap = 1;
-            front = tempfront;
-        }
-        if(abs(lastrear - rear) < abs(lastrear - temprear)){
-            rearswap = 0;
-        } else {
-            rearswap = 1;
-            rear = temprear;
-        }
-    } else {
-        if(frontswap == 1)
-            front = (front > 500 ? front - 500 : front + 500);
-        if(rearswap == 1)
-            rear = (rear > 500 ? rear - 500 : rear + 500);
-    }
-        int frontdrive = (frontswap == 0 ? throttle : 255 - throttle);
-        int reardrive = (rearswap == 0 ? 255 - throttle : throttle);
-	new_ev.command = ROBOT_EVENT_MOTOR;
-        
-        new_ev.index = 0; new_ev.value = frontdrive;
-		send_event(&new_ev);
-
-        new_ev.index = 1; new_ev.value = (((frontdrive-127)*turbo)/2)+127;
-		send_event(&new_ev);
-
-        new_ev.index = 2; new_ev.value = reardrive;
-		send_event(&new_ev);
-        
-        new_ev.index = 3; new_ev.value = (((reardrive-127)*turbo)/2)+127;
-		send_event(&new_ev);
-        
-        lastfront = front;
-        new_ev.index = 6; new_ev.value = front;
-        send_event(&new_ev);
-
-        lastrear = rear;
-        new_ev.index = 7; new_ev.value = rear;
-		send_event(&new_ev);
-	 }
+	 tx_send(ev);
+	 mixer_axis(&drive, ev);
 }
 
-void on_1hz_timer(robot_event *ev) {
+void on_control_tick(robot_event *ev) {
+	if(!drive_on_robot)
+		drive_tick(&drive);
+}
 
+void on_1hz_timer(robot_event *ev) {
+	// keep the robot's copy of the sticks fresh, as for roslund
+	if(drive_on_robot) {
+		send_kinematics();
+		mixer_send_axes(&drive);
+	}
 }
 
 
@@ -165,7 +95,7 @@ void on_10hz_timer(robot_event *ev) {
 	 ev1.command = ROBOT_EVENT_CMD_NOOP;
 	 ev1.index = 0;
 	 ev1.value = 0;
-	 send_event(&ev1);
+	 tx_send(&ev1);
 }
 
 
@@ -203,7 +133,7 @@ void on_command_code(robot_event *ev) {
             send_ev.index = 0;
             send_ev.value = 0;
 
-            send_event(&send_ev);
+            tx_send(&send_ev);
 			break;
 
 		case ROBOT_EVENT_CMD_START:
@@ -10,12 +10,15 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
 #include "robot_comm.h"
 #include "robot_log.h"
 #include "joystick.h"
 #include "events.h"
+#include "robot_tx.h"
+#include "robot_rel.h"
+#include "var_cache.h"
 #include "profile.h"
+#include "mixer.h"
 
 #define CTRL_DIRECT_DRIVE 0x01
 #define CTRL_DIRECT_ANGLE 0x02
@@ -51,39 +54,92 @@
 #define TURN_TURBO		6
 #define TURN_SUPER		1
 
+#define PRESET_NORMAL		0
+#define PRESET_TURBO		1
+#define PRESET_SUPER		2
+#define PRESET_DRIVE_SUPER	3 // full drive, normal turning
+
+#define IN_X 0
+#define IN_Y 1
+
+// Differential drive: +Y drives forward, +X turns right. The right side
+// motor is mounted backwards.
+static const int drive_matrix[2][2] = {
+	{ MIXER_ONE * M1POLARITY,  MIXER_ONE * M1POLARITY },
+	{ -MIXER_ONE * M2POLARITY, MIXER_ONE * M2POLARITY },
+};
+
+static const int angle_matrix[2][2] = {
+	{ 0,         MIXER_ONE },
+	{ MIXER_ONE, 0         },
+};
+
+static const int preset_scale[4][2] = { // drive, turn divisors
+	{ DRIVE_NORMAL, TURN_NORMAL },
+	{ DRIVE_TURBO,  TURN_TURBO  },
+	{ DRIVE_SUPER,  TURN_SUPER  },
+	{ DRIVE_SUPER,  TURN_NORMAL },
+};
+
+static mixer drive;
 unsigned char ctrl_mode = CTRL_DIRECT_DRIVE;
-int xin = 0;
-int yin = 0;
-int drive_scale = DRIVE_NORMAL;
-int turn_scale = TURN_NORMAL;
 int turbo = 0;
 int superboost = 0;
+int driveboost = 0;
+
+static void select_preset() {
+	if(turbo && superboost)
+		mixer_select_preset(&drive, PRESET_SUPER);
+	else if(turbo)
+		mixer_select_preset(&drive, PRESET_TURBO);
+	else if(driveboost)
+		mixer_select_preset(&drive, PRESET_DRIVE_SUPER);
+	else
+		mixer_select_preset(&drive, PRESET_NORMAL);
+}
 
 void on_init() {
+	robot_event params[] = {
+		{ ROBOT_EVENT_SET_VAR, KPROP, KPROP_VALUE },
+		{ ROBOT_EVENT_SET_VAR, KRATE, KRATE_VALUE },
+		{ ROBOT_EVENT_SET_VAR, KINT, KINT_VALUE },
+		{ ROBOT_EVENT_SET_VAR, DRIVE_MODE, 0 },
+	};
 	robot_event ev;
+	int p;
 	ev.command = ROBOT_EVENT_CMD_START;
 	ev.index = 0;
 	ev.value = 0;
 
-	log_string(-1, "Controller is initializing");
-	send_event(&ev);
-
-	ev.command = ROBOT_EVENT_SET_VAR;
-	ev.index = KPROP;
-	ev.value = KPROP_VALUE;
-	send_event(&ev);
-
-	ev.index = KRATE;
-	ev.value = KRATE_VALUE;
-	send_event(&ev);
+	mixer_init(&drive, 2, 2);
+	drive.sink = tx_send;
+	mixer_map_input(&drive, IN_X, 2, 0);
+	mixer_map_input(&drive, IN_Y, 3, 0);
+	// Deadband scaled from 6 at full y, 3 at center
+	drive.in[IN_X].deadband = 3;
+	drive.in[IN_X].db_ref = IN_Y;
+	drive.in[IN_X].db_div = 32;
+	for(p = 0; p < 4; p++) {
+		drive.preset[p].in_scale[IN_Y] = MIXER_ONE / preset_scale[p][0];
+		drive.preset[p].in_scale[IN_X] = MIXER_ONE / preset_scale[p][1];
+	}
+	if(ctrl_mode == CTRL_DIRECT_ANGLE) {
+		mixer_set_matrix(&drive, &angle_matrix[0][0]);
+		mixer_map_output(&drive, 0, ROBOT_EVENT_SET_VAR, TARGET_ANGLE, 0, -120, 120);
+		mixer_map_output(&drive, 1, ROBOT_EVENT_SET_VAR, TARGET_TURN_DIFF, 0, -127, 127);
+	} else {
+		mixer_set_matrix(&drive, &drive_matrix[0][0]);
+		mixer_map_output(&drive, 0, ROBOT_EVENT_MOTOR, 0, 128, -MAX - 1, MAX - 1);
+		mixer_map_output(&drive, 1, ROBOT_EVENT_MOTOR, 1, 128, -MAX - 1, MAX - 1);
+	}
 
-	ev.index = KINT;
-	ev.value = KINT_VALUE;
-	send_event(&ev);
+	log_string(-1, "Controller is initializing");
+	tx_send(&ev);
 
-	ev.index = DRIVE_MODE;
-	ev.value = ctrl_mode;
-	send_event(&ev);
+	// the balancing loop runs on these, so they go reliably, in order
+	params[3].value = ctrl_mode;
+	rel_send_table(params, 4);
+	var_subscribe(DRIVE_MODE, 1, 1);
 }
 
 void on_shutdown() {
@@ -93,135 +149,49 @@ void on_shutdown() {
 	ev.value = 0;
 
 	log_string(-1, "Controller is shutting down");
-	send_event(&ev);
+	tx_send(&ev);
 }
 
 void on_button_up(robot_event *ev) {
 	if(ev->index == 5){
 		turbo = 0;
-		drive_scale = DRIVE_NORMAL;
-		turn_scale = TURN_NORMAL;
 	} else if (ev->index == 7) {
 		superboost = 0;
-		if(turbo){
-			drive_scale = DRIVE_TURBO;
-			turn_scale = TURN_TURBO;
-		}
 	} else if (ev->index == 4) {
-		drive_scale = DRIVE_NORMAL;
-		turn_scale = TURN_NORMAL;
+		driveboost = 0;
 	}
-	send_event(ev);
+	select_preset();
+	tx_send(ev);
 }
 
 void on_button_down(robot_event *ev) {
 	if(ev->index == 5){
 		turbo = 1;
-		if(superboost){
-			drive_scale = DRIVE_SUPER;
-			turn_scale = TURN_SUPER;
-		} else {
-			drive_scale = DRIVE_TURBO;
-			turn_scale = TURN_TURBO;
-		}
 	} else if (ev->index == 7){
 		superboost = 1;
-		if(turbo){
-			drive_scale = DRIVE_SUPER;
-			turn_scale = TURN_SUPER;
-		}
 	} else if (ev->index == 4) {
-		drive_scale = DRIVE_SUPER;
-		turn_scale = TURN_NORMAL;
+		driveboost = 1;
 	} else {
-		send_event(ev);
+		tx_send(ev);
 	}
+	select_preset();
 }
 
 void on_axis_change(robot_event *ev) {
-	/* +Y (up) move forward
-	 * -Y (down) move backward
-	 * -X (left) decrease left power, turn left
-	 * +X (right) decrease right power, turn right
-	 */
-
-	int mot1 = 0;
-	int mot2 = 0;
-	
-	robot_event new_ev;
-	unsigned char axis = ev->index;
-	unsigned char value = ev->value;
-	if(ctrl_mode == CTRL_DIRECT_DRIVE){
-		if(axis == 3 || axis == 2){
-
-			if(axis == 3){
-				yin = (int)value - 127;
-				yin = ((float)yin / drive_scale);
-			} else {
-				xin = (int)value - 127;
-				if(abs(xin) < (int)((float) abs(yin) / 32.0) + 3){ // Deadband scaled from 6 at full y, 3 at center
-					xin = 0; 
-				} else {
-					xin = ((float)xin / turn_scale);
-				}
-			}
-
-			mot1 = yin + xin;
-			mot2 = yin - xin;
-
-			mot1 *= M1POLARITY;
-			mot2 *= M2POLARITY;
-			
-			mot1 += 128;
-			mot2 += 128;
-
-			if(mot1 > 127 + MAX) mot1 = 127 + MAX;
-			if(mot1 < 127 - MAX) mot1 = 127 - MAX;
-			if(mot2 > 127 + MAX) mot2 = 127 + MAX;
-			if(mot2 < 127 - MAX) mot2 = 127 - MAX;
-
-			new_ev.command = ROBOT_EVENT_MOTOR;
-
-			new_ev.index = 0;
-			new_ev.value = mot1;
-			send_event(&new_ev);
-
-			new_ev.index = 1;
-			new_ev.value = mot2;
-			send_event(&new_ev);
-		}
-	} else if (ctrl_mode == CTRL_DIRECT_ANGLE){
-		if(axis == 3 || axis == 2){
-			if(axis == 3){
-				yin = (int)value - 127;
-				yin = ((float)yin / drive_scale);
-			} else if (axis == CON_XAXIS){
-				xin = (int)value - 127;
-				if(abs(xin) < (int)((float) abs(yin) / 32) + 3){ // Deadband scaled from 6 at full y, 3 at center
-					xin = 0; 
-				} else {
-					xin = ((float)xin / turn_scale);
-				}
-			}
-
-			if (yin > 120) yin = 120;
-			if (yin < -120) yin = -120;
-
-			new_ev.command = ROBOT_EVENT_SET_VAR;
-
-			new_ev.index = TARGET_ANGLE;
-			new_ev.value = yin;
-			send_event(&new_ev);
-
-			new_ev.index = TARGET_TURN_DIFF;
-			new_ev.value = xin;
-			send_event(&new_ev);
-		}
-	}
+	mixer_axis(&drive, ev);
+}
 
+void on_control_tick(robot_event *ev) {
+	mixer_tick(&drive);
 }
 
 void on_1hz_timer(robot_event *ev) {
+	short mode;
+
+	// the robostix keeps its mode across a controller restart, and a
+	// reset of the robostix loses it
+	if(var_get(DRIVE_MODE, &mode) && mode != ctrl_mode && rel_pending() == 0)
+		log_string(0, "Robostix is in drive mode %d, expected %d", mode, ctrl_mode);
 }
 
 
@@ -230,7 +200,7 @@ void on_10hz_timer(robot_event *ev) {
 	ev1.command = ROBOT_EVENT_CMD_NOOP;
 	ev1.index = 0;
 	ev1.value = 0;
-	send_event(&ev1);
+	tx_send(&ev1);
 }
 
 
@@ -272,7 +242,7 @@ void on_command_code(robot_event *ev) {
 			send_ev.index = 0;
 			send_ev.value = 0;
 
-			send_event(&send_ev);
+			tx_send(&send_ev);
 			break;
 
 		case ROBOT_EVENT_CMD_START:
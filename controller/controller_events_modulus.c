@@ -14,16 +14,39 @@
 #include "robot_log.h"
 #include "joystick.h"
 #include "events.h"
+#include "robot_tx.h"
 #include "profile.h"
+#include "mixer.h"
+
+// Axes 0, 1, 3 and 4 drive the motors with the same numbers directly
+static const int drive_axes[4] = { 0, 1, 3, 4 };
+static const int drive_matrix[4][4] = {
+	{ MIXER_ONE, 0, 0, 0 },
+	{ 0, MIXER_ONE, 0, 0 },
+	{ 0, 0, MIXER_ONE, 0 },
+	{ 0, 0, 0, MIXER_ONE },
+};
+
+static mixer drive;
 
 void on_init() {
     robot_event ev;
+    int i;
     ev.command = ROBOT_EVENT_CMD_START;
     ev.index = 0;
     ev.value = 0;
 
+	mixer_init(&drive, 4, 4);
+	drive.sink = tx_send;
+	for(i = 0; i < 4; i++) {
+		mixer_map_input(&drive, i, drive_axes[i], 0);
+		mixer_map_output(&drive, i, ROBOT_EVENT_MOTOR, drive_axes[i],
+				MIXER_CENTER, -MIXER_CENTER, 255 - MIXER_CENTER);
+	}
+	mixer_set_matrix(&drive, &drive_matrix[0][0]);
+
 	log_string(-1, "Controller is initializing");
-	send_event(&ev);
+	tx_send(&ev);
 }
 
 void on_shutdown() {
@@ -33,58 +56,33 @@ void on_shutdown() {
     ev.value = 0;
 
 	log_string(-1, "Controller is shutting down");
-	send_event(&ev);
+	tx_send(&ev);
 }
 
 void on_button_up(robot_event *ev) {
     if(ev->index > -1 || ev->index <6){
-	send_event(ev);
+	tx_send(ev);
         printf("Button %i DOWN \n", ev->index);
     }
 }
 
 void on_button_down(robot_event *ev) {
     if(ev->index > -1 || ev->index < 6){
-	send_event(ev);
+	tx_send(ev);
 	printf("Button %i UP \n", ev->index);
     }
 }
 
 void on_axis_change(robot_event *ev) {
-    if(ev->index == 0){
-        robot_event new_ev;
-        new_ev.command = ROBOT_EVENT_MOTOR;
-        new_ev.index = 0; 
-        new_ev.value = ev->value;
-        send_event(&new_ev);
-        printf("I MOVED Axis %i to %i \n",ev->index, ev->value);
-    }
-    if(ev->index == 1){
-        robot_event new_ev;
-        new_ev.command = ROBOT_EVENT_MOTOR;
-        new_ev.index = 1; 
-        new_ev.value = ev->value;
-        send_event(&new_ev);
-        printf("I MOVED Axis %i to %i \n",ev->index, ev->value);
-    }
-    if(ev->index == 3){
-        robot_event new_ev;
-        new_ev.command = ROBOT_EVENT_MOTOR;
-        new_ev.index = 3; 
-        new_ev.value = ev->value;
-        send_event(&new_ev);
-        printf("I MOVED Axis %i to %i \n",ev->index, ev->value);
-    }
-    if(ev->index == 4){
-        robot_event new_ev;
-        new_ev.command = ROBOT_EVENT_MOTOR;
-        new_ev.index = 4; 
-        new_ev.value = ev->value;
-        send_event(&new_ev);
+    if(mixer_axis(&drive, ev)){
         printf("I MOVED Axis %i to %i \n",ev->index, ev->value);
     }
 }
 
+void on_control_tick(robot_event *ev) {
+	mixer_tick(&drive);
+}
+
 void on_1hz_timer(robot_event *ev) {
 
 }
@@ -94,7 +92,7 @@ void on_10hz_timer(robot_event *ev) {
 	 ev1.command = ROBOT_EVENT_CMD_NOOP;
 	 ev1.index = 0;
 	 ev1.value = 0;
-	 send_event(&ev1);
+	 tx_send(&ev1);
 }
 
 
@@ -132,7 +130,7 @@ void on_command_code(robot_event *ev) {
             send_ev.index = 0;
             send_ev.value = 0;
 
-            send_event(&send_ev);
+            tx_send(&send_ev);
 			break;
 
 		case ROBOT_EVENT_CMD_START:
@@ -0,0 +1,183 @@
+//    joy_merge.c - merges several joysticks into one stream of events
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// joy_merge.c
+//
+// The joystick threads put the device number in the low bits of the event
+// command. Here each device's axes and buttons are renumbered through its
+// profile to the roles they play, dropping the roles the device hasn't
+// been given, and the devices are merged into the single joystick the
+// event handlers and the mixer expect. Axes and buttons that no role uses
+// pass through with their own numbers on a device of the primary profile,
+// where no role can have the same number, and are dropped on any other.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "robot_log.h"
+#include "profile.h"
+#include "joystick.h"
+#include "joy_merge.h"
+
+#define ROLES_DRIVE ((1 << CON_ROLE_ARM_UP) - 1) // the axes and turbo buttons
+#define ROLES_ALL ((1 << CON_ROLES) - 1)
+#define ROLES_ARM (ROLES_ALL & ~ROLES_DRIVE)
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	int configured;
+	char profile;
+	int roles;                          // bit n set for CON_ROLE n
+	int axis_out[JOY_MAX_AXES];         // merged axis number, -1 to drop
+	int button_out[JOY_MAX_BUTTONS];    // merged button number, -1 to drop
+	int axis[JOY_MAX_AXES];             // latest value, by merged number, -1 if not moved
+	int button[JOY_MAX_BUTTONS];        // held, by merged number
+} merge_device;
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static merge_device devices[JOY_MAX_DEVICES];
+static int merged_axis[JOY_MAX_AXES];       // last value passed on
+static int merged_button[JOY_MAX_BUTTONS];
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+int joy_merge_configure(const char *spec) {
+	int dev;
+	char profile;
+	char roles[16];
+	int n;
+
+	roles[0] = '\0';
+	n = sscanf(spec, "%d:%c:%15s", &dev, &profile, roles);
+	if (n < 2 || dev < 0 || dev >= JOY_MAX_DEVICES) {
+		return 0;
+	}
+	devices[dev].configured = 1;
+	devices[dev].profile = profile;
+	if (n < 3 || strcmp(roles, "all") == 0) {
+		devices[dev].roles = ROLES_ALL;
+	} else if (strcmp(roles, "drive") == 0) {
+		devices[dev].roles = ROLES_DRIVE;
+	} else if (strcmp(roles, "arm") == 0) {
+		devices[dev].roles = ROLES_ARM;
+	} else {
+		return 0;
+	}
+	return 1;
+}
+
+void joy_merge_start(char primary) {
+	merge_device *d;
+	int dev, role, raw, out, i, pass;
+
+	for(dev = 0; dev < JOY_MAX_DEVICES; dev++) {
+		d = &devices[dev];
+		if (!d->configured) {
+			d->profile = primary;
+			d->roles = ROLES_ALL;
+		}
+		// an unused number of another profile could be a role's here
+		pass = (d->profile == primary);
+		for(i = 0; i < JOY_MAX_AXES; i++) {
+			d->axis_out[i] = pass ? i : -1;
+			d->axis[i] = -1;
+		}
+		for(i = 0; i < JOY_MAX_BUTTONS; i++) {
+			d->button_out[i] = pass ? i : -1;
+			d->button[i] = 0;
+		}
+		for(role = 0; role < CON_ROLES; role++) {
+			raw = profileIndex(d->profile, role);
+			out = (d->roles & (1 << role)) ? profileIndex(primary, role) : -1;
+			if (role < CON_ROLE_AXES && raw >= 0 && raw < JOY_MAX_AXES) {
+				d->axis_out[raw] = out;
+			} else if (role >= CON_ROLE_AXES && raw >= 0 && raw < JOY_MAX_BUTTONS) {
+				d->button_out[raw] = out;
+			}
+		}
+		if (d->configured) {
+			log_string(-1, "Joystick %d: profile %c, %s", dev, d->profile,
+					d->roles == ROLES_ALL ? "all roles" :
+					d->roles == ROLES_DRIVE ? "drive" : "arm");
+		}
+	}
+	for(i = 0; i < JOY_MAX_AXES; i++) {
+		merged_axis[i] = JOY_AXIS_CENTER;
+	}
+	for(i = 0; i < JOY_MAX_BUTTONS; i++) {
+		merged_button[i] = 0;
+	}
+}
+
+int joy_merge(robot_event *ev) {
+	int dev = ev->command & 0x0F;
+	int kind = ev->command & 0xF0;
+	int out, value, best, i;
+
+	if (dev >= JOY_MAX_DEVICES) {
+		return 0;
+	}
+	ev->command = kind;
+
+	if (kind == ROBOT_EVENT_JOY_AXIS) {
+		if (ev->index >= JOY_MAX_AXES || (out = devices[dev].axis_out[ev->index]) < 0) {
+			return 0;
+		}
+		devices[dev].axis[out] = ev->value;
+
+		value = JOY_AXIS_CENTER;
+		best = -1;
+		for(i = 0; i < JOY_MAX_DEVICES; i++) {
+			if (devices[i].axis[out] >= 0 &&
+					abs(devices[i].axis[out] - JOY_AXIS_CENTER) > best) {
+				best = abs(devices[i].axis[out] - JOY_AXIS_CENTER);
+				value = devices[i].axis[out];
+			}
+		}
+		if (value == merged_axis[out]) {
+			return 0;
+		}
+		merged_axis[out] = value;
+	} else if (kind == ROBOT_EVENT_JOY_BUTTON) {
+		if (ev->index >= JOY_MAX_BUTTONS || (out = devices[dev].button_out[ev->index]) < 0) {
+			return 0;
+		}
+		devices[dev].button[out] = (ev->value != 0);
+
+		value = 0;
+		for(i = 0; i < JOY_MAX_DEVICES; i++) {
+			value |= devices[i].button[out];
+		}
+		if (value == merged_button[out]) {
+			return 0;
+		}
+		merged_button[out] = value;
+	} else {
+		return 1;
+	}
+
+	ev->index = out;
+	ev->value = value;
+	return 1;
+}
@@ -0,0 +1,46 @@
+//    joy_merge.h - merges several joysticks into one stream of events
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef JOY_MERGE_H
+#define JOY_MERGE_H
+
+#include "events.h"
+
+// joy_merge_configure - sets the joystick type and the roles of one device
+// 	from "device:profile[:roles]", where roles is drive, arm or all (the
+// 	default), eg. "0:p:drive" and "1:x:arm" for a driver and an arm
+// 	operator. Returns 0 if the spec doesn't parse.
+extern int joy_merge_configure(const char *spec);
+
+// joy_merge_start - builds the mapping. primary is the profile given with
+// 	-j; every role is renumbered to its number in that profile, which is
+// 	what the event handlers compare against. Devices that weren't
+// 	configured use the primary profile for every role. Axes and buttons
+// 	no role uses are dropped unless the device has the primary profile.
+extern void joy_merge_start(char primary);
+
+// joy_merge - turns an event from one device into an event of the merged
+// 	joystick, in place. Returns 0 if nothing changed and the event should
+// 	be dropped.
+//
+// 	An axis goes to whichever device has it furthest from center, so an
+// 	operator resting on a stick doesn't cancel the other one. A button is
+// 	down while any device holds it down.
+extern int joy_merge(robot_event *ev);
+
+#endif //!JOY_MERGE_H
@@ -25,6 +25,7 @@
 #include "robot_log.h"
 #include "robot_queue.h"
 #include "joystick.h"
+#include "joystick_linux.h"
 #include "events.h"
 
 //---------------------------------------------------------------------------//
@@ -38,13 +39,38 @@ static void *joy_thread_main(void *arg);
 // Private Globals
 //
 static pthread_t tid = 0; // Thread ID of the joystick thread
-static SDL_Joystick *joy = NULL; // Joystick to read from
+static SDL_Joystick *joy[JOY_MAX_DEVICES]; // Joysticks to read from
+static int num_joy = 0;
+static const char *device[JOY_MAX_DEVICES]; // kernel devices to read instead of SDL
+static int num_device = 0;
 
 //---------------------------------------------------------------------------//
 // Public Function Implementations
 //
 
+void joy_set_device(const char *path) {
+	if (num_device < JOY_MAX_DEVICES) {
+		device[num_device++] = path;
+	}
+}
+
 int joy_thread_create(robot_queue *q) {
+	int i;
+
+	if (num_device > 0) {
+		for(i = 0; i < num_device; i++) {
+			if (!joy_linux_open(device[i])) {
+				joy_linux_close();
+				return 0;
+			}
+		}
+		if(pthread_create(&tid, NULL, joy_linux_main, q) != 0) {
+			joy_linux_close();
+			return 0;
+		}
+		return 1;
+	}
+
 	// initialize the Joystick
 	if (!init_joy()) {
 		return 0;
@@ -70,10 +96,19 @@ int joy_thread_destroy() {
 	if (pthread_join(tid, NULL) != 0) {
 		return 0;
 	}
+	if (num_device > 0) {
+		return joy_linux_close();
+	}
 	return close_joy();
 
 }
 
+void joy_log_stats(int level) {
+	if (num_device > 0) {
+		joy_linux_log_stats(level);
+	}
+}
+
 //---------------------------------------------------------------------------//
 // Private Function Implementations
 //
@@ -90,14 +125,14 @@ void *joy_thread_main(void *arg) {
 		switch(event.type) {
 			// this is where we call the user implemented events
 			case SDL_JOYBUTTONDOWN: // button down
-                ev.command = ROBOT_EVENT_JOY_BUTTON;
+                ev.command = ROBOT_EVENT_JOY_BUTTON | event.jbutton.which;
                 ev.index = event.jbutton.button;
                 ev.value = 1;
                 robot_queue_enqueue(q, &ev);
 
 				break;
 			case SDL_JOYBUTTONUP: // button up
-                ev.command = ROBOT_EVENT_JOY_BUTTON;
+                ev.command = ROBOT_EVENT_JOY_BUTTON | event.jbutton.which;
                 ev.index = event.jbutton.button;
                 ev.value = 0;
                 robot_queue_enqueue(q, &ev);
@@ -107,7 +142,7 @@ void *joy_thread_main(void *arg) {
 				// convert from a signed short to an unsigned char
 				small_range = (event.jaxis.value + 32768) >> 8;
 
-                ev.command = ROBOT_EVENT_JOY_AXIS;
+                ev.command = ROBOT_EVENT_JOY_AXIS | event.jaxis.which;
                 ev.index = event.jaxis.axis;
                 ev.value = small_range;
 
@@ -153,37 +188,39 @@ int init_joy() {
 		return 0;
 	}
 
-	// Open joystick
-	if((joy = SDL_JoystickOpen(0)) == NULL ) {
-		log_string(1, "Couldn't open Joystick 0");
-		return 0;
+	// Open every joystick, each is a device number of its own
+	for(num_joy = 0; num_joy < SDL_NumJoysticks() && num_joy < JOY_MAX_DEVICES; num_joy++) {
+		if((joy[num_joy] = SDL_JoystickOpen(num_joy)) == NULL ) {
+			log_string(1, "Couldn't open Joystick %d", num_joy);
+			break;
+		}
+
+		log_string(-1, "Opened Joystick %d", num_joy);
+		log_string(-1, "Name: %s", SDL_JoystickName(num_joy));
+		log_string(-1, "Number of Axes: %d", SDL_JoystickNumAxes(joy[num_joy]));
+		log_string(-1, "Number of Buttons: %d", SDL_JoystickNumButtons(joy[num_joy]));
+		log_string(-1, "Number of Balls: %d", SDL_JoystickNumBalls(joy[num_joy]));
+		log_string(-1, "Number of Hats: %d", SDL_JoystickNumHats(joy[num_joy]));
 	}
-	
-	// Check that the Joystick is indeed opened
-	if(!SDL_JoystickOpened(0)) {
-		log_string(1, "Joystick 0 hasn't been opened");
+	if(num_joy == 0) {
 		return 0;
 	}
 
-	log_string(-1, "Opened Joystick 0");
-	log_string(-1, "Name: %s", SDL_JoystickName(0));
-	log_string(-1, "Number of Axes: %d", SDL_JoystickNumAxes(joy));
-	log_string(-1, "Number of Buttons: %d", SDL_JoystickNumButtons(joy));
-	log_string(-1, "Number of Balls: %d", SDL_JoystickNumBalls(joy));
-	log_string(-1, "Number of Hats: %d", SDL_JoystickNumHats(joy));
-
 	SDL_JoystickEventState(SDL_ENABLE);
 
 	return 1;
 }
 
-// close_joy - closes the joystick opened in init_joy
-// 	joy - the joystick returned by init_joy
+// close_joy - closes the joysticks opened in init_joy
 int close_joy() {
-	// Close if opened
-	if((joy != NULL) && (SDL_JoystickOpened(0))) {
-		SDL_JoystickClose(joy);
-		return 1;
+	int i;
+
+	if(num_joy == 0) {
+		return 0;
 	}
-	return 0;
+	for(i = 0; i < num_joy; i++) {
+		SDL_JoystickClose(joy[i]);
+	}
+	num_joy = 0;
+	return 1;
 }
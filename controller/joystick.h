@@ -24,9 +24,19 @@
 #define JOY_AXIS_CENTER 127
 #define JOY_MAX_AXES 16
 #define JOY_MAX_BUTTONS 16
+#define JOY_MAX_DEVICES 4 // the device number is in the low bits of the event command
+
+// joy_set_device - read this /dev/input/js* or /dev/input/event* device
+// 	through the kernel instead of SDL. Call once per device, in device
+// 	number order, before joy_thread_create.
+extern void joy_set_device(const char *path);
 
 extern int joy_thread_create(robot_queue *q);
 extern int joy_thread_destroy(); 
 
+// joy_log_stats - logs input latency since the last call, where the
+// 	backend can measure it
+extern void joy_log_stats(int level);
+
 
 #endif //!JOYSTICK_H
@@ -0,0 +1,409 @@
+//    joystick_linux.c - reads a joystick through the kernel's joydev or evdev
+//    interface
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// joystick_linux.c
+//
+// SDL needs the video subsystem (and so an X display) before it delivers
+// joystick events, and SDL_WaitEvent polls with a 10ms sleep. Reading the
+// kernel device directly needs neither: the thread blocks in read() and
+// queues each event as soon as the kernel hands it over.
+//
+// Axes and buttons are numbered the way joydev numbers them, so the
+// profiles in profile.c work the same with either interface (and SDL).
+// Axis values are cut down to 0-255 and only queued when that changes;
+// with evdev they are also held until the end of the report, so a stick
+// moved diagonally gives one event per axis per report. Several devices
+// are read from one thread with poll(); each one's events carry its
+// number in the low bits of the command.
+//
+#include <linux/joystick.h>
+#include <linux/input.h>
+#include <sys/ioctl.h>
+#include <sys/poll.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "robot_log.h"
+#include "robot_queue.h"
+#include "joystick.h"
+#include "joystick_linux.h"
+#include "events.h"
+
+#define BITS_PER_LONG (sizeof(long) * 8)
+#define NLONGS(x) (((x) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define TEST_BIT(bit, array) ((array[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1)
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	int id;                     // device number, goes in the event command
+	int fd;
+	int evdev;                  // 1 for /dev/input/event*, 0 for js*
+
+	int axis_map[ABS_CNT];      // evdev ABS code to axis number, -1 if none
+	int axis_min[JOY_MAX_AXES];
+	int axis_max[JOY_MAX_AXES];
+	int button_map[KEY_CNT - BTN_MISC]; // evdev BTN code to button number
+
+	int last_axis[JOY_MAX_AXES]; // last 0-255 value queued, -1 for none
+	int pending[JOY_MAX_AXES];  // evdev value waiting for SYN_REPORT, -1 for none
+	int stamped;                // kernel stamps are on CLOCK_MONOTONIC
+} joy_device;
+
+//---------------------------------------------------------------------------//
+// Private Function Prototypes
+//
+static int evdev_setup(joy_device *d);
+static int read_joydev(joy_device *d, robot_queue *q);
+static int read_evdev(joy_device *d, robot_queue *q);
+static void queue_axis(joy_device *d, robot_queue *q, int axis, int value);
+static void queue_button(joy_device *d, robot_queue *q, int button, int value);
+static void note_latency(const joy_device *d, const struct timeval *stamp);
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static joy_device devices[JOY_MAX_DEVICES];
+static int num_devices = 0;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int lat_count = 0;
+static long long lat_total = 0; // usec
+static long long lat_max = 0;
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+int joy_linux_open(const char *path) {
+	char name[128];
+	joy_device *d;
+	int i;
+
+	if (num_devices >= JOY_MAX_DEVICES) {
+		log_string(1, "Too many joysticks, ignoring %s", path);
+		return 0;
+	}
+	d = &devices[num_devices];
+	d->id = num_devices;
+	d->evdev = (strstr(path, "/js") == NULL);
+	d->stamped = 0;
+	d->fd = open(path, O_RDONLY);
+	if (d->fd < 0) {
+		log_errno(1, "Couldn't open joystick %s", path);
+		return 0;
+	}
+
+	for(i = 0; i < JOY_MAX_AXES; i++) {
+		d->last_axis[i] = -1;
+		d->pending[i] = -1;
+	}
+
+	if (d->evdev) {
+		if (ioctl(d->fd, EVIOCGNAME(sizeof(name)), name) < 0) {
+			log_errno(1, "%s isn't an input event device", path);
+			close(d->fd);
+			return 0;
+		}
+		if (!evdev_setup(d)) {
+			close(d->fd);
+			return 0;
+		}
+	} else {
+		if (ioctl(d->fd, JSIOCGNAME(sizeof(name)), name) < 0) {
+			log_errno(1, "%s isn't a joystick device", path);
+			close(d->fd);
+			return 0;
+		}
+	}
+	name[sizeof(name) - 1] = '\0';
+
+	log_string(-1, "Opened joystick %d: %s (%s)", d->id, path, d->evdev ? "evdev" : "joydev");
+	log_string(-1, "Name: %s", name);
+	num_devices++;
+	return 1;
+}
+
+void *joy_linux_main(void *arg) {
+	robot_queue *q = (robot_queue *)arg;
+	struct pollfd fds[JOY_MAX_DEVICES];
+	int i, ok, open_devices;
+
+	for(i = 0; i < num_devices; i++) {
+		fds[i].fd = devices[i].fd;
+		fds[i].events = POLLIN;
+	}
+	open_devices = num_devices;
+
+	while (open_devices > 0) {
+		if (poll(fds, num_devices, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			log_errno(1, "Error waiting for the joysticks");
+			break;
+		}
+		for(i = 0; i < num_devices; i++) {
+			if (fds[i].fd < 0 || fds[i].revents == 0) {
+				continue;
+			}
+			if (devices[i].evdev) {
+				ok = read_evdev(&devices[i], q);
+			} else {
+				ok = read_joydev(&devices[i], q);
+			}
+			if (!ok) {
+				// unplugged, keep reading the others
+				log_string(1, "Lost joystick %d", i);
+				fds[i].fd = -1;
+				open_devices--;
+			}
+		}
+	}
+	return NULL;
+}
+
+int joy_linux_close() {
+	int i;
+
+	if (num_devices == 0) {
+		return 0;
+	}
+	for(i = 0; i < num_devices; i++) {
+		close(devices[i].fd);
+	}
+	num_devices = 0;
+	return 1;
+}
+
+void joy_linux_log_stats(int level) {
+	unsigned int count;
+	long long total, max;
+
+	pthread_mutex_lock(&stats_lock);
+	count = lat_count;
+	total = lat_total;
+	max = lat_max;
+	lat_count = 0;
+	lat_total = 0;
+	lat_max = 0;
+	pthread_mutex_unlock(&stats_lock);
+
+	if (count) {
+		log_string(level, "joystick n=%u input latency avg/max=%lld/%lld us",
+				count, total / count, max);
+	}
+}
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// evdev_setup - numbers the axes and buttons the device has and reads the
+// 	axis ranges
+static int evdev_setup(joy_device *d) {
+	unsigned long absbits[NLONGS(ABS_CNT)];
+	unsigned long keybits[NLONGS(KEY_CNT)];
+	struct input_absinfo info;
+	int code, n;
+
+	memset(absbits, 0, sizeof(absbits));
+	memset(keybits, 0, sizeof(keybits));
+	if (ioctl(d->fd, EVIOCGBIT(EV_ABS, sizeof(absbits)), absbits) < 0 ||
+			ioctl(d->fd, EVIOCGBIT(EV_KEY, sizeof(keybits)), keybits) < 0) {
+		log_errno(1, "Couldn't read the joystick capabilities");
+		return 0;
+	}
+
+	n = 0;
+	for(code = 0; code < ABS_CNT; code++) {
+		d->axis_map[code] = -1;
+		if (!TEST_BIT(code, absbits) || n >= JOY_MAX_AXES) {
+			continue;
+		}
+		if (ioctl(d->fd, EVIOCGABS(code), &info) < 0 || info.maximum <= info.minimum) {
+			continue;
+		}
+		d->axis_map[code] = n;
+		d->axis_min[n] = info.minimum;
+		d->axis_max[n] = info.maximum;
+		n++;
+	}
+	log_string(-1, "Number of Axes: %d", n);
+
+	// joydev puts the joystick and gamepad buttons first
+	for(code = 0; code < KEY_CNT - BTN_MISC; code++) {
+		d->button_map[code] = -1;
+	}
+	n = 0;
+	for(code = BTN_JOYSTICK; code < KEY_CNT; code++) {
+		if (TEST_BIT(code, keybits) && n < JOY_MAX_BUTTONS) {
+			d->button_map[code - BTN_MISC] = n++;
+		}
+	}
+	for(code = BTN_MISC; code < BTN_JOYSTICK; code++) {
+		if (TEST_BIT(code, keybits) && n < JOY_MAX_BUTTONS) {
+			d->button_map[code - BTN_MISC] = n++;
+		}
+	}
+	log_string(-1, "Number of Buttons: %d", n);
+
+#ifdef EVIOCSCLOCKID
+	// stamp events on the same clock we read, for the latency figures
+	code = CLOCK_MONOTONIC;
+	if (ioctl(d->fd, EVIOCSCLOCKID, &code) == 0) {
+		d->stamped = 1;
+	}
+#endif
+	return 1;
+}
+
+// read_joydev - queues what one read() returns. Returns 0 once the device
+// 	has gone.
+static int read_joydev(joy_device *d, robot_queue *q) {
+	struct js_event js[16];
+	ssize_t len;
+	int i, n;
+
+	len = read(d->fd, js, sizeof(js));
+	if (len <= 0) {
+		if (len < 0 && errno == EINTR) {
+			return 1;
+		}
+		log_errno(1, "Error reading the joystick");
+		return 0;
+	}
+	n = len / sizeof(struct js_event);
+	for(i = 0; i < n; i++) {
+		switch(js[i].type & ~JS_EVENT_INIT) {
+			case JS_EVENT_AXIS:
+				// convert from a signed short to an unsigned char
+				queue_axis(d, q, js[i].number, (js[i].value + 32768) >> 8);
+				break;
+			case JS_EVENT_BUTTON:
+				queue_button(d, q, js[i].number, js[i].value ? 1 : 0);
+				break;
+		}
+	}
+	return 1;
+}
+
+// read_evdev - as read_joydev, for an event device
+static int read_evdev(joy_device *d, robot_queue *q) {
+	struct input_event in[32];
+	ssize_t len;
+	int i, n, axis, button;
+
+	len = read(d->fd, in, sizeof(in));
+	if (len <= 0) {
+		if (len < 0 && errno == EINTR) {
+			return 1;
+		}
+		log_errno(1, "Error reading the joystick");
+		return 0;
+	}
+	n = len / sizeof(struct input_event);
+	for(i = 0; i < n; i++) {
+		switch(in[i].type) {
+			case EV_ABS:
+				if (in[i].code >= ABS_CNT || (axis = d->axis_map[in[i].code]) < 0) {
+					break;
+				}
+				d->pending[axis] = (int)((long long)(in[i].value - d->axis_min[axis]) * 255 /
+						(d->axis_max[axis] - d->axis_min[axis]));
+				if (d->pending[axis] < 0) {
+					d->pending[axis] = 0;
+				}
+				if (d->pending[axis] > 255) {
+					d->pending[axis] = 255;
+				}
+				break;
+			case EV_KEY:
+				if (in[i].code < BTN_MISC || in[i].code >= KEY_CNT ||
+						(button = d->button_map[in[i].code - BTN_MISC]) < 0) {
+					break;
+				}
+				// 2 is autorepeat
+				if (in[i].value != 2) {
+					queue_button(d, q, button, in[i].value);
+					note_latency(d, &in[i].time);
+				}
+				break;
+			case EV_SYN:
+				if (in[i].code != SYN_REPORT) {
+					break;
+				}
+				for(axis = 0; axis < JOY_MAX_AXES; axis++) {
+					if (d->pending[axis] >= 0) {
+						queue_axis(d, q, axis, d->pending[axis]);
+						d->pending[axis] = -1;
+					}
+				}
+				note_latency(d, &in[i].time);
+				break;
+		}
+	}
+	return 1;
+}
+
+static void queue_axis(joy_device *d, robot_queue *q, int axis, int value) {
+	robot_event ev;
+
+	if (axis < 0 || axis >= JOY_MAX_AXES || d->last_axis[axis] == value) {
+		return;
+	}
+	d->last_axis[axis] = value;
+	ev.command = ROBOT_EVENT_JOY_AXIS | d->id;
+	ev.index = axis;
+	ev.value = value;
+	robot_queue_enqueue(q, &ev);
+}
+
+static void queue_button(joy_device *d, robot_queue *q, int button, int value) {
+	robot_event ev;
+
+	ev.command = ROBOT_EVENT_JOY_BUTTON | d->id;
+	ev.index = button;
+	ev.value = value;
+	robot_queue_enqueue(q, &ev);
+}
+
+static void note_latency(const joy_device *d, const struct timeval *stamp) {
+	struct timespec now;
+	long long usec;
+
+	if (!d->stamped) {
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	usec = ((long long)now.tv_sec - stamp->tv_sec) * 1000000 +
+		now.tv_nsec / 1000 - stamp->tv_usec;
+
+	pthread_mutex_lock(&stats_lock);
+	lat_count++;
+	lat_total += usec;
+	if (usec > lat_max) {
+		lat_max = usec;
+	}
+	pthread_mutex_unlock(&stats_lock);
+}
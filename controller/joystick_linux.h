@@ -0,0 +1,41 @@
+//    joystick_linux.h - reads a joystick through the kernel's joydev or evdev
+//    interface
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef JOYSTICK_LINUX_H
+#define JOYSTICK_LINUX_H
+
+#include "robot_queue.h"
+
+// Only used by joystick.c, see joy_set_device
+
+// joy_linux_open - adds /dev/input/js* (joydev) or /dev/input/event*
+// 	(evdev, anything else) as the next device number. Returns 0 on failure.
+extern int joy_linux_open(const char *path);
+
+// joy_linux_main - reads the devices, queueing events, until all have failed
+extern void *joy_linux_main(void *arg);
+
+// joy_linux_close - closes the devices
+extern int joy_linux_close();
+
+// joy_linux_log_stats - logs the time from the kernel stamping an input
+// 	event to it being queued (evdev only), then resets the statistics
+extern void joy_linux_log_stats(int level);
+
+#endif //!JOYSTICK_LINUX_H
@@ -0,0 +1,117 @@
+//    swerve_bench.c - accuracy and speed of the swerve kinematics
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// swerve_bench.c
+//
+// Compares swerve_strafe/swerve_twist against the floating point code
+// the colonel controller used before, over every stick position, then
+// times both on a stream of axis values.
+//
+// 	make swerve_bench && ./swerve_bench [iterations]
+//
+#define PI 3.1415926535897932384626433832
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "swerve.h"
+
+#define DEFAULT_ITERATIONS 10000000
+
+// The original calculation from controller_events_colonel.c
+static int strafe_double(int xNew, int yNew) {
+	int strafe = 0;
+	if(xNew < 0)
+		strafe = (int)(((double)250*(double)atan((double)yNew/(double)xNew)/((double).5*(double)PI))-250); //Left side.
+	else if (xNew > 0)
+		strafe = (int)(((double)(250)*(double)atan((double)yNew/(double)xNew)/((double).5*(double)PI))+250); // Right Side.
+	else if (yNew <= 0)
+		strafe = 0;
+	else if (yNew > 0)
+		strafe = 500;
+	return strafe;
+}
+
+static int twist_double(int rNew) {
+	return (int)(rNew*200.0/127.0);
+}
+
+static double now_sec() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+	long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+	int x, y, r, err, maxerr = 0, mismatches = 0, total = 0;
+	unsigned int seed = 1;
+	unsigned char *axes;
+	volatile int sink = 0;
+	double t0, tdouble, tint;
+	long i;
+
+	// accuracy over every stick position the controller can produce
+	for(x = -127; x <= 126; x++) {
+		for(y = -127; y <= 126; y++) {
+			err = abs(swerve_strafe(x, y) - strafe_double(x, y));
+			if (err > maxerr) {
+				maxerr = err;
+			}
+			if (err) {
+				mismatches++;
+			}
+			total++;
+		}
+	}
+	for(r = -128; r <= 127; r++) {
+		if (swerve_twist(r) != twist_double(r)) {
+			printf("twist mismatch at %d: %d != %d\n", r, swerve_twist(r), twist_double(r));
+			return 1;
+		}
+	}
+	printf("strafe: %d positions, %d differ, max error %d units (of 1000)\n",
+			total, mismatches, maxerr);
+
+	// random axis values, generated up front so both see the same input
+	axes = malloc(3 * 65536);
+	for(i = 0; i < 3 * 65536; i++) {
+		axes[i] = rand_r(&seed) & 0xFF;
+	}
+
+	t0 = now_sec();
+	for(i = 0; i < iterations; i++) {
+		unsigned char *a = &axes[(i & 0xFFFF) * 3];
+		sink += strafe_double(a[0] - 128, a[1] - 128) + twist_double(a[2] - 128);
+	}
+	tdouble = now_sec() - t0;
+
+	t0 = now_sec();
+	for(i = 0; i < iterations; i++) {
+		unsigned char *a = &axes[(i & 0xFFFF) * 3];
+		sink += swerve_strafe(a[0] - 128, a[1] - 128) + swerve_twist(a[2] - 128);
+	}
+	tint = now_sec() - t0;
+
+	printf("double:  %10.0f events/sec\n", iterations / tdouble);
+	printf("integer: %10.0f events/sec (%.1fx)\n", iterations / tint, tdouble / tint);
+
+	free(axes);
+	return 0;
+}
@@ -0,0 +1,86 @@
+//    var_cache.c - the latest values of subscribed robostix variables
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "robot_tx.h"
+#include "var_cache.h"
+
+#define VARS 256
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+// Only touched from the main loop
+static short values[VARS];
+static char have[VARS];         // a value has arrived
+static unsigned short subs[VARS]; // subscription, as sent, 0 if none
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+static void send_subscription(unsigned char var) {
+	robot_event ev;
+
+	ev.command = ROBOT_EVENT_READ_VAR_SUBSCRIBE;
+	ev.index = var;
+	ev.value = subs[var];
+	tx_send(&ev);
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void var_subscribe(unsigned char var, int hz, int threshold) {
+	if(hz > 255) {
+		hz = 255;
+	}
+	if(threshold > 255) {
+		threshold = 255;
+	}
+	if(hz <= 0) {
+		subs[var] = 0;
+		have[var] = 0;
+	} else {
+		subs[var] = (hz << 8) | threshold;
+	}
+	send_subscription(var);
+}
+
+int var_get(unsigned char var, short *value) {
+	if(!have[var]) {
+		return 0;
+	}
+	*value = values[var];
+	return 1;
+}
+
+void var_cache_update(const robot_event *ev) {
+	values[ev->index] = (short)ev->value;
+	have[ev->index] = 1;
+}
+
+void var_cache_resubscribe() {
+	int var;
+
+	for(var = 0; var < VARS; var++) {
+		if(subs[var]) {
+			send_subscription(var);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+//    var_cache.h - the latest values of subscribed robostix variables
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Instead of sending READ_VAR and waiting on the reply, a handler
+// subscribes to a variable once, usually in on_init, and the robot pushes
+// it whenever it changes. var_get then answers from the cache.
+
+#ifndef VAR_CACHE_H
+#define VAR_CACHE_H
+
+#include "events.h"
+
+// var_subscribe - asks the robot for var, sampled hz times a second (at
+// 	most TIMER_CONTROL_HZ) and sent when it moves by threshold or more.
+// 	An hz of 0 unsubscribes.
+extern void var_subscribe(unsigned char var, int hz, int threshold);
+
+// var_get - the latest value of var
+// 	return - 0 if none has arrived yet
+extern int var_get(unsigned char var, short *value);
+
+// var_cache_update - stores a ROBOT_EVENT_READ_VAR from the robot
+extern void var_cache_update(const robot_event *ev);
+
+// var_cache_resubscribe - resends the subscriptions, in case the robot
+// 	restarted or one was lost. Called once a second.
+extern void var_cache_resubscribe();
+
+#endif //!VAR_CACHE_H
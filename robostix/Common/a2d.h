@@ -41,6 +41,27 @@
 uint8_t  a2d_8( uint8_t Channel );
 uint16_t a2d_10( uint8_t Channel );
 
+#if !defined( CFG_ADC_SAMPLER )
+#   define  CFG_ADC_SAMPLER             0
+#endif
+
+#if CFG_ADC_SAMPLER
+
+#if !defined( CFG_ADC_SAMPLER_MASK )
+#   define  CFG_ADC_SAMPLER_MASK        0xFF
+#endif
+#if !defined( CFG_ADC_OVERSAMPLE_SHIFT )
+#   define  CFG_ADC_OVERSAMPLE_SHIFT    2
+#endif
+#if !defined( CFG_ADC_FILTER_SHIFT )
+#   define  CFG_ADC_FILTER_SHIFT        0
+#endif
+
+void     a2d_sampler_init( void );
+uint16_t a2d_sampled( uint8_t Channel );
+
+#endif  // CFG_ADC_SAMPLER
+
 #endif  // CFG_USE_ADC
 #endif // A2D_H
 
@@ -0,0 +1,215 @@
+/****************************************************************************
+*
+*   Copyright (c) 2007 Dave Hylands     <dhylands@gmail.com>
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation.
+*
+*   Alternatively, this software may be distributed under the terms of BSD
+*   license.
+*
+*   See README and COPYING for more details.
+*
+****************************************************************************/
+/**
+*
+*   @file    a2d_sampler.c
+*
+*   @brief   Free running A/D sampler. The ADC complete interrupt cycles
+*            through the configured channels, oversampling and optionally
+*            low pass filtering each one, so that readers get the latest
+*            value without waiting for a conversion.
+*
+*****************************************************************************/
+/*
+*
+*   Configurable options
+*
+*   Option Name                 Default Description
+*   --------------------------  ------- ----------------------------------------
+*   CFG_ADC_SAMPLER                 0   Include the free running sampler
+*   CFG_ADC_SAMPLER_MASK         0xFF   Bit n set samples channel n (0 thru 7)
+*   CFG_ADC_OVERSAMPLE_SHIFT        2   Average 2^n conversions per sample (0 thru 6)
+*   CFG_ADC_FILTER_SHIFT            0   IIR filter, y += (x - y) / 2^n (0 = off)
+*
+*****************************************************************************/
+
+/* ---- Include Files ----------------------------------------------------- */
+
+#include <avr/io.h>
+#if defined( __AVR_LIBC_VERSION__ )
+#   include <avr/interrupt.h>
+#else
+#   include <avr/signal.h>
+#endif
+#include "Config.h"
+#include "Hardware.h"
+#include "a2d.h"
+
+#if CFG_USE_ADC && CFG_ADC_SAMPLER
+
+/* ---- Public Variables -------------------------------------------------- */
+/* ---- Private Constants and Types --------------------------------------- */
+
+// Samples are kept with 6 fractional bits, which is just enough to hold
+// the sum of 64 conversions in 16 bits.
+
+#define A2D_FRAC_BITS   6
+
+#if ( CFG_ADC_OVERSAMPLE_SHIFT > A2D_FRAC_BITS )
+#   error CFG_ADC_OVERSAMPLE_SHIFT must be 6 or less
+#endif
+
+#if (( CFG_ADC_SAMPLER_MASK & 0xFF ) == 0 )
+#   error CFG_ADC_SAMPLER_MASK must select at least one channel
+#endif
+
+#define A2D_REFS_MASK   (( 1 << REFS1 ) | ( 1 << REFS0 ))
+
+/* ---- Private Variables ------------------------------------------------- */
+
+static volatile uint16_t    gSample[ 8 ];   // Latest values, scaled by 2^A2D_FRAC_BITS
+static volatile uint8_t     gPrimed;        // Bit n set once gSample[ n ] is valid
+
+static uint8_t              gChannel;       // Channel currently being converted
+static uint8_t              gCount;         // Conversions accumulated so far
+static uint16_t             gAccum;
+
+/* ---- Private Function Prototypes --------------------------------------- */
+
+static void StartConversion( void );
+
+/* ---- Functions --------------------------------------------------------- */
+
+/****************************************************************************/
+/**
+*   Starts the sampler. Conversions begin once interrupts are enabled.
+*/
+
+void a2d_sampler_init( void )
+{
+    gChannel = 0;
+    while (( CFG_ADC_SAMPLER_MASK & ( 1 << gChannel )) == 0 )
+    {
+        gChannel++;
+    }
+    gCount = 0;
+    gAccum = 0;
+    gPrimed = 0;
+
+    // Let any conversion started by InitHardware finish first
+
+    while ( ADCSR & ( 1 << ADSC ))
+        ;
+
+    StartConversion();
+
+} // a2d_sampler_init
+
+/****************************************************************************/
+/**
+*   Selects gChannel and starts a conversion which will interrupt when
+*   it completes.
+*/
+
+static void StartConversion( void )
+{
+    ADMUX = ( ADMUX & A2D_REFS_MASK ) | gChannel;
+    ADCSR = ADCSR | ( 1 << ADIE ) | ( 1 << ADSC );
+
+} // StartConversion
+
+/****************************************************************************/
+/**
+*   ADC conversion complete interrupt handler.
+*/
+
+SIGNAL( SIG_ADC )
+{
+    gAccum += ADC;
+
+    if ( ++gCount >= ( 1 << CFG_ADC_OVERSAMPLE_SHIFT ))
+    {
+        uint16_t    sample = gAccum << ( A2D_FRAC_BITS - CFG_ADC_OVERSAMPLE_SHIFT );
+        uint8_t     chanMask = 1 << gChannel;
+
+#if ( CFG_ADC_FILTER_SHIFT > 0 )
+        if ( gPrimed & chanMask )
+        {
+            int32_t filtered = gSample[ gChannel ];
+
+            filtered += ((int32_t)sample - filtered ) >> CFG_ADC_FILTER_SHIFT;
+            sample = (uint16_t)filtered;
+        }
+#endif
+        gSample[ gChannel ] = sample;
+        gPrimed |= chanMask;
+
+        gCount = 0;
+        gAccum = 0;
+
+        // Move on to the next channel in the mask
+
+        do
+        {
+            gChannel = ( gChannel + 1 ) & 0x07;
+
+        } while (( CFG_ADC_SAMPLER_MASK & ( 1 << gChannel )) == 0 );
+    }
+
+    StartConversion();
+
+} // SIG_ADC
+
+/****************************************************************************/
+/**
+*   Returns the latest 10 bit value for a channel. Channels (or mux
+*   settings) which aren't being sampled get a blocking conversion, during
+*   which the sampler is paused. May be called from interrupt handlers.
+*/
+
+uint16_t a2d_sampled( uint8_t Channel )
+{
+    uint8_t     sreg;
+    uint16_t    sample;
+
+    // Until a channel has its first sample (or if it isn't being sampled
+    // at all) fall back to converting on the spot. Waiting instead would
+    // hang when called from another interrupt handler.
+
+    if (( Channel < 8 ) && ( gPrimed & CFG_ADC_SAMPLER_MASK & ( 1 << Channel )))
+    {
+        sreg = SREG;
+        cli();
+        sample = gSample[ Channel ];
+        SREG = sreg;
+
+        return ( sample + ( 1 << ( A2D_FRAC_BITS - 1 ))) >> A2D_FRAC_BITS;
+    }
+
+    sreg = SREG;
+    cli();
+
+    // Stop the sampler and throw away whatever it was converting
+
+    ADCSR = ADCSR & ~(( 1 << ADIE ) | ( 1 << ADIF ));
+    while ( ADCSR & ( 1 << ADSC ))
+        ;
+
+    sample = a2d_10( Channel );
+
+    // Writing a 1 clears ADIF, then carry on where the sampler left off
+
+    ADCSR = ADCSR | ( 1 << ADIF );
+    gCount = 0;
+    gAccum = 0;
+    StartConversion();
+
+    SREG = sreg;
+
+    return sample;
+
+} // a2d_sampled
+
+#endif  // CFG_USE_ADC && CFG_ADC_SAMPLER
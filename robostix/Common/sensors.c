@@ -25,6 +25,13 @@
 #define Z_GYRO_AMP_ADC  0x04
 #define VOLT_METER_ADC	0x05
 
+//The free running sampler has these without waiting on a conversion
+#if CFG_ADC_SAMPLER
+#define READ_ADC(ch)	a2d_sampled(ch)
+#else
+#define READ_ADC(ch)	a2d_10(ch)
+#endif
+
 #define GYRO_MIN	92
 #define GYRO_ZERO	492
 #define GYRO_MAX	892
@@ -76,8 +83,8 @@ void processData(){
 
 		//Read data from ADCs
 		//
-		x_gyro_amp = a2d_10(X_GYRO_AMP_ADC);
-		x_gyro_full = a2d_10(X_GYRO_FULL_ADC);
+		x_gyro_amp = READ_ADC(X_GYRO_AMP_ADC);
+		x_gyro_full = READ_ADC(X_GYRO_FULL_ADC);
 
 		if (x_gyro_amp < GYRO_AMP_LIMIT_LOW || x_gyro_amp > GYRO_AMP_LIMIT_HIGH){
 			x_gyro = (signed short)x_gyro_amp - GYRO_ZERO;
@@ -35,9 +35,12 @@
  *  protocol. Any changes require the version number to be incremented.
  *
  *  Version 2 - Introduced READ/WRITE_REG_8/16
+ *  Version 3 - Introduced GET_ADC_MULTI
+ *  Version 4 - Introduced FIFO_CONFIG and FIFO_READ
+ *  Version 5 - Introduced READ_VAR_MULTI
  */
 
-#define I2C_IO_API_VERSION      2
+#define I2C_IO_API_VERSION      5
 
 //---------------------------------------------------------------------------
 /**
@@ -243,6 +246,106 @@ typedef struct
 
 #define I2C_IO_READ_VAR  0x0C
 
+//---------------------------------------------------------------------------
+/**
+*   The I2C_IO_GET_ADC_MULTI command samples several single ended ADC
+*   channels in one transaction.
+*
+*   Bit n of mask selects channel n (0 thru 7). A block-reply is returned
+*   which contains a 16 bit value for each selected channel, lowest
+*   channel first, so it is 2 bytes long for each bit set in mask.
+*/
+
+typedef struct
+{
+    uint8_t mask;
+
+} I2C_IO_Get_ADC_Multi_t;
+
+#define I2C_IO_GET_ADC_MULTI    0x0D
+
+#define I2C_IO_NUM_ADC          8
+
+//---------------------------------------------------------------------------
+/**
+*   The I2C_IO_FIFO_CONFIG command starts (or stops) streaming samples
+*   into the sample FIFO on the robostix.
+*
+*   Every periodMs milliseconds, each ADC channel selected in adcMask is
+*   sampled and pushed into the FIFO, stamped with the low 16 bits of the
+*   millisecond tick. A periodMs of 0 stops sampling. The FIFO is emptied
+*   whenever it's reconfigured.
+*/
+
+typedef struct
+{
+    uint8_t     adcMask;    ///< Bit n set samples ADC channel n
+    uint8_t     periodMs;   ///< Sample period, 0 to stop
+
+} I2C_IO_FifoConfig_t;
+
+#define I2C_IO_FIFO_CONFIG      0x0E
+
+//---------------------------------------------------------------------------
+/**
+*   The I2C_IO_FIFO_READ command removes up to maxSamples samples from the
+*   FIFO (oldest first).
+*
+*   A block-reply is returned which starts with an I2C_IO_FifoHdr_t,
+*   followed by I2C_IO_FIFO_SAMPLE_LEN bytes per sample: the tick (2 bytes),
+*   the source (1 byte) and the value (2 bytes), 16 bit values being
+*   little endian. Since the layout of I2C_IO_FifoSample_t differs between
+*   the AVR and the host, the host unpacks the bytes by hand.
+*/
+
+typedef struct
+{
+    uint8_t     maxSamples; ///< Most samples to return (max I2C_IO_FIFO_MAX_READ)
+
+} I2C_IO_FifoRead_t;
+
+typedef struct
+{
+    uint8_t     remaining;  ///< Samples left in the FIFO after this read (saturates at 255)
+    uint8_t     overflow;   ///< Samples dropped because the FIFO was full, since the previous read
+
+} I2C_IO_FifoHdr_t;
+
+typedef struct
+{
+    uint16_t    tick;       ///< Millisecond tick the sample was taken
+    uint8_t     source;     ///< I2C_IO_FIFO_SRC_xxx
+    uint16_t    value;
+
+} I2C_IO_FifoSample_t;
+
+#define I2C_IO_FIFO_READ        0x0F
+
+#define I2C_IO_FIFO_SAMPLE_LEN  5
+#define I2C_IO_FIFO_MAX_READ    6   // ( 32 byte block - header ) / 5
+
+#define I2C_IO_FIFO_SRC_ADC     0x00    // 0x00 - 0x07 are ADC channels 0 - 7
+
+//---------------------------------------------------------------------------
+/**
+*   The I2C_IO_READ_VAR_MULTI command reads several user variables in one
+*   transaction.
+*
+*   The request holds one variable index per byte, as many as the block
+*   length says. A block-reply is returned which contains a 16 bit value
+*   for each variable, in the order requested.
+*/
+
+#define I2C_IO_MAX_READ_VARS    15  // ( 32 byte block - len ) / 2
+
+typedef struct
+{
+    uint8_t     var[ I2C_IO_MAX_READ_VARS ];    ///< Indices of the variables to read
+
+} I2C_IO_ReadVarMulti_t;
+
+#define I2C_IO_READ_VAR_MULTI   0x10
+
 /* ---- Variable Externs ------------------------------------------------- */
 
 /* ---- Function Prototypes ---------------------------------------------- */
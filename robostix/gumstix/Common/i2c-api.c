@@ -23,8 +23,10 @@
 
 // ---- Include Files -------------------------------------------------------
 
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include "i2c.h"
 #include "i2c-dev.h"
@@ -38,51 +40,273 @@
 
 // ---- Private Constants and Types -----------------------------------------
 
+// ---- Private Function Prototypes -----------------------------------------
+
+static  int I2cIoctlBackend( int i2cFd, struct i2c_rdwr_ioctl_data *rdwr );
+static  void I2cProfileRecord( const I2C_Xfer_t *xfer, unsigned wireBytes, unsigned usec, I2C_ProfOutcome_t outcome );
+static  void I2cProfileBatch( const I2C_Xfer_t *xfer, const unsigned *wireBytes, int numXfers, const struct timespec *start, int ioctlErrno );
+
 // ---- Private Variables ---------------------------------------------------
 
-static  I2C_Addr_t  gI2cAddr;
-static  int         gUseCrc;
+static  I2C_BackendFunc_t   gBackend = I2cIoctlBackend;
 
-// ---- Private Function Prototypes -----------------------------------------
+// The profile is updated by whoever performs the transfer. Callers already
+// serialize their use of the bus, so no further locking is done here; a
+// dump taken while a transfer is running may be off by one transfer.
+
+static  int                 gProfEnabled = 0;
+static  I2C_ProfEntry_t     gProf[ I2C_PROF_SLOTS ];
+static  int                 gProfUsed = 0;
+static  unsigned            gProfDropped = 0;
 
 // ---- Functions -----------------------------------------------------------
 
 //***************************************************************************
 /**
 *
-*   Sets the I2C address that we'll be communicating with, as well as whether
-*   the device uses smbus PEC (CRC).
+*   Performs a transaction using the i2c-dev driver.
 */
 
-void I2cSetSlaveAddress( int i2cDev, I2C_Addr_t i2cAddr, int useCrc )
+static int I2cIoctlBackend( int i2cFd, struct i2c_rdwr_ioctl_data *rdwr )
 {
-    gI2cAddr = i2cAddr;
-    gUseCrc  = useCrc;
+    return ioctl( i2cFd, I2C_RDWR, rdwr );
 
-    LogDebug( "----- I2cSetSlaveAddress i2cAddr:0x%02x useCrc:%d -----\n",
-              i2cAddr, useCrc );
+} // I2cIoctlBackend
+
+//***************************************************************************
+/**
+*
+*   Selects the bus backend used for all subsequent transfers. Passing NULL
+*   restores the i2c-dev driver.
+*/
+
+void I2cSetBackend( I2C_BackendFunc_t backend )
+{
+    gBackend = ( backend != NULL ) ? backend : I2cIoctlBackend;
+
+} // I2cSetBackend
+
+//***************************************************************************
+/**
+*
+*   Turns transaction profiling on or off. The data collected so far is
+*   kept; use I2cProfileReset to clear it.
+*/
+
+void I2cProfileEnable( int enable )
+{
+    gProfEnabled = enable;
+
+} // I2cProfileEnable
+
+//***************************************************************************
+/**
+*
+*   Clears all of the collected profile data.
+*/
+
+void I2cProfileReset( void )
+{
+    memset( gProf, 0, sizeof( gProf ));
+    gProfUsed = 0;
+    gProfDropped = 0;
+
+} // I2cProfileReset
+
+//***************************************************************************
+/**
+*
+*   Copies out the profile data and returns the number of entries filled in.
+*/
+
+int I2cProfileGet( I2C_ProfEntry_t *entry, int maxEntries )
+{
+    int n = ( gProfUsed < maxEntries ) ? gProfUsed : maxEntries;
+
+    memcpy( entry, gProf, n * sizeof( entry[ 0 ] ));
+    return n;
+
+} // I2cProfileGet
+
+//***************************************************************************
+/**
+*
+*   Logs the profile, one line per (addr, cmd) followed by its histogram.
+*   The bus occupancy column is the fraction of the wall time since the
+*   first transfer each command has spent on the bus.
+*/
+
+void I2cProfileDump( void )
+{
+    static const char *outcomeName[ I2C_PROF_NUM_OUTCOMES ] = { "ok", "nak", "crc", "len", "err" };
+    int     i, j;
 
-    // Indicate which slave we wish to speak to
+    Log( "i2c profile: %d commands%s\n", gProfUsed, gProfEnabled ? "" : " (disabled)" );
 
-    if ( ioctl( i2cDev, I2C_SLAVE, gI2cAddr ) < 0 )
+    for ( i = 0; i < gProfUsed; i++ )
     {
-        LogError( "I2cSetSlaveAddress: Error trying to set slave address to 0x%02x (%d %s)\n", 
-                  gI2cAddr, errno, strerror( errno ));
+        const I2C_ProfEntry_t  *e = &gProf[ i ];
+        char                    line[ 256 ];
+        int                     len;
+
+        if ( e->count == 0 )
+        {
+            continue;
+        }
+
+        len = snprintf( line, sizeof( line ), "  0x%02x cmd 0x%02x: n=%u bytes=%u avg=%u max=%u us",
+                        e->addr, e->cmd, e->count, e->bytes,
+                        (unsigned)( e->totalUsec / e->count ), e->maxUsec );
+
+        for ( j = 0; j < I2C_PROF_NUM_OUTCOMES; j++ )
+        {
+            if (( e->outcome[ j ] != 0 ) && ( len < (int)sizeof( line )))
+            {
+                len += snprintf( &line[ len ], sizeof( line ) - len, " %s=%u", outcomeName[ j ], e->outcome[ j ] );
+            }
+        }
+        Log( "%s\n", line );
+
+        len = snprintf( line, sizeof( line ), "    usec:" );
+        for ( j = 0; j < I2C_PROF_BUCKETS; j++ )
+        {
+            if (( e->hist[ j ] != 0 ) && ( len < (int)sizeof( line )))
+            {
+                len += snprintf( &line[ len ], sizeof( line ) - len, " <%u:%u",
+                                 1u << j, e->hist[ j ] );
+            }
+        }
+        Log( "%s\n", line );
+    }
+    if ( gProfDropped != 0 )
+    {
+        Log( "  %u transfers not recorded (more than %d commands)\n", gProfDropped, I2C_PROF_SLOTS );
     }
 
-    // We do the CRC calculation ourself, so we don't need to tell the driver
-    // that we're using it.
+} // I2cProfileDump
+
+//***************************************************************************
+/**
+*
+*   Adds one transfer to the profile.
+*/
 
-#if 0
-    // Indicate that we use PEC (aka CRCs)
+static void I2cProfileRecord( const I2C_Xfer_t *xfer, unsigned wireBytes, unsigned usec, I2C_ProfOutcome_t outcome )
+{
+    I2C_Addr_t          addr = I2C_HANDLE_ADDR( xfer->i2cDev );
+    I2C_ProfEntry_t    *e = NULL;
+    int                 bucket;
+    int                 i;
 
-    if ( ioctl( i2cDev, I2C_PEC, 1 ) < 0 )
+    for ( i = 0; i < gProfUsed; i++ )
     {
-        LogError( "I2cSetSlaveAddress: Error trying to set PEC mode\n" );
+        if (( gProf[ i ].addr == addr ) && ( gProf[ i ].cmd == xfer->cmd ))
+        {
+            e = &gProf[ i ];
+            break;
+        }
     }
-#endif
+    if ( e == NULL )
+    {
+        if ( gProfUsed >= I2C_PROF_SLOTS )
+        {
+            gProfDropped++;
+            return;
+        }
+        e = &gProf[ gProfUsed++ ];
+        e->addr = addr;
+        e->cmd  = xfer->cmd;
+    }
+
+    for ( bucket = 0; ( bucket < I2C_PROF_BUCKETS - 1 ) && ( usec >= ( 1u << bucket )); bucket++ )
+    {
+        ;
+    }
+
+    e->count++;
+    e->outcome[ outcome ]++;
+    e->bytes += wireBytes;
+    e->totalUsec += usec;
+    if ( usec > e->maxUsec )
+    {
+        e->maxUsec = usec;
+    }
+    e->hist[ bucket ]++;
 
-} // I2cSetSlaveAddress
+} // I2cProfileRecord
+
+//***************************************************************************
+/**
+*
+*   Records the transfers of a batch. The time for the whole transaction
+*   is shared out in proportion to the bytes each transfer put on the wire.
+*/
+
+static void I2cProfileBatch( const I2C_Xfer_t *xfer, const unsigned *wireBytes, int numXfers, const struct timespec *start, int ioctlErrno )
+{
+    struct timespec     end;
+    unsigned            usec;
+    unsigned            totalBytes = 0;
+    I2C_ProfOutcome_t   outcome;
+    int                 i;
+
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    usec = ( end.tv_sec - start->tv_sec ) * 1000000 + ( end.tv_nsec - start->tv_nsec ) / 1000;
+
+    for ( i = 0; i < numXfers; i++ )
+    {
+        totalBytes += wireBytes[ i ];
+    }
+
+    for ( i = 0; i < numXfers; i++ )
+    {
+        if ( ioctlErrno != 0 )
+        {
+            outcome = (( ioctlErrno == EREMOTEIO ) || ( ioctlErrno == ENXIO ) || ( ioctlErrno == EIO ))
+                    ? I2C_PROF_NAK : I2C_PROF_ERR;
+        }
+        else if ( xfer[ i ].rc == EBADMSG )
+        {
+            outcome = I2C_PROF_CRC;
+        }
+        else if ( xfer[ i ].rc == EMSGSIZE )
+        {
+            outcome = I2C_PROF_LEN;
+        }
+        else
+        {
+            outcome = I2C_PROF_OK;
+        }
+
+        I2cProfileRecord( &xfer[ i ], wireBytes[ i ],
+                          totalBytes ? (unsigned)(( (uint64_t)usec * wireBytes[ i ] ) / totalBytes ) : usec,
+                          outcome );
+    }
+
+} // I2cProfileBatch
+
+//***************************************************************************
+/**
+*
+*   Returns a handle which addresses the given slave, and whether the device
+*   uses smbus PEC (CRC). No ioctl is involved, the address is carried in
+*   each i2c_msg, so creating a handle is free and handles for different
+*   slaves may be freely mixed on the same file descriptor.
+*/
+
+int I2cSlaveHandle( int i2cDev, I2C_Addr_t i2cAddr, int useCrc )
+{
+    LogDebug( "----- I2cSlaveHandle i2cAddr:0x%02x useCrc:%d -----\n",
+              i2cAddr, useCrc );
+
+    // We do the CRC calculation ourself, so we don't need to tell the driver
+    // that we're using it.
+
+    return I2C_HANDLE_FD( i2cDev )
+         | (( i2cAddr & 0x7F ) << 16 )
+         | (( useCrc ? 1 : 0 ) << 23 );
+
+} // I2cSlaveHandle
 
 //***************************************************************************
 /**
@@ -116,173 +340,271 @@ int I2cTransfer
     uint8_t    *bytesReadp     ///< Place to store number of bytes read 
 )
 {
-    struct i2c_rdwr_ioctl_data  rdwr;
-    struct i2c_msg              msg[ 2 ];
-    uint8_t                     wrBuf[ I2C_MAX_DATA_LEN + 3 ];  // +1 for cmd, +1 for len, +1 for CRC
-    uint8_t                     rdBuf[ I2C_MAX_DATA_LEN + 2 ];  // +1 for len, +1 for CRC
-    uint8_t                     crc = 0;
-    uint8_t                     wrBlock = (( wrLen & 0x80 ) != 0 );
-    uint8_t                     rdBlock = (( rdLen & 0x80 ) != 0 );
-    int                         rc = 0;
+    I2C_Xfer_t  xfer;
+    int         rc;
 
-    LogDebug( "----- I2cTransfer: cmd:0x%02x wrLen:0x%02x rdLen:0x%02x wrBlock:%d rdBlock:%d -----\n",
-              cmd, wrLen, rdLen, wrBlock, rdBlock );
-    if ( wrData != NULL )
-    {
-        LogDebug( "----- wrData:0x%08x *wrData:0x%02x -----\n", wrData, *(const uint8_t *)wrData ); 
-    }
+    xfer.i2cDev = i2cDev;
+    xfer.cmd    = cmd;
+    xfer.wrData = wrData;
+    xfer.wrLen  = wrLen;
+    xfer.rdData = rdData;
+    xfer.rdLen  = rdLen;
 
-    rdLen &= 0x7f;
-    wrLen &= 0x7f;
+    rc = I2cTransferBatch( &xfer, 1 );
 
     if ( bytesReadp != NULL )
     {
-        *bytesReadp = 0;
+        *bytesReadp = xfer.bytesRead;
     }
+    return rc;
 
-    if ( wrLen > I2C_MAX_DATA_LEN ) 
-    {
-        LogError( "I2cTransfer: wrLen too big: %d, max is %d\n",
-                  wrLen, I2C_MAX_DATA_LEN );
-        errno = ENOBUFS;
-        return -1;
-    }
+} // I2cTransfer
 
-    if ( rdLen > I2C_MAX_DATA_LEN )
+//***************************************************************************
+/**
+*   Performs several transfers, possibly to different slaves, using a
+*   single I2C_RDWR ioctl. Each transfer is described exactly as it would
+*   be for I2cTransfer, and the slave is taken from the transfer's handle.
+*
+*   All of the transfers must use the same file descriptor. The return
+*   value is -1 if the ioctl failed (in which case none of the transfers
+*   can be trusted), otherwise the first non-zero xfer[].rc, or 0.
+*/
+
+int I2cTransferBatch
+(
+    I2C_Xfer_t *xfer,       ///< Transfers to perform
+    int         numXfers    ///< Number of transfers (max I2C_MAX_BATCH)
+)
+{
+    struct i2c_rdwr_ioctl_data  rdwr;
+    struct i2c_msg              msg[ 2 * I2C_MAX_BATCH ];
+    uint8_t                     wrBuf[ I2C_MAX_BATCH ][ I2C_MAX_DATA_LEN + 3 ];  // +1 for cmd, +1 for len, +1 for CRC
+    uint8_t                     rdBuf[ I2C_MAX_BATCH ][ I2C_MAX_DATA_LEN + 2 ];  // +1 for len, +1 for CRC
+    struct i2c_msg             *rdMsg[ I2C_MAX_BATCH ];
+    uint8_t                     crc[ I2C_MAX_BATCH ];
+    unsigned                    wireBytes[ I2C_MAX_BATCH ];
+    struct timespec             start;
+    int                         i2cFd;
+    int                         rc = 0;
+    int                         i;
+
+    if (( numXfers <= 0 ) || ( numXfers > I2C_MAX_BATCH ))
     {
-        LogError( "I2cTransfer: rdLen too big: %d, max is %d\n",
-                  rdLen, I2C_MAX_DATA_LEN );
-        errno = ENOBUFS;
+        LogError( "I2cTransferBatch: bad number of transfers: %d, max is %d\n",
+                  numXfers, I2C_MAX_BATCH );
+        errno = EINVAL;
         return -1;
     }
 
-    // Whether we're doing a read or a write, we always send
-    // the command.
+    i2cFd = I2C_HANDLE_FD( xfer[ 0 ].i2cDev );
 
-    msg[ 0 ].addr  = gI2cAddr;
-    msg[ 0 ].flags = 0;
-    msg[ 0 ].len   = wrLen + 1 + wrBlock;    // +1 for cmd
-    msg[ 0 ].buf   = (char *)&wrBuf[ 0 ];
-
-    if ( gUseCrc )
+    if ( gProfEnabled )
     {
-        crc = Crc8( 0,   gI2cAddr << 1 );
-        crc = Crc8( crc, cmd );
+        clock_gettime( CLOCK_MONOTONIC, &start );
     }
 
-    wrBuf[ 0 ] = cmd;
+    rdwr.msgs = msg;
+    rdwr.nmsgs = 0;
 
-    if ( wrLen > 0 )
+    for ( i = 0; i < numXfers; i++ )
     {
-        // We have some data to send down to the device
+        I2C_Xfer_t     *x       = &xfer[ i ];
+        I2C_Addr_t      i2cAddr = I2C_HANDLE_ADDR( x->i2cDev );
+        int             useCrc  = I2C_HANDLE_CRC( x->i2cDev );
+        uint8_t         wrBlock = (( x->wrLen & 0x80 ) != 0 );
+        uint8_t         rdBlock = (( x->rdLen & 0x80 ) != 0 );
+        uint8_t         wrLen   = x->wrLen & 0x7f;
+        uint8_t         rdLen   = x->rdLen & 0x7f;
+        struct i2c_msg *m;
+
+        LogDebug( "----- I2cTransfer: addr:0x%02x cmd:0x%02x wrLen:0x%02x rdLen:0x%02x wrBlock:%d rdBlock:%d -----\n",
+                  i2cAddr, x->cmd, x->wrLen, x->rdLen, wrBlock, rdBlock );
+        if ( x->wrData != NULL )
+        {
+            LogDebug( "----- wrData:0x%08x *wrData:0x%02x -----\n", x->wrData, *(const uint8_t *)x->wrData ); 
+        }
+
+        x->bytesRead = 0;
+        x->rc = 0;
+        rdMsg[ i ] = NULL;
+        wireBytes[ i ] = 0;
 
-        if ( wrBlock )
+        if ( I2C_HANDLE_FD( x->i2cDev ) != i2cFd )
         {
-            wrBuf[ 1 ] = wrLen;
-            memcpy( &wrBuf[ 2 ], wrData, wrLen );
-            wrLen++;    // Add in cmd to the length
+            LogError( "I2cTransferBatch: transfer %d uses a different i2c-dev file\n", i );
+            errno = EINVAL;
+            return -1;
         }
-        else
+
+        if ( wrLen > I2C_MAX_DATA_LEN ) 
         {
-            memcpy( &wrBuf[ 1 ], wrData, wrLen );
+            LogError( "I2cTransfer: wrLen too big: %d, max is %d\n",
+                      wrLen, I2C_MAX_DATA_LEN );
+            errno = ENOBUFS;
+            return -1;
         }
-        if ( gUseCrc )
+
+        if ( rdLen > I2C_MAX_DATA_LEN )
         {
-            crc = Crc8Block( crc, &wrBuf[ 1 ], wrLen );
+            LogError( "I2cTransfer: rdLen too big: %d, max is %d\n",
+                      rdLen, I2C_MAX_DATA_LEN );
+            errno = ENOBUFS;
+            return -1;
+        }
 
-            if ( rdLen == 0 )
-            {
-                // This is a write-only, so we need to send the CRC
+        // Whether we're doing a read or a write, we always send
+        // the command.
 
-                wrBuf[ wrLen + 1 ] = crc;
-                msg[ 0 ].len++;
-            }
+        m = &msg[ rdwr.nmsgs++ ];
+        m->addr  = i2cAddr;
+        m->flags = 0;
+        m->len   = wrLen + 1 + wrBlock;    // +1 for cmd
+        m->buf   = (char *)&wrBuf[ i ][ 0 ];
+
+        crc[ i ] = 0;
+        if ( useCrc )
+        {
+            crc[ i ] = Crc8( 0,      i2cAddr << 1 );
+            crc[ i ] = Crc8( crc[ i ], x->cmd );
         }
-    }
 
-    if ( gDebug )
-    {
-        Log( "msg[ 0 ].addr  = 0x%02x\n", msg[ 0 ].addr );
-        Log( "msg[ 0 ].flags = 0x%04x\n", msg[ 0 ].flags );
-        Log( "msg[ 0 ].len   = %d\n",     msg[ 0 ].len );
-        DumpMem( "I2cTransfer W", 0, &wrBuf[ 0 ], msg[ 0 ].len );
-    }
+        wrBuf[ i ][ 0 ] = x->cmd;
 
-    rdwr.msgs = msg;
-    rdwr.nmsgs = 1;
+        if ( wrLen > 0 )
+        {
+            // We have some data to send down to the device
 
-    if ( rdLen > 0 )
-    {
-        // We're expecting some data to come back
+            if ( wrBlock )
+            {
+                wrBuf[ i ][ 1 ] = wrLen;
+                memcpy( &wrBuf[ i ][ 2 ], x->wrData, wrLen );
+                wrLen++;    // Add in cmd to the length
+            }
+            else
+            {
+                memcpy( &wrBuf[ i ][ 1 ], x->wrData, wrLen );
+            }
+            if ( useCrc )
+            {
+                crc[ i ] = Crc8Block( crc[ i ], &wrBuf[ i ][ 1 ], wrLen );
 
-        msg[ 1 ].addr  = gI2cAddr;
-        msg[ 1 ].flags = I2C_M_RD;
-        msg[ 1 ].len   = rdLen + rdBlock + gUseCrc;
-        msg[ 1 ].buf   = (char *)&rdBuf[ 0 ];
+                if ( rdLen == 0 )
+                {
+                    // This is a write-only, so we need to send the CRC
 
-        rdwr.nmsgs = 2;
+                    wrBuf[ i ][ wrLen + 1 ] = crc[ i ];
+                    m->len++;
+                }
+            }
+        }
+
+        wireBytes[ i ] += m->len + 1;  // +1 for the address byte
 
-        if ( gUseCrc )
+        if ( gDebug )
         {
-            crc = Crc8( crc, ( gI2cAddr << 1 ) | 1 );
+            Log( "msg[ %d ].addr  = 0x%02x\n", rdwr.nmsgs - 1, m->addr );
+            Log( "msg[ %d ].flags = 0x%04x\n", rdwr.nmsgs - 1, m->flags );
+            Log( "msg[ %d ].len   = %d\n",     rdwr.nmsgs - 1, m->len );
+            DumpMem( "I2cTransfer W", 0, &wrBuf[ i ][ 0 ], m->len );
         }
 
-        if ( gDebug )
+        if ( rdLen > 0 )
         {
-            Log( "msg[ 1 ].addr  = 0x%02x\n", msg[ 1 ].addr );
-            Log( "msg[ 1 ].flags = 0x%04x\n", msg[ 1 ].flags );
-            Log( "msg[ 1 ].len   = %d\n",     msg[ 1 ].len );
+            // We're expecting some data to come back
+
+            m = &msg[ rdwr.nmsgs++ ];
+            m->addr  = i2cAddr;
+            m->flags = I2C_M_RD;
+            m->len   = rdLen + rdBlock + useCrc;
+            m->buf   = (char *)&rdBuf[ i ][ 0 ];
+            rdMsg[ i ] = m;
+            wireBytes[ i ] += m->len + 1;
+
+            if ( useCrc )
+            {
+                crc[ i ] = Crc8( crc[ i ], ( i2cAddr << 1 ) | 1 );
+            }
+
+            if ( gDebug )
+            {
+                Log( "msg[ %d ].addr  = 0x%02x\n", rdwr.nmsgs - 1, m->addr );
+                Log( "msg[ %d ].flags = 0x%04x\n", rdwr.nmsgs - 1, m->flags );
+                Log( "msg[ %d ].len   = %d\n",     rdwr.nmsgs - 1, m->len );
+            }
         }
     }
 
-    if ( ioctl( i2cDev, I2C_RDWR, &rdwr ) < 0 )
+    if ( gBackend( i2cFd, &rdwr ) < 0 )
     {
+        int err = errno;
+
         LogError( "I2cTransfer: ioctl failed: %s (%d)\n", strerror( errno ), errno );
+        if ( gProfEnabled )
+        {
+            I2cProfileBatch( xfer, wireBytes, numXfers, &start, err );
+        }
+        errno = err;
         return -1;
     }
 
-    if ( rdLen > 0 )
+    for ( i = 0; i < numXfers; i++ )
     {
+        I2C_Xfer_t *x       = &xfer[ i ];
+        uint8_t     rdBlock = (( x->rdLen & 0x80 ) != 0 );
+        uint8_t     rdLen   = x->rdLen & 0x7f;
+
+        if ( rdMsg[ i ] == NULL )
+        {
+            continue;
+        }
+
         if ( rdBlock )
         {
-            if ( rdBuf[ 0 ] > rdLen )
+            if ( rdBuf[ i ][ 0 ] > rdLen )
             {
-                LogError( "I2cTransfer: length is too big: %d max: %d\n", rdBuf[ 0 ], rdLen );
+                LogError( "I2cTransfer: length is too big: %d max: %d\n", rdBuf[ i ][ 0 ], rdLen );
 
-                rc = EMSGSIZE;
+                x->rc = EMSGSIZE;
             }
             else
             {
-                rdLen = rdBuf[ 0 ];
+                rdLen = rdBuf[ i ][ 0 ];
             }
         }
 
-        if ( gUseCrc )
+        if ( I2C_HANDLE_CRC( x->i2cDev ))
         {
-            crc = Crc8Block( crc, &rdBuf[ 0 ], rdLen + rdBlock );
+            crc[ i ] = Crc8Block( crc[ i ], &rdBuf[ i ][ 0 ], rdLen + rdBlock );
 
-            if ( crc != rdBuf[ rdLen + rdBlock ] )
+            if ( crc[ i ] != rdBuf[ i ][ rdLen + rdBlock ] )
             {
                 LogError( "I2cTransfer: CRC failed: Rcvd: 0x%02x, expecting: 0x%02x\n",
-                          rdBuf[ rdLen + rdBlock ], crc );
-                rc = EBADMSG;
+                          rdBuf[ i ][ rdLen + rdBlock ], crc[ i ] );
+                x->rc = EBADMSG;
             }
         }
         
         if ( gDebug )
         {
-            DumpMem( "I2cTransfer R", 0, &rdBuf[ 0 ], msg[ 1 ].len );
+            DumpMem( "I2cTransfer R", 0, &rdBuf[ i ][ 0 ], rdMsg[ i ]->len );
         }
-        memcpy( rdData, &rdBuf[ rdBlock ], rdLen );
+        memcpy( x->rdData, &rdBuf[ i ][ rdBlock ], rdLen );
+        x->bytesRead = rdLen;
 
-        if ( bytesReadp != NULL )
+        if (( rc == 0 ) && ( x->rc != 0 ))
         {
-            *bytesReadp = rdLen;
+            rc = x->rc;
         }
     }
+
+    if ( gProfEnabled )
+    {
+        I2cProfileBatch( xfer, wireBytes, numXfers, &start, 0 );
+    }
     return rc;
 
-} // I2cTransfer
+} // I2cTransferBatch
 
 //***************************************************************************
 /**
@@ -452,7 +774,7 @@ int I2cReceiveBytes
 
     LogDebug( "----- I2cReceiveBytes -----\n" );
 
-    msg.addr    = gI2cAddr;
+    msg.addr    = I2C_HANDLE_ADDR( i2cDev );
     msg.flags   = I2C_M_RD;
     msg.len     = rdLen;
     msg.buf     = (char *)rdData;
@@ -460,7 +782,7 @@ int I2cReceiveBytes
     rdwr.msgs = &msg;
     rdwr.nmsgs = 1;
 
-    if ( ioctl( i2cDev, I2C_RDWR, &rdwr ) < 0 )
+    if ( gBackend( I2C_HANDLE_FD( i2cDev ), &rdwr ) < 0 )
     {
         LogError( "I2cReceiveBytes: ioctl failed: %s (%d)\n", strerror( errno ), errno );
         return -1;
@@ -502,7 +824,7 @@ int I2cSendBytes
 
     LogDebug( "----- I2cSendBytes wrLen = 0x%02x -----\n", wrLen );
 
-    msg.addr    = gI2cAddr;
+    msg.addr    = I2C_HANDLE_ADDR( i2cDev );
     msg.flags   = 0;
     msg.len     = wrLen;
     msg.buf     = (char *)wrData;
@@ -510,7 +832,7 @@ int I2cSendBytes
     rdwr.msgs = &msg;
     rdwr.nmsgs = 1;
 
-    if ( ioctl( i2cDev, I2C_RDWR, &rdwr ) < 0 )
+    if ( gBackend( I2C_HANDLE_FD( i2cDev ), &rdwr ) < 0 )
     {
         LogError( "I2cSendBytes: ioctl failed: %s (%d)\n", strerror( errno ), errno );
         return -1;
@@ -34,16 +34,125 @@
 #define I2C_USE_CRC 1
 #define I2C_NO_CRC  0
 
+/**
+ *  An i2c handle bundles the i2c-dev file descriptor together with the
+ *  7 bit slave address and CRC mode. Every transfer made through a handle
+ *  is addressed using i2c_msg.addr, so there is no per-file slave address
+ *  to switch and handles for several slaves can share one file descriptor.
+ *
+ *  Handles are built using I2cSlaveHandle. The descriptor itself (needed
+ *  for close) can be recovered using I2C_HANDLE_FD.
+ */
+
+#define I2C_HANDLE_FD( h )      (( h ) & 0xFFFF )
+#define I2C_HANDLE_ADDR( h )    ((( h ) >> 16 ) & 0x7F )
+#define I2C_HANDLE_CRC( h )     ((( h ) >> 23 ) & 1 )
+
+/**
+ *  Maximum number of transfers which may be combined by I2cTransferBatch.
+ */
+
+#define I2C_MAX_BATCH   8
+
+/**
+ *  Describes one transfer (one command) within a batch. wrLen and rdLen
+ *  follow the same conventions as I2cTransfer. bytesRead and rc are filled
+ *  in by I2cTransferBatch.
+ */
+
+typedef struct
+{
+    int         i2cDev;     ///< Handle, selects the slave address and CRC mode
+    uint8_t     cmd;        ///< Command to send
+    const void *wrData;     ///< Data to write
+    uint8_t     wrLen;      ///< Number of bytes to write (or in 0x80 for a block write)
+    void       *rdData;     ///< Place to store data read
+    uint8_t     rdLen;      ///< Number of bytes to read  (or in 0x80 for a block read)
+    uint8_t     bytesRead;  ///< Number of bytes actually read
+    int         rc;         ///< 0, EMSGSIZE or EBADMSG
+
+} I2C_Xfer_t;
+
+/**
+ *  The bus backend performs an I2C_RDWR style transaction on behalf of
+ *  i2c-api. The default backend is the i2c-dev ioctl; an alternate one
+ *  (see i2c-emu.h) can be plugged in to run without the hardware.
+ *  The backend returns a negative value and sets errno on failure.
+ */
+
+struct i2c_rdwr_ioctl_data;
+
+/**
+ *  Transaction profiling. When enabled, every transfer is recorded against
+ *  its (slave address, command) pair: the outcome, the bytes moved and the
+ *  wall time, with the time going into a log2 histogram. Bucket 0 counts
+ *  transfers under 1 usec and bucket n those from 2^(n-1) up to 2^n usec;
+ *  the last bucket also collects everything slower.
+ */
+
+#define I2C_PROF_BUCKETS    16
+#define I2C_PROF_SLOTS      32      ///< Max distinct (addr, cmd) pairs tracked
+
+typedef enum
+{
+    I2C_PROF_OK = 0,
+    I2C_PROF_NAK,           ///< Address or data not acknowledged
+    I2C_PROF_CRC,           ///< Reply CRC didn't match
+    I2C_PROF_LEN,           ///< Reply length was too big
+    I2C_PROF_ERR,           ///< Any other driver error
+    I2C_PROF_NUM_OUTCOMES
+
+} I2C_ProfOutcome_t;
+
+typedef struct
+{
+    I2C_Addr_t  addr;
+    uint8_t     cmd;
+    unsigned    count;
+    unsigned    outcome[ I2C_PROF_NUM_OUTCOMES ];
+    unsigned    bytes;      ///< Bytes on the wire, including address bytes
+    uint64_t    totalUsec;
+    unsigned    maxUsec;
+    unsigned    hist[ I2C_PROF_BUCKETS ];
+
+} I2C_ProfEntry_t;
+
+typedef int (*I2C_BackendFunc_t)( int i2cFd, struct i2c_rdwr_ioctl_data *rdwr );
+
 // ---- Variable Externs ----------------------------------------------------
 
 // ---- Function Prototypes -------------------------------------------------
 
-void I2cSetSlaveAddress
+void I2cSetBackend
 (
-    int         i2cDev,     ///< Handle to i2c-dev file
+    I2C_BackendFunc_t backend );   ///< Backend to use, NULL for i2c-dev
+
+void I2cProfileEnable
+(
+    int         enable );   ///< Non-zero to start recording
+
+void I2cProfileReset( void );
+
+int I2cProfileGet
+(
+    I2C_ProfEntry_t *entry, ///< Array to fill in
+    int         maxEntries  ///< Size of the array
+);
+
+void I2cProfileDump( void );
+
+int I2cSlaveHandle
+(
+    int         i2cDev,     ///< i2c-dev file descriptor (or an existing handle)
     I2C_Addr_t  i2cAddr,    ///< 7 bit i2c address to use
     int         useCrc );   ///< Should CRC's be used?
 
+int I2cTransferBatch
+(
+    I2C_Xfer_t *xfer,       ///< Transfers to perform
+    int         numXfers    ///< Number of transfers (max I2C_MAX_BATCH)
+);
+
 int I2cTransfer
 (
     int         i2cDev,     ///< Handle to i2c-dev file
@@ -0,0 +1,804 @@
+/****************************************************************************
+*
+*   Copyright (c) 2006 Dave Hylands     <dhylands@gmail.com>
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation.
+*
+*   Alternatively, this software may be distributed under the terms of BSD
+*   license.
+*
+*   See README and COPYING for more details.
+*
+****************************************************************************/
+/**
+*
+*   @file   i2c-emu.c
+*
+*   @brief  In-process stand-in for /dev/i2c-0.
+*
+*   I2cEmuOpen plugs a backend into i2c-api which services I2C_RDWR
+*   transactions in software. It answers at I2C_EMU_IO_ADDR with the same
+*   command set as ProcessCommand in robostix/i2c-io/i2c-io.c (including
+*   the CRC-8 framing done by i2c-slave.c), and at the two encoder board
+*   addresses with their read-position / set-steering commands.
+*
+*   Each transaction takes as long as it would on a real bus: one start,
+*   9 bits per byte (including the address byte) and a stop, at the
+*   configured clock rate, plus the time the AVR spends stretching the
+*   clock for an ADC conversion.
+*
+****************************************************************************/
+
+// ---- Include Files -------------------------------------------------------
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "i2c.h"
+#include "i2c-dev.h"
+#include "i2c-api.h"
+#include "i2c-io.h"
+#include "i2c-emu.h"
+
+#include "Crc8.h"
+#include "Log.h"
+
+// ---- Public Variables ----------------------------------------------------
+
+// ---- Private Constants and Types -----------------------------------------
+
+#define NUM_PORTS       7
+
+#define REG_ADCL        0x24
+#define REG_ADCH        0x25
+
+#define ENC_CMD_STEER   1       ///< Encoder board: set steering target
+#define ENC_CMD_READ    10      ///< Encoder board: read position
+
+#define ADC_CONV_USEC   104     ///< 13 ADC clocks at 125 kHz
+
+#define FIFO_SIZE       64      ///< SENSOR_FIFO_SIZE in i2c-io
+
+#ifndef EREMOTEIO
+#define EREMOTEIO   EIO
+#endif
+
+// ---- Private Variables ---------------------------------------------------
+
+// Memory mapped addresses of the port registers on the ATMega128, in the
+// same order as gPORT/gDDR/gPIN in i2c-io.c (0 = A, 1 = B, etc)
+
+static const uint8_t gPortReg[ NUM_PORTS ] = { 0x3B, 0x38, 0x35, 0x32, 0x23, 0x62, 0x65 };
+static const uint8_t gDdrReg[ NUM_PORTS ]  = { 0x3A, 0x37, 0x34, 0x31, 0x22, 0x61, 0x64 };
+static const uint8_t gPinReg[ NUM_PORTS ]  = { 0x39, 0x36, 0x33, 0x30, 0x21, 0x20, 0x63 };
+
+static  pthread_mutex_t gEmuLock = PTHREAD_MUTEX_INITIALIZER;
+
+static  uint8_t     gMem[ 256 ];                // Register file (data space 0x00-0xFF)
+static  uint8_t     gInputs[ NUM_PORTS ];       // Levels driven onto input pins
+static  uint16_t    gAdc[ 32 ];
+static  uint8_t     gAdcSampled = I2C_EMU_ADC_SAMPLED;  // Channels the free running sampler covers
+static  uint16_t    gVars[ I2C_EMU_NUM_VARS ];
+static  uint16_t    gEnc[ 2 ];
+static  uint16_t    gSteer[ 2 ];
+
+static  unsigned    gBusHz = I2C_EMU_DEFAULT_HZ;
+static  unsigned    gExtraUsec = 0;
+static  unsigned    gNakPerMille = 0;
+static  unsigned    gCrcPerMille = 0;
+static  unsigned    gRandSeed = 1;
+
+static  I2C_EmuStats_t  gStats;
+
+static  I2C_IO_FifoSample_t gFifo[ FIFO_SIZE ];
+static  unsigned    gFifoGet;
+static  unsigned    gFifoPut;
+static  uint8_t     gFifoMask;
+static  uint8_t     gFifoPeriodMs;
+static  uint8_t     gFifoOverflow;
+static  uint32_t    gFifoNextMs;                // Tick the next samples are due
+
+// ---- Private Function Prototypes -----------------------------------------
+
+static  int         EmuBackend( int i2cFd, struct i2c_rdwr_ioctl_data *rdwr );
+static  int         EmuProcessCommand( uint8_t *data, int len, unsigned *busyUsec );
+static  int         EmuEncoderCommand( int encNum, uint8_t *data, int len );
+static  int         EmuFault( unsigned perMille );
+static  void        EmuDelay( unsigned usec );
+static  uint32_t    EmuMsTick( void );
+static  void        EmuFifoFill( void );
+
+// ---- Functions -----------------------------------------------------------
+
+//***************************************************************************
+/**
+*   Installs the emulator as the i2c-api backend and returns a file
+*   descriptor to use in place of one opened on /dev/i2c-0.
+*/
+
+int I2cEmuOpen( void )
+{
+    int i2cFd;
+
+    if (( i2cFd = open( "/dev/null", O_RDWR )) < 0 )
+    {
+        LogError( "I2cEmuOpen: Unable to open /dev/null: %s\n", strerror( errno ));
+        return -1;
+    }
+
+    pthread_mutex_lock( &gEmuLock );
+    memset( gMem, 0, sizeof( gMem ));
+    memset( gInputs, 0, sizeof( gInputs ));
+    memset( gAdc, 0, sizeof( gAdc ));
+    memset( gVars, 0, sizeof( gVars ));
+    memset( gEnc, 0, sizeof( gEnc ));
+    memset( gSteer, 0, sizeof( gSteer ));
+    memset( &gStats, 0, sizeof( gStats ));
+    gFifoGet = gFifoPut = 0;
+    gFifoPeriodMs = 0;
+    pthread_mutex_unlock( &gEmuLock );
+
+    I2cSetBackend( EmuBackend );
+
+    Log( "i2c emulator: robostix at 0x%02x, encoders at 0x%02x/0x%02x, %u Hz\n",
+         I2C_EMU_IO_ADDR, I2C_EMU_ENC0_ADDR, I2C_EMU_ENC1_ADDR, gBusHz );
+
+    return i2cFd;
+
+} // I2cEmuOpen
+
+//***************************************************************************
+/**
+*   Removes the emulator and restores the i2c-dev backend.
+*/
+
+void I2cEmuClose( int i2cFd )
+{
+    I2cSetBackend( NULL );
+    close( i2cFd );
+
+} // I2cEmuClose
+
+//***************************************************************************
+/**
+*   Sets the modelled bus clock. A clock of zero turns off the timing
+*   model, so transactions complete as fast as possible.
+*/
+
+void I2cEmuSetBusSpeed( unsigned hz )
+{
+    gBusHz = hz;
+
+} // I2cEmuSetBusSpeed
+
+//***************************************************************************
+/**
+*   Adds a fixed delay to every transaction (driver and scheduling
+*   overhead on the gumstix).
+*/
+
+void I2cEmuSetExtraLatency( unsigned usec )
+{
+    gExtraUsec = usec;
+
+} // I2cEmuSetExtraLatency
+
+//***************************************************************************
+/**
+*   Makes a fraction of transactions fail. NAKs fail the whole transaction,
+*   CRC faults corrupt the CRC byte returned by the robostix.
+*/
+
+void I2cEmuSetFaults( unsigned nakPerMille, unsigned crcPerMille )
+{
+    gNakPerMille = nakPerMille;
+    gCrcPerMille = crcPerMille;
+
+} // I2cEmuSetFaults
+
+//***************************************************************************
+/**
+*   Sets the value which will be "converted" for an ADC mux setting.
+*/
+
+void I2cEmuSetADC( uint8_t mux, uint16_t adcVal )
+{
+    pthread_mutex_lock( &gEmuLock );
+    gAdc[ mux & 0x1F ] = adcVal & 0x3FF;
+    pthread_mutex_unlock( &gEmuLock );
+
+} // I2cEmuSetADC
+
+//***************************************************************************
+/**
+*   Sets which ADC channels the emulated firmware samples in the
+*   background. Reads of those channels return without a conversion delay.
+*/
+
+void I2cEmuSetADCSampled( uint8_t mask )
+{
+    pthread_mutex_lock( &gEmuLock );
+    gAdcSampled = mask;
+    pthread_mutex_unlock( &gEmuLock );
+
+} // I2cEmuSetADCSampled
+
+//***************************************************************************
+/**
+*   Sets the levels seen on the pins of a port which are set for input.
+*/
+
+void I2cEmuSetInputs( uint8_t portNum, uint8_t pinVal )
+{
+    if ( portNum < NUM_PORTS )
+    {
+        pthread_mutex_lock( &gEmuLock );
+        gInputs[ portNum ] = pinVal;
+        pthread_mutex_unlock( &gEmuLock );
+    }
+
+} // I2cEmuSetInputs
+
+//***************************************************************************
+/**
+*   Sets the position reported by an encoder board.
+*/
+
+void I2cEmuSetEncoder( int encNum, uint16_t encVal )
+{
+    pthread_mutex_lock( &gEmuLock );
+    gEnc[ encNum & 1 ] = encVal;
+    pthread_mutex_unlock( &gEmuLock );
+
+} // I2cEmuSetEncoder
+
+//***************************************************************************
+/**
+*   Accessors used by tests and benchmarks to check what the host wrote.
+*/
+
+uint8_t I2cEmuGetReg8( uint8_t reg )
+{
+    return gMem[ reg ];
+
+} // I2cEmuGetReg8
+
+uint16_t I2cEmuGetReg16( uint8_t reg )
+{
+    return gMem[ reg ] | ( gMem[ (uint8_t)( reg + 1 ) ] << 8 );
+
+} // I2cEmuGetReg16
+
+int16_t I2cEmuGetVar( uint8_t var )
+{
+    return ( var < I2C_EMU_NUM_VARS ) ? (int16_t)gVars[ var ] : 0;
+
+} // I2cEmuGetVar
+
+uint16_t I2cEmuGetSteer( int encNum )
+{
+    return gSteer[ encNum & 1 ];
+
+} // I2cEmuGetSteer
+
+void I2cEmuGetStats( I2C_EmuStats_t *stats )
+{
+    pthread_mutex_lock( &gEmuLock );
+    *stats = gStats;
+    pthread_mutex_unlock( &gEmuLock );
+
+} // I2cEmuGetStats
+
+//***************************************************************************
+/**
+*   Services one I2C_RDWR transaction. A write message followed by a read
+*   from the same address is a command with a reply (repeated start), a
+*   write on its own is a command without one.
+*/
+
+static int EmuBackend( int i2cFd, struct i2c_rdwr_ioctl_data *rdwr )
+{
+    uint8_t     reply[ I2C_MAX_DATA_LEN + 2 ];
+    int         replyLen = -1;
+    uint8_t     replyCrc = 0;
+    int         replyAddr = -1;
+    unsigned    bits = 0;
+    unsigned    busyUsec = 0;
+    int         i;
+
+    pthread_mutex_lock( &gEmuLock );
+
+    gStats.transactions++;
+
+    for ( i = 0; i < rdwr->nmsgs; i++ )
+    {
+        struct i2c_msg *msg  = &rdwr->msgs[ i ];
+        uint8_t        *buf  = (uint8_t *)msg->buf;
+        uint8_t         addr = msg->addr & 0x7F;
+
+        bits += 1 + 9 * ( msg->len + 1 );  // (repeated) start, address byte, data
+        gStats.bytes += msg->len + 1;
+
+        if ((( addr != I2C_EMU_IO_ADDR )
+        &&   ( addr != I2C_EMU_ENC0_ADDR )
+        &&   ( addr != I2C_EMU_ENC1_ADDR ))
+        ||  EmuFault( gNakPerMille ))
+        {
+            // Nobody acknowledged the address byte. The driver stops here.
+
+            gStats.naks++;
+            gStats.busUsec += gBusHz ? ( bits + 1 ) * 1000000u / gBusHz : 0;
+            pthread_mutex_unlock( &gEmuLock );
+
+            EmuDelay(( gBusHz ? ( bits + 1 ) * 1000000u / gBusHz : 0 ) + gExtraUsec );
+            errno = EREMOTEIO;
+            return -1;
+        }
+
+        if (( msg->flags & I2C_M_RD ) == 0 )
+        {
+            uint8_t     data[ I2C_MAX_DATA_LEN + 3 ];
+            int         len = msg->len;
+            int         isReply = ( i + 1 < rdwr->nmsgs )
+                               && ( rdwr->msgs[ i + 1 ].flags & I2C_M_RD )
+                               && (( rdwr->msgs[ i + 1 ].addr & 0x7F ) == addr );
+
+            if ( len > (int)sizeof( data ))
+            {
+                len = sizeof( data );
+            }
+            memcpy( data, buf, len );
+
+            if ( addr != I2C_EMU_IO_ADDR )
+            {
+                replyLen = EmuEncoderCommand( addr == I2C_EMU_ENC1_ADDR, data, len );
+                memcpy( reply, data, replyLen > 0 ? replyLen : 0 );
+                replyAddr = isReply ? addr : -1;
+                continue;
+            }
+
+            // The slave CRC covers everything from its own address byte.
+
+            replyCrc = Crc8( 0, addr << 1 );
+
+            if ( !isReply && ( len >= 2 ) && ( len == data[ 1 ] + 3 ))
+            {
+                // Block write followed by a CRC byte
+
+                if ( Crc8Block( replyCrc, data, len - 1 ) != data[ len - 1 ] )
+                {
+                    gStats.crcErrors++;
+                    LogError( "i2c-emu: write CRC mismatch for cmd 0x%02x\n", data[ 0 ] );
+                }
+                len--;
+            }
+            replyCrc = Crc8Block( replyCrc, data, len );
+
+            replyLen = EmuProcessCommand( data, len, &busyUsec );
+            if ( replyLen > (int)sizeof( reply ) - 1 )
+            {
+                replyLen = sizeof( reply ) - 1;
+            }
+            memcpy( reply, data, replyLen > 0 ? replyLen : 0 );
+            replyAddr = isReply ? addr : -1;
+        }
+        else
+        {
+            int n = 0;
+
+            if (( addr == replyAddr ) && ( replyLen > 0 ))
+            {
+                n = ( replyLen < msg->len ) ? replyLen : msg->len;
+                memcpy( buf, reply, n );
+
+                if ( addr == I2C_EMU_IO_ADDR )
+                {
+                    replyCrc = Crc8( replyCrc, ( addr << 1 ) | 1 );
+                    replyCrc = Crc8Block( replyCrc, reply, n );
+
+                    if ( n < msg->len )
+                    {
+                        buf[ n++ ] = EmuFault( gCrcPerMille ) ? ~replyCrc : replyCrc;
+                    }
+                }
+            }
+
+            // Once the slave runs out of data the bus floats high
+
+            memset( &buf[ n ], 0xFF, msg->len - n );
+            replyAddr = -1;
+        }
+    }
+    bits++;  // stop
+
+    busyUsec += gBusHz ? bits * 1000000u / gBusHz : 0;
+    gStats.busUsec += busyUsec;
+
+    pthread_mutex_unlock( &gEmuLock );
+
+    EmuDelay( busyUsec + gExtraUsec );
+
+    return rdwr->nmsgs;
+
+} // EmuBackend
+
+//***************************************************************************
+/**
+*   Mirrors ProcessCommand from robostix/i2c-io/i2c-io.c. data holds what
+*   the master wrote (cmd, len, payload) and is overwritten with the reply.
+*   Returns the number of reply bytes.
+*/
+
+static int EmuProcessCommand( uint8_t *data, int len, unsigned *busyUsec )
+{
+    uint8_t cmd = data[ 0 ];
+    uint8_t portNum = data[ 2 ];
+
+    if ( portNum >= NUM_PORTS )
+    {
+        portNum = 0;
+    }
+
+    switch ( cmd )
+    {
+        case I2C_IO_GET_INFO:
+        {
+            data[ 0 ] = 4;
+            data[ 1 ] = I2C_IO_API_VERSION;
+            data[ 2 ] = I2C_IO_API_MIN_VERSION;
+            data[ 3 ] = 0;
+            data[ 4 ] = 0;
+            return 5;
+        }
+
+        case I2C_IO_GET_GPIO:
+        {
+            uint8_t ddr = gMem[ gDdrReg[ portNum ]];
+
+            gMem[ gPinReg[ portNum ]] = ( gMem[ gPortReg[ portNum ]] & ddr )
+                                      | ( gInputs[ portNum ] & ~ddr );
+            data[ 0 ] = 1;
+            data[ 1 ] = gMem[ gPinReg[ portNum ]];
+            return 2;
+        }
+
+        case I2C_IO_SET_GPIO:
+        {
+            uint8_t pinMask = data[ 3 ];
+            uint8_t pinVal  = data[ 4 ];
+
+            gMem[ gPortReg[ portNum ]] &= ~pinMask;
+            gMem[ gPortReg[ portNum ]] |= ( pinVal & pinMask );
+            return 0;
+        }
+
+        case I2C_IO_GET_GPIO_DIR:
+        {
+            data[ 0 ] = 1;
+            data[ 1 ] = gMem[ gDdrReg[ portNum ]];
+            return 2;
+        }
+
+        case I2C_IO_SET_GPIO_DIR:
+        {
+            uint8_t pinMask = data[ 3 ];
+            uint8_t pinVal  = data[ 4 ];
+
+            gMem[ gDdrReg[ portNum ]] &= ~pinMask;
+            gMem[ gDdrReg[ portNum ]] |= ( pinVal & pinMask );
+            return 0;
+        }
+
+        case I2C_IO_GET_ADC:
+        {
+            uint8_t  mux = data[ 2 ] & 0x1F;
+            uint16_t adcVal = gAdc[ mux ];
+
+            // Unless the sampler has it, the AVR busy-waits for the
+            // conversion, stretching the clock
+
+            if (( mux >= 8 ) || (( gAdcSampled & ( 1 << mux )) == 0 ))
+            {
+                *busyUsec += ADC_CONV_USEC;
+            }
+
+            gMem[ REG_ADCL ] = adcVal & 0xFF;
+            gMem[ REG_ADCH ] = adcVal >> 8;
+
+            data[ 0 ] = 2;
+            data[ 1 ] = gMem[ REG_ADCL ];
+            data[ 2 ] = gMem[ REG_ADCH ];
+            return 3;
+        }
+
+        case I2C_IO_GET_ADC_MULTI:
+        {
+            uint8_t mask = data[ 2 ];
+            uint8_t len = 0;
+            uint8_t mux;
+
+            for ( mux = 0; mux < I2C_IO_NUM_ADC; mux++ )
+            {
+                if ( mask & ( 1 << mux ))
+                {
+                    uint16_t adcVal = gAdc[ mux ];
+
+                    if (( gAdcSampled & ( 1 << mux )) == 0 )
+                    {
+                        *busyUsec += ADC_CONV_USEC;
+                    }
+
+                    data[ len + 1 ] = adcVal & 0xFF;
+                    data[ len + 2 ] = adcVal >> 8;
+                    len += 2;
+                }
+            }
+            data[ 0 ] = len;
+            return len + 1;
+        }
+
+        case I2C_IO_FIFO_CONFIG:
+        {
+            gFifoMask     = data[ 2 ];
+            gFifoPeriodMs = data[ 3 ];
+            gFifoOverflow = 0;
+            gFifoGet = gFifoPut = 0;
+            gFifoNextMs   = EmuMsTick() + gFifoPeriodMs;
+            return 0;
+        }
+
+        case I2C_IO_FIFO_READ:
+        {
+            uint8_t maxSamples = data[ 2 ];
+            uint8_t len = sizeof( I2C_IO_FifoHdr_t );
+
+            EmuFifoFill();
+
+            if ( maxSamples > I2C_IO_FIFO_MAX_READ )
+            {
+                maxSamples = I2C_IO_FIFO_MAX_READ;
+            }
+            while (( maxSamples-- > 0 ) && ( gFifoGet != gFifoPut ))
+            {
+                I2C_IO_FifoSample_t *sample = &gFifo[ gFifoGet++ % FIFO_SIZE ];
+
+                data[ len + 1 ] = sample->tick & 0xFF;
+                data[ len + 2 ] = sample->tick >> 8;
+                data[ len + 3 ] = sample->source;
+                data[ len + 4 ] = sample->value & 0xFF;
+                data[ len + 5 ] = sample->value >> 8;
+                len += I2C_IO_FIFO_SAMPLE_LEN;
+            }
+            data[ 0 ] = len;
+            data[ 1 ] = gFifoPut - gFifoGet;
+            data[ 2 ] = gFifoOverflow;
+            gFifoOverflow = 0;
+            return len + 1;
+        }
+
+        case I2C_IO_READ_REG_8:
+        {
+            uint8_t reg = data[ 2 ];
+
+            data[ 0 ] = 1;
+            data[ 1 ] = gMem[ reg ];
+            return 2;
+        }
+
+        case I2C_IO_READ_REG_16:
+        {
+            uint8_t reg = data[ 2 ];
+
+            data[ 0 ] = 2;
+            data[ 1 ] = gMem[ reg ];
+            data[ 2 ] = gMem[ (uint8_t)( reg + 1 ) ];
+            return 3;
+        }
+
+        case I2C_IO_WRITE_REG_8:
+        {
+            gMem[ data[ 2 ]] = data[ 3 ];
+            return 0;
+        }
+
+        case I2C_IO_WRITE_REG_16:
+        {
+            // I2C_IO_WriteReg16_t is reg, pad, val (little endian)
+
+            uint8_t reg = data[ 2 ];
+
+            gMem[ (uint8_t)( reg + 1 ) ] = data[ 5 ];
+            gMem[ reg ] = data[ 4 ];
+            return 0;
+        }
+
+        case I2C_IO_WRITE_VAR:
+        {
+            // I2C_IO_WriteVar_t is packed on the AVR: var, val (little endian)
+
+            if ( data[ 2 ] < I2C_EMU_NUM_VARS )
+            {
+                gVars[ data[ 2 ]] = data[ 3 ] | ( data[ 4 ] << 8 );
+            }
+            return 0;
+        }
+
+        case I2C_IO_READ_VAR:
+        {
+            uint16_t val = ( data[ 2 ] < I2C_EMU_NUM_VARS ) ? gVars[ data[ 2 ]] : 0;
+
+            data[ 0 ] = 2;
+            data[ 1 ] = val & 0xFF;
+            data[ 2 ] = val >> 8;
+            return 3;
+        }
+
+        case I2C_IO_READ_VAR_MULTI:
+        {
+            uint8_t var[ I2C_IO_MAX_READ_VARS ];
+            uint8_t numVars = data[ 1 ];
+            uint8_t i;
+
+            if ( numVars > I2C_IO_MAX_READ_VARS )
+            {
+                numVars = I2C_IO_MAX_READ_VARS;
+            }
+            memcpy( var, &data[ 2 ], numVars );
+
+            for ( i = 0; i < numVars; i++ )
+            {
+                uint16_t val = ( var[ i ] < I2C_EMU_NUM_VARS ) ? gVars[ var[ i ]] : 0;
+
+                data[ 2 * i + 1 ] = val & 0xFF;
+                data[ 2 * i + 2 ] = val >> 8;
+            }
+            data[ 0 ] = 2 * numVars;
+            return 2 * numVars + 1;
+        }
+    }
+
+    LogError( "i2c-emu: Unrecognized command: 0x%02x\n", cmd );
+    return 0;
+
+} // EmuProcessCommand
+
+//***************************************************************************
+/**
+*   Handles a command sent to one of the encoder/steering boards. These
+*   don't use CRCs or block framing; values are sent MSB first.
+*/
+
+static int EmuEncoderCommand( int encNum, uint8_t *data, int len )
+{
+    switch ( data[ 0 ] )
+    {
+        case ENC_CMD_READ:
+        {
+            data[ 0 ] = gEnc[ encNum ] >> 8;
+            data[ 1 ] = gEnc[ encNum ] & 0xFF;
+            return 2;
+        }
+
+        case ENC_CMD_STEER:
+        {
+            if ( len >= 3 )
+            {
+                // The emulated steering servo reaches its target instantly
+
+                gSteer[ encNum ] = ( data[ 1 ] << 8 ) | data[ 2 ];
+                gEnc[ encNum ] = gSteer[ encNum ];
+            }
+            return 0;
+        }
+    }
+    return 0;
+
+} // EmuEncoderCommand
+
+//***************************************************************************
+/**
+*   Returns non-zero perMille times out of 1000.
+*/
+
+static int EmuFault( unsigned perMille )
+{
+    if ( perMille == 0 )
+    {
+        return 0;
+    }
+    return ( (unsigned)rand_r( &gRandSeed ) % 1000 ) < perMille;
+
+} // EmuFault
+
+//***************************************************************************
+/**
+*   Blocks the caller for the duration of the transaction, the same way
+*   the i2c-dev ioctl would.
+*/
+
+static void EmuDelay( unsigned usec )
+{
+    struct timespec ts;
+
+    if ( usec == 0 )
+    {
+        return;
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    ts.tv_nsec += ( usec % 1000000 ) * 1000;
+    ts.tv_sec  += usec / 1000000 + ts.tv_nsec / 1000000000;
+    ts.tv_nsec %= 1000000000;
+
+    while ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL ) == EINTR )
+    {
+        ;
+    }
+
+} // EmuDelay
+
+//***************************************************************************
+/**
+*   Returns a millisecond tick, standing in for gMsTickCount.
+*/
+
+static uint32_t EmuMsTick( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint32_t)( ts.tv_sec * 1000 + ts.tv_nsec / 1000000 );
+
+} // EmuMsTick
+
+//***************************************************************************
+/**
+*   Catches the sample FIFO up with the samples the robostix would have
+*   taken since the last time it was looked at.
+*/
+
+static void EmuFifoFill( void )
+{
+    uint32_t    now;
+    uint8_t     ch;
+
+    if ( gFifoPeriodMs == 0 )
+    {
+        return;
+    }
+    now = EmuMsTick();
+
+    while ((int32_t)( now - gFifoNextMs ) >= 0 )
+    {
+        for ( ch = 0; ch < I2C_IO_NUM_ADC; ch++ )
+        {
+            if (( gFifoMask & ( 1 << ch )) == 0 )
+            {
+                continue;
+            }
+            if ( gFifoPut - gFifoGet >= FIFO_SIZE )
+            {
+                if ( gFifoOverflow < 0xFF )
+                {
+                    gFifoOverflow++;
+                }
+                continue;
+            }
+            gFifo[ gFifoPut % FIFO_SIZE ].tick   = (uint16_t)gFifoNextMs;
+            gFifo[ gFifoPut % FIFO_SIZE ].source = I2C_IO_FIFO_SRC_ADC + ch;
+            gFifo[ gFifoPut % FIFO_SIZE ].value  = gAdc[ ch ];
+            gFifoPut++;
+        }
+        gFifoNextMs += gFifoPeriodMs;
+    }
+
+} // EmuFifoFill
+
@@ -0,0 +1,80 @@
+/****************************************************************************
+*
+*   Copyright (c) 2006 Dave Hylands     <dhylands@gmail.com>
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation.
+*
+*   Alternatively, this software may be distributed under the terms of BSD
+*   license.
+*
+*   See README and COPYING for more details.
+*
+****************************************************************************/
+/**
+*
+*   @file   i2c-emu.h
+*
+*   @brief  In-process stand-in for /dev/i2c-0 which emulates a robostix
+*           running i2c-io, plus the two encoder/steering boards.
+*
+****************************************************************************/
+
+#if !defined( I2C_EMU_H )
+#define I2C_EMU_H
+
+// ---- Include Files -------------------------------------------------------
+
+#include <inttypes.h>
+
+// ---- Constants and Types -------------------------------------------------
+
+#define I2C_EMU_IO_ADDR     0x0B    ///< Address of the emulated robostix
+#define I2C_EMU_ENC0_ADDR   0x36    ///< Address of encoder board 0
+#define I2C_EMU_ENC1_ADDR   0x3E    ///< Address of encoder board 1
+
+#define I2C_EMU_NUM_VARS    32      ///< Number of user variables emulated
+
+#define I2C_EMU_DEFAULT_HZ  100000  ///< Standard mode i2c clock
+
+#define I2C_EMU_ADC_SAMPLED 0x3F    ///< Matches CFG_ADC_SAMPLER_MASK in i2c-io
+
+/**
+ *  Running totals kept by the emulator.
+ */
+
+typedef struct
+{
+    unsigned    transactions;   ///< Number of I2C_RDWR transactions
+    unsigned    bytes;          ///< Bytes moved, including address bytes
+    unsigned    naks;           ///< Transactions which were NAKed
+    unsigned    crcErrors;      ///< Write CRCs which didn't match
+    unsigned    busUsec;        ///< Modelled bus time
+
+} I2C_EmuStats_t;
+
+// ---- Variable Externs ----------------------------------------------------
+
+// ---- Function Prototypes -------------------------------------------------
+
+int      I2cEmuOpen( void );
+void     I2cEmuClose( int i2cFd );
+
+void     I2cEmuSetBusSpeed( unsigned hz );
+void     I2cEmuSetExtraLatency( unsigned usec );
+void     I2cEmuSetFaults( unsigned nakPerMille, unsigned crcPerMille );
+
+void     I2cEmuSetADC( uint8_t mux, uint16_t adcVal );
+void     I2cEmuSetADCSampled( uint8_t mask );
+void     I2cEmuSetInputs( uint8_t portNum, uint8_t pinVal );
+void     I2cEmuSetEncoder( int encNum, uint16_t encVal );
+
+uint8_t  I2cEmuGetReg8( uint8_t reg );
+uint16_t I2cEmuGetReg16( uint8_t reg );
+int16_t  I2cEmuGetVar( uint8_t var );
+uint16_t I2cEmuGetSteer( int encNum );
+void     I2cEmuGetStats( I2C_EmuStats_t *stats );
+
+#endif  // I2C_EMU_H
+
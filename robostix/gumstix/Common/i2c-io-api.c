@@ -201,6 +201,60 @@ int I2C_IO_GetADC( int i2cDev, uint8_t mux, uint16_t *adcVal )
 
 } // I2C_IO_GetADC
 
+//***************************************************************************
+/**
+*   Samples each ADC channel selected in mask with a single transaction.
+*   adcVal is indexed by channel, and only the selected entries are
+*   written.
+*/
+
+int I2C_IO_GetADCMulti( int i2cDev, uint8_t mask, uint16_t adcVal[ I2C_IO_NUM_ADC ] )
+{
+    I2C_IO_Get_ADC_Multi_t  adcReq;
+    uint8_t                 reply[ 2 * I2C_IO_NUM_ADC ];
+    uint8_t                 replyLen = 0;
+    uint8_t                 bytesRead = 0;
+    uint8_t                 mux;
+    uint8_t                 i;
+
+    for ( mux = 0; mux < I2C_IO_NUM_ADC; mux++ )
+    {
+        if ( mask & ( 1 << mux ))
+        {
+            replyLen += 2;
+        }
+    }
+    if ( replyLen == 0 )
+    {
+        return TRUE;
+    }
+
+    adcReq.mask = mask;
+
+    if ( I2cProcessBlock( i2cDev, I2C_IO_GET_ADC_MULTI, &adcReq, sizeof( adcReq ), reply, replyLen, &bytesRead ) != 0 )
+    {
+        LogError( "I2C_IO_GetADCMulti: I2cProcessBlock failed: %s (%d)\n", strerror( errno ), errno );
+        return FALSE;
+    }
+    if ( bytesRead != replyLen )
+    {
+        LogError( "I2C_IO_GetADCMulti: expecting %d bytes, got %d\n", replyLen, bytesRead );
+        return FALSE;
+    }
+
+    i = 0;
+    for ( mux = 0; mux < I2C_IO_NUM_ADC; mux++ )
+    {
+        if ( mask & ( 1 << mux ))
+        {
+            adcVal[ mux ] = reply[ i ] | ( reply[ i + 1 ] << 8 );
+            i += 2;
+        }
+    }
+    return TRUE;
+
+} // I2C_IO_GetADCMulti
+
 //***************************************************************************
 /**
 *   Reads an 8 bit register.
@@ -289,3 +343,210 @@ int I2C_IO_WriteReg16( int i2cDev, uint8_t reg, uint16_t regVal )
 
 } // I2C_IO_WriteReg16
 
+//***************************************************************************
+/**
+*   Writes a user variable.
+*/
+
+int I2C_IO_WriteVar( int i2cDev, uint8_t var, uint16_t val )
+{
+    uint8_t writeVar[ 3 ];
+
+    // I2C_IO_WriteVar_t is packed on the AVR, but would be padded here,
+    // so it's built by hand (val is little endian).
+
+    writeVar[ 0 ] = var;
+    writeVar[ 1 ] = val & 0xFF;
+    writeVar[ 2 ] = ( val >> 8 ) & 0xFF;
+
+    if ( I2cWriteBlock( i2cDev, I2C_IO_WRITE_VAR, writeVar, sizeof( writeVar )) != 0 )
+    {
+        LogError( "I2C_IO_WriteVar: I2cWriteBlockFailed: %s (%d)\n", strerror( errno ), errno );
+        return FALSE;
+    }
+
+    return TRUE;
+
+} // I2C_IO_WriteVar
+
+//***************************************************************************
+/**
+*   Reads a user variable.
+*/
+
+int I2C_IO_ReadVar( int i2cDev, uint8_t var, uint16_t *val )
+{
+    I2C_IO_ReadVar_t    readVar;
+    uint8_t             bytesRead;
+
+    readVar.var = var;
+
+    if ( I2cProcessBlock( i2cDev, I2C_IO_READ_VAR, &readVar, sizeof( readVar ), val, sizeof( *val ), &bytesRead ) != 0 )
+    {
+        LogError( "I2C_IO_ReadVar: I2cProcessBlockFailed: %s (%d)\n", strerror( errno ), errno );
+        return FALSE;
+    }
+
+    return TRUE;
+
+} // I2C_IO_ReadVar
+
+//***************************************************************************
+/**
+*   Reads up to I2C_IO_MAX_READ_VARS user variables with a single
+*   transaction. val[ i ] is the value of var[ i ].
+*/
+
+int I2C_IO_ReadVarMulti( int i2cDev, const uint8_t *var, int numVars, uint16_t *val )
+{
+    I2C_IO_ReadVarMulti_t   readVar;
+    uint8_t                 reply[ 2 * I2C_IO_MAX_READ_VARS ];
+    uint8_t                 bytesRead = 0;
+    int                     i;
+
+    if (( numVars <= 0 ) || ( numVars > I2C_IO_MAX_READ_VARS ))
+    {
+        LogError( "I2C_IO_ReadVarMulti: can't read %d variables\n", numVars );
+        return FALSE;
+    }
+    memcpy( readVar.var, var, numVars );
+
+    if ( I2cProcessBlock( i2cDev, I2C_IO_READ_VAR_MULTI, &readVar, numVars, reply, 2 * numVars, &bytesRead ) != 0 )
+    {
+        LogError( "I2C_IO_ReadVarMulti: I2cProcessBlock failed: %s (%d)\n", strerror( errno ), errno );
+        return FALSE;
+    }
+    if ( bytesRead != 2 * numVars )
+    {
+        LogError( "I2C_IO_ReadVarMulti: expecting %d bytes, got %d\n", 2 * numVars, bytesRead );
+        return FALSE;
+    }
+
+    for ( i = 0; i < numVars; i++ )
+    {
+        val[ i ] = reply[ 2 * i ] | ( reply[ 2 * i + 1 ] << 8 );
+    }
+    return TRUE;
+
+} // I2C_IO_ReadVarMulti
+
+//***************************************************************************
+/**
+*   Sets which ADC channels are streamed into the sample FIFO, and how
+*   often. A periodMs of 0 stops sampling. Either way the FIFO is emptied.
+*/
+
+int I2C_IO_FifoConfig( int i2cDev, uint8_t adcMask, uint8_t periodMs )
+{
+    I2C_IO_FifoConfig_t fifoConfig;
+
+    fifoConfig.adcMask  = adcMask;
+    fifoConfig.periodMs = periodMs;
+
+    if ( I2cWriteBlock( i2cDev, I2C_IO_FIFO_CONFIG, &fifoConfig, sizeof( fifoConfig )) != 0 )
+    {
+        LogError( "I2C_IO_FifoConfig: I2cWriteBlockFailed: %s (%d)\n", strerror( errno ), errno );
+        return FALSE;
+    }
+
+    return TRUE;
+
+} // I2C_IO_FifoConfig
+
+//***************************************************************************
+/**
+*   Drains up to maxSamples samples from the sample FIFO, oldest first.
+*
+*   A single FIFO_READ is issued first to find out how many samples are
+*   waiting, then the rest are collected with batches of up to
+*   I2C_MAX_BATCH reads per bus transaction. overflow is set to the number
+*   of samples the robostix had to drop since the previous drain.
+*
+*   Samples which were read before a failure are still returned in
+*   sample/numSamples.
+*/
+
+int I2C_IO_FifoRead( int i2cDev, I2C_IO_FifoSample_t *sample, int maxSamples, int *numSamples, unsigned *overflow )
+{
+    I2C_Xfer_t          xfer[ I2C_MAX_BATCH ];
+    I2C_IO_FifoRead_t   fifoRead[ I2C_MAX_BATCH ];
+    uint8_t             reply[ I2C_MAX_BATCH ][ sizeof( I2C_IO_FifoHdr_t ) + I2C_IO_FIFO_MAX_READ * I2C_IO_FIFO_SAMPLE_LEN ];
+    int                 numXfers = 1;
+    int                 remaining = 0;
+    int                 i;
+    int                 rc = TRUE;
+
+    *numSamples = 0;
+    *overflow = 0;
+
+    while ( *numSamples < maxSamples )
+    {
+        int want = maxSamples - *numSamples;
+
+        for ( i = 0; i < numXfers; i++ )
+        {
+            fifoRead[ i ].maxSamples = ( want > I2C_IO_FIFO_MAX_READ ) ? I2C_IO_FIFO_MAX_READ : want;
+            want -= fifoRead[ i ].maxSamples;
+
+            xfer[ i ].i2cDev = i2cDev;
+            xfer[ i ].cmd    = I2C_IO_FIFO_READ;
+            xfer[ i ].wrData = &fifoRead[ i ];
+            xfer[ i ].wrLen  = 0x80 | sizeof( fifoRead[ i ] );
+            xfer[ i ].rdData = reply[ i ];
+            xfer[ i ].rdLen  = 0x80 | sizeof( reply[ i ] );
+        }
+
+        if ( I2cTransferBatch( xfer, numXfers ) != 0 )
+        {
+            LogError( "I2C_IO_FifoRead: I2cTransferBatch failed: %s (%d)\n", strerror( errno ), errno );
+            rc = FALSE;
+        }
+
+        remaining = 0;
+        for ( i = 0; i < numXfers; i++ )
+        {
+            const uint8_t  *data = &reply[ i ][ sizeof( I2C_IO_FifoHdr_t ) ];
+            int             count;
+
+            if (( xfer[ i ].rc != 0 ) || ( xfer[ i ].bytesRead < sizeof( I2C_IO_FifoHdr_t )))
+            {
+                rc = FALSE;
+                continue;
+            }
+            remaining  = reply[ i ][ 0 ];
+            *overflow += reply[ i ][ 1 ];
+
+            count = ( xfer[ i ].bytesRead - sizeof( I2C_IO_FifoHdr_t )) / I2C_IO_FIFO_SAMPLE_LEN;
+            while (( count-- > 0 ) && ( *numSamples < maxSamples ))
+            {
+                sample[ *numSamples ].tick   = data[ 0 ] | ( data[ 1 ] << 8 );
+                sample[ *numSamples ].source = data[ 2 ];
+                sample[ *numSamples ].value  = data[ 3 ] | ( data[ 4 ] << 8 );
+                (*numSamples)++;
+                data += I2C_IO_FIFO_SAMPLE_LEN;
+            }
+        }
+
+        if ( !rc || ( remaining == 0 ))
+        {
+            break;
+        }
+
+        // Size the next batch to cover what's left
+
+        want = maxSamples - *numSamples;
+        if ( want > remaining )
+        {
+            want = remaining;
+        }
+        numXfers = ( want + I2C_IO_FIFO_MAX_READ - 1 ) / I2C_IO_FIFO_MAX_READ;
+        if ( numXfers > I2C_MAX_BATCH )
+        {
+            numXfers = I2C_MAX_BATCH;
+        }
+    }
+
+    return rc;
+
+} // I2C_IO_FifoRead
+
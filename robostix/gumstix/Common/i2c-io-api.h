@@ -43,10 +43,16 @@ int I2C_IO_SetGPIO( int i2cDev, uint8_t portNum, uint8_t pinMask, uint8_t pinVal
 int I2C_IO_GetGPIODir( int i2cDev, uint8_t portNum, uint8_t *pinVal );
 int I2C_IO_SetGPIODir( int i2cDev, uint8_t portNum, uint8_t pinMask, uint8_t pinVal );
 int I2C_IO_GetADC( int i2cDev, uint8_t mux, uint16_t *adcVal );
+int I2C_IO_GetADCMulti( int i2cDev, uint8_t mask, uint16_t adcVal[ I2C_IO_NUM_ADC ] );
 int I2C_IO_ReadReg8( int i2cDev, uint8_t reg, uint8_t *regVal );
 int I2C_IO_ReadReg16( int i2cDev, uint8_t reg, uint16_t *regVal );
 int I2C_IO_WriteReg8( int i2cDev, uint8_t reg, uint8_t regVal );
 int I2C_IO_WriteReg16( int i2cDev, uint8_t reg, uint16_t regVal );
+int I2C_IO_WriteVar( int i2cDev, uint8_t var, uint16_t val );
+int I2C_IO_ReadVar( int i2cDev, uint8_t var, uint16_t *val );
+int I2C_IO_ReadVarMulti( int i2cDev, const uint8_t *var, int numVars, uint16_t *val );
+int I2C_IO_FifoConfig( int i2cDev, uint8_t adcMask, uint8_t periodMs );
+int I2C_IO_FifoRead( int i2cDev, I2C_IO_FifoSample_t *sample, int maxSamples, int *numSamples, unsigned *overflow );
 
 #endif  // I2C_IO_API_H
 
@@ -43,6 +43,7 @@
 
 int main( int argc, char **argv )
 {
+    int                 i2cFd;
     int                 i2cDev;
     const char         *i2cDevName = "/dev/i2c-0";
     time_t              prevTime;
@@ -51,13 +52,13 @@ int main( int argc, char **argv )
 
     LogInit( stdout );
 
-    if (( i2cDev = open( i2cDevName, O_RDWR )) < 0 )
+    if (( i2cFd = open( i2cDevName, O_RDWR )) < 0 )
     {
         LogError( "Error  opening '%s': %s\n", i2cDevName, strerror( errno ));
         exit( 1 );
     }
 
-    I2cSetSlaveAddress( i2cDev, 0x0B, I2C_USE_CRC );
+    i2cDev = I2cSlaveHandle( i2cFd, 0x0B, I2C_USE_CRC );
 
     // Wait for the time to roll over
 
@@ -84,7 +85,7 @@ int main( int argc, char **argv )
     }
     printf( "Retrieved %d ADC values in 10 seconds\n", count );
 
-    close( i2cDev );
+    close( i2cFd );
 
     return 0;
 }
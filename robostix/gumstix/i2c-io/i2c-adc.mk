@@ -23,6 +23,7 @@ vpath %.c $(COMMON) $(SHARED)
 
 CPPFLAGS += -I . -I $(COMMON) -I $(SHARED)
 CFLAGS	 += -Wall
+LDFLAGS  += -lrt
 
 TARGET_ARCH=-Os -march=armv5te -mtune=xscale -Wa,-mcpu=xscale
 CC = $(CROSS_COMPILE)gcc
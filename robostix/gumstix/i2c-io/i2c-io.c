@@ -375,6 +375,7 @@ int main( int argc, char **argv )
     struct option       *scanOpt;
     int                 opt;
     const char         *i2cDevName = "/dev/i2c-0";
+    int                 i2cFd;
     int                 i2cDev;
     int                 cmdIdx;
 
@@ -551,7 +552,7 @@ int main( int argc, char **argv )
 
     // Try to open the i2c device
 
-    if (( i2cDev = open( i2cDevName, O_RDWR )) < 0 )
+    if (( i2cFd = open( i2cDevName, O_RDWR )) < 0 )
     {
         LogError( "Error  opening '%s': %s\n", i2cDevName, strerror( errno ));
         exit( 1 );
@@ -559,7 +560,7 @@ int main( int argc, char **argv )
 
     // Indicate which slave we wish to speak to
 
-    I2cSetSlaveAddress( i2cDev, gI2cAddr, I2C_USE_CRC );
+    i2cDev = I2cSlaveHandle( i2cFd, gI2cAddr, I2C_USE_CRC );
 
     switch ( gCmd )
     {
@@ -606,7 +607,7 @@ int main( int argc, char **argv )
         }
     }
 
-    close( i2cDev );
+    close( i2cFd );
 
     return 0;
 
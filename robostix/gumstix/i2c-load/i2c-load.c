@@ -221,6 +221,7 @@ int main( int argc, char **argv )
     int                 opt;
     FILE_Data_t        *fileData = NULL;
     const char         *i2cDevName = "/dev/i2c-0";
+    int                 i2cFd;
     int                 i2cDev;
     BootLoaderInfo_t    bootInfo;
     int                 cmdIdx;
@@ -508,7 +509,7 @@ int main( int argc, char **argv )
 
     // Try to open the i2c device
 
-    if (( i2cDev = open( i2cDevName, O_RDWR )) < 0 )
+    if (( i2cFd = open( i2cDevName, O_RDWR )) < 0 )
     {
         LogError( "Error  opening '%s': %s\n", i2cDevName, strerror( errno ));
         exit( 1 );
@@ -516,14 +517,14 @@ int main( int argc, char **argv )
 
     if ( gCmd == CMD_SCAN )
     {
-        ProcessScanCmd( i2cDev );
-        close( i2cDev );
+        ProcessScanCmd( i2cFd );
+        close( i2cFd );
         exit( 1 );
     }
 
     // Indicate which slave we wish to speak to
 
-    I2cSetSlaveAddress( i2cDev, gI2cAddr, I2C_USE_CRC );
+    i2cDev = I2cSlaveHandle( i2cFd, gI2cAddr, I2C_USE_CRC );
 
     if ( gSerialLog )
     {
@@ -735,7 +736,7 @@ int main( int argc, char **argv )
         }
 
     }
-    close( i2cDev );
+    close( i2cFd );
 
     return 0;
 
@@ -883,11 +884,9 @@ void ProcessScanCmd( int i2cDev )
 
         // We've found something. See if it's running the Robostix Bootloader
 
-        I2cSetSlaveAddress( i2cDev, i2cAddr, I2C_USE_CRC );
-
-        if ( !BootLoaderGetInfo( i2cDev, &bootInfo ))
+        if ( !BootLoaderGetInfo( I2cSlaveHandle( i2cDev, i2cAddr, I2C_USE_CRC ), &bootInfo ))
         {
-            LogError( "Unable to retrieve boot information from i2c address 0x%02x\n", gI2cAddr );
+            LogError( "Unable to retrieve boot information from i2c address 0x%02x\n", i2cAddr );
             continue;
         }
 
@@ -176,6 +176,7 @@ int main( int argc, char **argv )
     struct option       *scanOpt;
     int                 opt;
     const char         *i2cDevName = "/dev/i2c-0";
+    int                 i2cFd;
     int                 i2cDev;
     int                 cmdIdx;
 
@@ -393,7 +394,7 @@ int main( int argc, char **argv )
 
     // Try to open the i2c device
 
-    if (( i2cDev = open( i2cDevName, O_RDWR )) < 0 )
+    if (( i2cFd = open( i2cDevName, O_RDWR )) < 0 )
     {
         LogError( "Error  opening '%s': %s\n", i2cDevName, strerror( errno ));
         exit( 1 );
@@ -401,7 +402,7 @@ int main( int argc, char **argv )
 
     // Indicate which slave we wish to speak to
 
-    I2cSetSlaveAddress( i2cDev, gI2cAddr, I2C_NO_CRC );
+    i2cDev = I2cSlaveHandle( i2cFd, gI2cAddr, I2C_NO_CRC );
 
     switch ( gCmd )
     {
@@ -438,7 +439,7 @@ int main( int argc, char **argv )
         }
     }
 
-    close( i2cDev );
+    close( i2cFd );
 
     return 0;
 
@@ -43,6 +43,16 @@
 
 #define CFG_USE_ADC 1
 
+// Sample the ADC continuously from its interrupt so that GET_ADC and
+// processData don't wait for conversions. Channels 0-5 are Fenrir's gyros,
+// accelerometers and volt meter. Each sample averages 4 conversions, which
+// with the /128 prescaler gives each channel a fresh value every 2.5 msec.
+
+#define CFG_ADC_SAMPLER             1
+#define CFG_ADC_SAMPLER_MASK        0x3F
+#define CFG_ADC_OVERSAMPLE_SHIFT    2
+#define CFG_ADC_FILTER_SHIFT        0   // 1 - 6 adds an IIR low pass filter
+
 #define CFG_I2C_USE_CRC     1
 
 #define CFG_I2C_MASTER_USE_BOOTLOADER   1
@@ -56,6 +66,10 @@
 //#define CFG_TIMER0_INCLUDE "sensors.h"
 //#define CFG_TIMER0_MS_TICK processData()
 
+//Feeds the sample FIFO (I2C_IO_FIFO_CONFIG/READ) from the millisecond tick
+#define CFG_TIMER0_INCLUDE "sensor-fifo.h"
+#define CFG_TIMER0_MS_TICK SensorFifoTick()
+
 #endif  // CONFIG_H
 
 
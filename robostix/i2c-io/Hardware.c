@@ -101,6 +101,10 @@ void InitHardware( void )
             ;
     }
 
+#if CFG_ADC_SAMPLER
+    a2d_sampler_init();
+#endif
+
 #endif
     initSensors();
     InitTimer();
@@ -44,6 +44,7 @@
 #include "svn-version.h"
 
 #include "sensors.h"
+#include "sensor-fifo.h"
 
 /* ---- Public Variables -------------------------------------------------- */
 
@@ -118,6 +119,7 @@ volatile uint8_t *gPIN[ NUM_PORTS ] =
 #endif
 
 int ProcessCommand( I2C_Data_t *packet );
+static uint16_t SampleADC( uint8_t mux );
 
 /* ---- Functions --------------------------------------------------------- */
 
@@ -324,20 +326,11 @@ int ProcessCommand( I2C_Data_t *packet )
         {
             I2C_IO_Get_ADC_t    *req = (I2C_IO_Get_ADC_t *)&packet->m_data[ 2 ];    // +1 for cmd, +1 for len
             uint8_t              mux = req->mux;
-
-            // Set ADMUX but don't mess with REFS0 & REFS1
-
-            ADMUX = ( ADMUX & (( 1 << REFS1 ) | ( 1 << REFS0 ))) | mux;
-
-            // Start the conversion
-            ADCSR = ADCSR | ( 1 << ADSC );
-
-            // Wait for it to complete
-            while ( ADCSR & ( 1 << ADSC ));
+            uint16_t             adcVal = SampleADC( mux );
 
             packet->m_data[ 0 ] = 2;
-            packet->m_data[ 1 ] = ADCL;
-            packet->m_data[ 2 ] = ADCH;
+            packet->m_data[ 1 ] = (uint8_t)(  adcVal        & 0xFF );
+            packet->m_data[ 2 ] = (uint8_t)(( adcVal >> 8 ) & 0xFF );
 
             IO_LOG3( "GetADC mux:%d read 0x%02x%02x\n", mux, packet->m_data[ 2 ], packet->m_data[ 1 ]);
 
@@ -423,6 +416,84 @@ int ProcessCommand( I2C_Data_t *packet )
 
 		return 3;
 	}
+
+        case I2C_IO_GET_ADC_MULTI:
+        {
+            I2C_IO_Get_ADC_Multi_t *req = (I2C_IO_Get_ADC_Multi_t *)&packet->m_data[ 2 ];    // +1 for cmd, +1 for len
+            uint8_t                 mask = req->mask;
+            uint8_t                 len = 0;
+            uint8_t                 mux;
+
+            for ( mux = 0; mux < I2C_IO_NUM_ADC; mux++ )
+            {
+                if ( mask & ( 1 << mux ))
+                {
+                    uint16_t adcVal = SampleADC( mux );
+
+                    packet->m_data[ len + 1 ] = (uint8_t)(  adcVal        & 0xFF );
+                    packet->m_data[ len + 2 ] = (uint8_t)(( adcVal >> 8 ) & 0xFF );
+                    len += 2;
+                }
+            }
+            packet->m_data[ 0 ] = len;
+
+            IO_LOG2( "GetADCMulti mask:0x%02x len:%d\n", mask, len );
+
+            return len + 1; // + 1 for len
+        }
+
+        case I2C_IO_READ_VAR_MULTI:
+        {
+            I2C_IO_ReadVarMulti_t   req;
+            uint8_t                 numVars = packet->m_data[ 1 ];
+            uint8_t                 i;
+
+            if ( numVars > I2C_IO_MAX_READ_VARS )
+            {
+                numVars = I2C_IO_MAX_READ_VARS;
+            }
+
+            // The reply overwrites the request, so take a copy first
+
+            for ( i = 0; i < numVars; i++ )
+            {
+                req.var[ i ] = packet->m_data[ i + 2 ];   // +1 for cmd, +1 for len
+            }
+            for ( i = 0; i < numVars; i++ )
+            {
+                int16_t val = ( req.var[ i ] <= DRIVE_MODE ) ? global_vars[ req.var[ i ]] : 0;  // DRIVE_MODE is the last
+
+                packet->m_data[ 2 * i + 1 ] = (uint8_t)(  val        & 0xFF );
+                packet->m_data[ 2 * i + 2 ] = (uint8_t)(( val >> 8 ) & 0xFF );
+            }
+            packet->m_data[ 0 ] = 2 * numVars;
+
+            IO_LOG2( "ReadVarMulti numVars:%d\n", numVars );
+
+            return 2 * numVars + 1; // + 1 for len
+        }
+
+        case I2C_IO_FIFO_CONFIG:
+        {
+            I2C_IO_FifoConfig_t *req = (I2C_IO_FifoConfig_t *)&packet->m_data[ 2 ];   // +1 for cmd, +1 for len
+
+            IO_LOG2( "FifoConfig mask:0x%02x period:%d\n", req->adcMask, req->periodMs );
+
+            SensorFifoConfig( req->adcMask, req->periodMs );
+            return 0;
+        }
+
+        case I2C_IO_FIFO_READ:
+        {
+            I2C_IO_FifoRead_t   *req = (I2C_IO_FifoRead_t *)&packet->m_data[ 2 ];     // +1 for cmd, +1 for len
+            uint8_t              maxSamples = req->maxSamples;
+            uint8_t              len;
+
+            len = SensorFifoRead( &packet->m_data[ 1 ], maxSamples );
+            packet->m_data[ 0 ] = len;
+
+            return len + 1; // + 1 for len
+        }
     }
 
     // It wasn't one of our commands, see if it's a bootloader command.
@@ -436,3 +507,36 @@ int ProcessCommand( I2C_Data_t *packet )
 
 } // ProcessCommand
 
+//***************************************************************************
+/**
+*   Returns the value for the indicated mux setting, performing a
+*   conversion if the sampler isn't providing it.
+*/
+
+static uint16_t SampleADC( uint8_t mux )
+{
+#if CFG_ADC_SAMPLER
+
+    // The sampler already has the latest value for the channels it's
+    // configured for, and pauses itself for any others.
+
+    return a2d_sampled( mux );
+
+#else
+
+    // Set ADMUX but don't mess with REFS0 & REFS1
+
+    ADMUX = ( ADMUX & (( 1 << REFS1 ) | ( 1 << REFS0 ))) | mux;
+
+    // Start the conversion
+    ADCSR = ADCSR | ( 1 << ADSC );
+
+    // Wait for it to complete
+    while ( ADCSR & ( 1 << ADSC ));
+
+    return ADCW;
+
+#endif
+
+} // SampleADC
+
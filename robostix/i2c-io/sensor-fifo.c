@@ -0,0 +1,203 @@
+/****************************************************************************
+*
+*   Copyright (c) 2007 Dave Hylands     <dhylands@gmail.com>
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation.
+*
+*   Alternatively, this software may be distributed under the terms of BSD
+*   license.
+*
+*   See README and COPYING for more details.
+*
+****************************************************************************/
+/**
+*
+*   @file    sensor-fifo.c
+*
+*   @brief   Samples the configured sources at a fixed rate into a FIFO,
+*            so that the host can collect evenly spaced data with a few
+*            block reads instead of polling at the sample rate.
+*
+*            SensorFifoTick runs from the timer 0 interrupt (see
+*            CFG_TIMER0_MS_TICK in Config.h) and SensorFifoRead from the
+*            i2c interrupt, so the two never run at the same time.
+*
+*****************************************************************************/
+
+/* ---- Include Files ----------------------------------------------------- */
+
+#include <avr/io.h>
+#if defined( __AVR_LIBC_VERSION__ )
+#   include <avr/interrupt.h>
+#else
+#   include <avr/signal.h>
+#endif
+#include <inttypes.h>
+
+#include "Config.h"
+#include "CBUF.h"
+#include "Timer.h"
+#include "a2d.h"
+#include "i2c-io.h"
+#include "sensor-fifo.h"
+
+/* ---- Public Variables -------------------------------------------------- */
+/* ---- Private Constants and Types --------------------------------------- */
+
+#define gFifo_SIZE  SENSOR_FIFO_SIZE
+
+#if CFG_ADC_SAMPLER
+#   define  READ_ADC( ch )  a2d_sampled( ch )
+#else
+#   define  READ_ADC( ch )  a2d_10( ch )
+#endif
+
+/* ---- Private Variables ------------------------------------------------- */
+
+static volatile struct
+{
+    uint8_t             m_getIdx;
+    uint8_t             m_putIdx;
+    I2C_IO_FifoSample_t m_entry[ gFifo_SIZE ];
+
+} gFifo;
+
+static uint8_t  gAdcMask;
+static uint8_t  gPeriodMs;      // 0 = stopped
+static uint8_t  gElapsedMs;
+static uint8_t  gOverflow;
+
+/* ---- Private Function Prototypes --------------------------------------- */
+
+static void Push( uint16_t tick, uint8_t source, uint16_t value );
+
+/* ---- Functions --------------------------------------------------------- */
+
+/****************************************************************************/
+/**
+*   Sets what gets sampled and how often, and empties the FIFO.
+*/
+
+void SensorFifoConfig( uint8_t adcMask, uint8_t periodMs )
+{
+    uint8_t sreg = SREG;
+
+    cli();
+
+    gAdcMask   = adcMask;
+    gPeriodMs  = periodMs;
+    gElapsedMs = 0;
+    gOverflow  = 0;
+    CBUF_Init( gFifo );
+
+    SREG = sreg;
+
+} // SensorFifoConfig
+
+/****************************************************************************/
+/**
+*   Adds a sample to the FIFO, or counts it as lost if the FIFO is full.
+*/
+
+static void Push( uint16_t tick, uint8_t source, uint16_t value )
+{
+    volatile I2C_IO_FifoSample_t   *sample;
+
+    if ( CBUF_IsFull( gFifo ))
+    {
+        if ( gOverflow < 0xFF )
+        {
+            gOverflow++;
+        }
+        return;
+    }
+
+    sample = CBUF_GetPushEntryPtr( gFifo );
+    sample->tick   = tick;
+    sample->source = source;
+    sample->value  = value;
+    CBUF_AdvancePushIdx( gFifo );
+
+} // Push
+
+/****************************************************************************/
+/**
+*   Called once a millisecond. Takes a sample of each configured source
+*   every gPeriodMs ticks.
+*/
+
+void SensorFifoTick( void )
+{
+    uint16_t    tick;
+    uint8_t     ch;
+
+    if ( gPeriodMs == 0 )
+    {
+        return;
+    }
+    if ( ++gElapsedMs < gPeriodMs )
+    {
+        return;
+    }
+    gElapsedMs = 0;
+
+    tick = (uint16_t)gMsTickCount;
+
+    for ( ch = 0; ch < I2C_IO_NUM_ADC; ch++ )
+    {
+        if ( gAdcMask & ( 1 << ch ))
+        {
+            Push( tick, I2C_IO_FIFO_SRC_ADC + ch, READ_ADC( ch ));
+        }
+    }
+
+} // SensorFifoTick
+
+/****************************************************************************/
+/**
+*   Moves up to maxSamples samples into buf, preceded by an
+*   I2C_IO_FifoHdr_t, in the layout described for I2C_IO_FIFO_READ.
+*   Returns the number of bytes placed in buf.
+*/
+
+uint8_t SensorFifoRead( uint8_t *buf, uint8_t maxSamples )
+{
+    uint8_t     numSamples;
+    uint8_t     remaining;
+    uint8_t     len;
+
+    if ( maxSamples > I2C_IO_FIFO_MAX_READ )
+    {
+        maxSamples = I2C_IO_FIFO_MAX_READ;
+    }
+    numSamples = CBUF_Len( gFifo );
+    if ( numSamples > maxSamples )
+    {
+        numSamples = maxSamples;
+    }
+
+    len = sizeof( I2C_IO_FifoHdr_t );
+    while ( numSamples-- > 0 )
+    {
+        volatile I2C_IO_FifoSample_t   *sample = CBUF_GetPopEntryPtr( gFifo );
+
+        buf[ len++ ] = (uint8_t)(  sample->tick         & 0xFF );
+        buf[ len++ ] = (uint8_t)(( sample->tick >> 8 )  & 0xFF );
+        buf[ len++ ] = sample->source;
+        buf[ len++ ] = (uint8_t)(  sample->value        & 0xFF );
+        buf[ len++ ] = (uint8_t)(( sample->value >> 8 ) & 0xFF );
+
+        CBUF_AdvancePopIdx( gFifo );
+    }
+
+    remaining = CBUF_Len( gFifo );
+
+    buf[ 0 ] = remaining;
+    buf[ 1 ] = gOverflow;
+    gOverflow = 0;
+
+    return len;
+
+} // SensorFifoRead
@@ -0,0 +1,43 @@
+/****************************************************************************
+*
+*   Copyright (c) 2007 Dave Hylands     <dhylands@gmail.com>
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation.
+*
+*   Alternatively, this software may be distributed under the terms of BSD
+*   license.
+*
+*   See README and COPYING for more details.
+*
+****************************************************************************/
+/**
+*
+*   @file   sensor-fifo.h
+*
+*   @brief  Timestamped sample FIFO, filled from the millisecond tick and
+*           drained by I2C_IO_FIFO_READ.
+*
+****************************************************************************/
+
+#if !defined( SENSOR_FIFO_H )
+#define SENSOR_FIFO_H           /**< Include Guard                         */
+
+/* ---- Include Files ---------------------------------------------------- */
+
+#include <inttypes.h>
+
+/* ---- Constants and Types ---------------------------------------------- */
+
+#define SENSOR_FIFO_SIZE    64  ///< Number of samples, must be a power of 2
+
+/* ---- Variable Externs ------------------------------------------------- */
+
+/* ---- Function Prototypes ---------------------------------------------- */
+
+void    SensorFifoConfig( uint8_t adcMask, uint8_t periodMs );
+uint8_t SensorFifoRead( uint8_t *buf, uint8_t maxSamples );
+void    SensorFifoTick( void );
+
+#endif  // SENSOR_FIFO_H
@@ -20,7 +20,11 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "robot_log.h"
 #include "robot_queue.h"
 #include "robot_comm.h"
@@ -30,23 +34,132 @@
 #include "mod_i2c-io.h"
 
 #ifndef NOADC
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	adc_channel_config cfg;
+	int have_sent;          // nothing has been sent for the channel yet if 0
+	uint16_t last_sent;     // value carried by the last event
+	int dir;                // direction of the last change sent, -1, 0 or 1
+	unsigned int sent_ms;   // time of the last event
+	unsigned int due_ms;    // next time the channel should be sampled
+} adc_channel;
+
 //---------------------------------------------------------------------------//
 // Function Prototypes
 //
 static void *adc_thread_main(void *arg);
+static void adc_poll(robot_queue *q);
+static void adc_drain_fifo(robot_queue *q);
+static void adc_update(robot_queue *q, int ch, uint16_t raw, unsigned int now);
+static unsigned int now_msec();
 
 //---------------------------------------------------------------------------//
 // Private Globals
 //
 static pthread_t tid = 0; // Thread ID of the adc thread
+static volatile int running = 0;
+static int use_fifo = 0; // the robostix is streaming into its sample FIFO
+static uint8_t enabled_mask = 0;
+static unsigned int fifo_period = 0; // ms between FIFO samples
+static unsigned int fifo_ms = 0;     // FIFO ticks extended to 32 bits
+static uint16_t fifo_tick = 0;
+static int fifo_started = 0;
+static int configured = 0;
+static adc_channel channels[ADC_CHANNELS];
 
 //---------------------------------------------------------------------------//
 // Public Function Implementations
 //
 
+int adc_configure(const char *spec) {
+	unsigned int vals[5];
+	adc_channel_config cfg;
+	char *end;
+	int n = 0;
+	int ch;
+
+	ch = strtol(spec, &end, 0);
+	if (end == spec || *end != ':' || ch < 0 || ch >= ADC_CHANNELS) {
+		return 0;
+	}
+	if (strcmp(end + 1, "off") == 0) {
+		memset(&cfg, 0, sizeof(cfg));
+	} else {
+		vals[1] = ADC_DEFAULT_DEADBAND;
+		vals[2] = ADC_DEFAULT_HYSTERESIS;
+		vals[3] = ADC_DEFAULT_MIN_INTERVAL;
+		while (*end == ':' && n < 4) {
+			spec = end + 1;
+			vals[n++] = strtoul(spec, &end, 0);
+			if (end == spec) {
+				return 0;
+			}
+		}
+		if (*end != '\0' || vals[0] == 0 || vals[0] > 1000) {
+			return 0;
+		}
+		cfg.enabled = 1;
+		cfg.rate = vals[0];
+		cfg.deadband = vals[1];
+		cfg.hysteresis = vals[2];
+		cfg.min_interval = vals[3];
+	}
+
+	// the first -a replaces the built in defaults
+	if (!configured) {
+		memset(channels, 0, sizeof(channels));
+		configured = 1;
+	}
+	channels[ch].cfg = cfg;
+	return 1;
+}
+
 int adc_thread_create(robot_queue *q) {
+	int i;
+
+	if (!configured) {
+		memset(channels, 0, sizeof(channels));
+		for(i = 0; i < ADC_COUNT; i++) {
+			channels[i].cfg.enabled = 1;
+			channels[i].cfg.rate = ADC_DEFAULT_RATE;
+			channels[i].cfg.deadband = ADC_DEFAULT_DEADBAND;
+			channels[i].cfg.hysteresis = ADC_DEFAULT_HYSTERESIS;
+			channels[i].cfg.min_interval = ADC_DEFAULT_MIN_INTERVAL;
+		}
+	}
+
+	// the FIFO samples every enabled channel at the fastest rate asked for,
+	// slower channels skip samples
+	enabled_mask = 0;
+	fifo_period = 1000;
+	for(i = 0; i < ADC_CHANNELS; i++) {
+		channels[i].have_sent = 0;
+		channels[i].dir = 0;
+		channels[i].due_ms = 0;
+		if (channels[i].cfg.enabled) {
+			enabled_mask |= 1 << i;
+			if (1000 / channels[i].cfg.rate < fifo_period) {
+				fifo_period = 1000 / channels[i].cfg.rate;
+			}
+		}
+	}
+	if (fifo_period < 1) {
+		fifo_period = 1;
+	}
+	if (fifo_period > 255) {
+		fifo_period = 255;
+	}
+	if (enabled_mask == 0) {
+		return 1; // nothing to watch
+	}
+
+	running = 1;
+
 	// create the thread
 	if(pthread_create(&tid, NULL, adc_thread_main, q) != 0) {
+		running = 0;
 		return 0;
 	}
 	return 1; // exit true
@@ -58,14 +171,18 @@ int adc_thread_destroy() {
 		return 0;
 	}
 
-	// kill the thread
-	if (pthread_cancel(tid) != 0) {
-		return 0;
-	}
-	// reap the thread
+	// stop the thread at the end of its current cycle rather than
+	// cancelling it, which could leave the bus lock held
+	running = 0;
 	if (pthread_join(tid, NULL) != 0) {
 		return 0;
 	}
+	tid = 0;
+
+	if(use_fifo) {
+		fifoConfig(0, 0);
+		use_fifo = 0;
+	}
 	return 1;
 
 }
@@ -75,28 +192,154 @@ int adc_thread_destroy() {
 //
 
 void *adc_thread_main(void *arg) {
-	unsigned char ADCVals[8] = {127,127,127,127,127,127,127,127};
-	int inval;
 	robot_queue *q = (robot_queue *)arg;
-	robot_event ev;
+	sigset_t signal_mask;
+
+	// termination and dump signals belong to the main thread, and getADC
+	// must not be interrupted by a handler while it holds the bus lock
+	sigemptyset(&signal_mask);
+	sigaddset(&signal_mask, SIGINT);
+	sigaddset(&signal_mask, SIGTERM);
+	sigaddset(&signal_mask, SIGHUP);
+	sigaddset(&signal_mask, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &signal_mask, NULL);
+
+	fifo_started = 0;
+	use_fifo = fifoConfig(enabled_mask, fifo_period);
+	if(!use_fifo) {
+		log_string(-1, "No sample FIFO on the robostix, polling the ADCs");
+	}
+
+	while(running) {
+		if(use_fifo) {
+			//Let samples pile up on the robostix, then collect them all
+			usleep(ADC_FIFO_DRAIN_INTERVAL);
+			adc_drain_fifo(q);
+		} else {
+			adc_poll(q);
+		}
+	}
+	return NULL;
+}
+
+//Waits for the next channel to come due, then reads every channel that is
+//due with one bus transaction
+static void adc_poll(robot_queue *q) {
+	uint16_t raw[ADC_CHANNELS];
+	unsigned int now = now_msec();
+	int wait = 1000;
+	uint8_t mask = 0;
 	int i;
-	ev.command = ROBOT_EVENT_ADC;
 
-	//Waits the polling interval, then polls all ADC's in use
-	//Via ADC_COUNT (in adc.h) 
-	while(1) {
-		usleep(POLL_INTERVAL);	//Wait Polling Interval
-		for(i = 0; i < ADC_COUNT; i++) {
-			inval = getADC(i);
-			inval = inval >> 2;
-			if(inval != ADCVals[i]){
-				ADCVals[i] = (unsigned char)inval;
-				ev.index = i;
-				ev.value = ADCVals[i];
-				robot_queue_enqueue(q, &ev);
+	for(i = 0; i < ADC_CHANNELS; i++) {
+		if (channels[i].cfg.enabled && (int)(channels[i].due_ms - now) < wait) {
+			wait = (int)(channels[i].due_ms - now);
+		}
+	}
+	if (wait > 0) {
+		usleep(wait * 1000);
+		now = now_msec();
+	}
+
+	for(i = 0; i < ADC_CHANNELS; i++) {
+		if (channels[i].cfg.enabled && (int)(channels[i].due_ms - now) <= 0) {
+			mask |= 1 << i;
+			channels[i].due_ms += 1000 / channels[i].cfg.rate;
+			if ((int)(channels[i].due_ms - now) <= 0) {
+				// fell behind, don't try to catch up
+				channels[i].due_ms = now + 1000 / channels[i].cfg.rate;
 			}
 		}
 	}
-	return NULL;
+	if (mask == 0) {
+		return;
+	}
+
+	if(!getADCMulti(mask, raw)) {
+		return; //the bus failed, wait for the next round
+	}
+	for(i = 0; i < ADC_CHANNELS; i++) {
+		if (mask & (1 << i)) {
+			adc_update(q, i, raw[i], now);
+		}
+	}
+}
+
+//Collects everything in the robostix sample FIFO. Samples are judged by
+//the robostix tick they were taken at, so a whole batch arriving at once
+//is treated the same as if each had been polled.
+static void adc_drain_fifo(robot_queue *q) {
+	I2C_IO_FifoSample_t samples[ADC_FIFO_BATCH];
+	unsigned overflow;
+	adc_channel *c;
+	int i, n, ch;
+
+	do {
+		n = fifoRead(samples, ADC_FIFO_BATCH, &overflow);
+		if(overflow) {
+			log_string(-1, "ADC sample FIFO overflowed, %u samples lost", overflow);
+		}
+		for(i = 0; i < n; i++) {
+			ch = samples[i].source - I2C_IO_FIFO_SRC_ADC;
+			if(ch < 0 || ch >= ADC_CHANNELS || !channels[ch].cfg.enabled) {
+				continue;
+			}
+			if(!fifo_started) {
+				fifo_started = 1;
+				fifo_tick = samples[i].tick;
+			}
+			fifo_ms += (uint16_t)(samples[i].tick - fifo_tick);
+			fifo_tick = samples[i].tick;
+
+			c = &channels[ch];
+			if((int)(c->due_ms - fifo_ms) > 0 && c->have_sent) {
+				continue; // channel sampled slower than the FIFO
+			}
+			c->due_ms = fifo_ms + 1000 / c->cfg.rate;
+			adc_update(q, ch, samples[i].value, fifo_ms);
+		}
+	} while(n == ADC_FIFO_BATCH && running);
+}
+
+//Queues an ADC event if a channel's reading has changed enough, and long
+//enough after the last one
+static void adc_update(robot_queue *q, int ch, uint16_t raw, unsigned int now) {
+	adc_channel *c = &channels[ch];
+	robot_event ev;
+	int delta, dir;
+	unsigned int need;
+
+	if(c->have_sent) {
+		delta = (int)raw - (int)c->last_sent;
+		dir = delta > 0 ? 1 : -1;
+		need = c->cfg.deadband;
+		if(c->dir != 0 && dir != c->dir) {
+			need += c->cfg.hysteresis;
+		}
+		if(delta == 0 || (unsigned int)abs(delta) <= need) {
+			return;
+		}
+		if(now - c->sent_ms < c->cfg.min_interval) {
+			return; // sent on a later sample if it is still this far off
+		}
+		c->dir = dir;
+	}
+
+	c->have_sent = 1;
+	c->last_sent = raw;
+	c->sent_ms = now;
+
+	ev.command = ROBOT_EVENT_ADC;
+	ev.index = ch;
+	ev.value = raw;
+	robot_queue_enqueue(q, &ev);
+}
+
+//Milliseconds on the monotonic clock, which setting the clock doesn't move.
+//Wraps, so only differences mean anything.
+static unsigned int now_msec() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned int)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 #endif
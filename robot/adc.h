@@ -23,10 +23,38 @@
 
 //#define NO_ADC   //To eliminate ADC code
 
-#define ADC_COUNT 1 //Number of ADC's to poll, cant remember if its 0 or 1 indexed
-
-#define POLL_INTERVAL 1000000/50  //50Hz polling interval
-
+#define ADC_COUNT 1 //Channels 0 to ADC_COUNT-1 are enabled unless configured otherwise
+#define ADC_CHANNELS 8 //ADC inputs on the robostix
+
+//Defaults for enabled channels, see adc_configure
+#define ADC_DEFAULT_RATE 50 //Hz
+#define ADC_DEFAULT_DEADBAND 3 //LSB of change ignored
+#define ADC_DEFAULT_HYSTERESIS 2 //extra LSB needed to reverse direction
+#define ADC_DEFAULT_MIN_INTERVAL 20 //ms between events
+
+//When the robostix has a sample FIFO the ADCs are sampled there at a fixed
+//rate and drained in batches instead of being polled
+#define ADC_FIFO_DRAIN_INTERVAL 1000000/20  //20Hz drain interval
+#define ADC_FIFO_BATCH 32  //Samples moved per fifoRead
+
+// Change detection settings for one channel. ROBOT_EVENT_ADC events carry
+// the full 10 bit reading, and one is only queued once the reading has
+// moved more than deadband from the last value sent. Moving back the other
+// way needs deadband + hysteresis, so a value sitting on a boundary can't
+// flip back and forth. Events for a channel are at least min_interval ms
+// apart; the latest reading goes out once the interval is over.
+typedef struct {
+	int enabled;
+	unsigned int rate;         // samples per second
+	unsigned int deadband;     // LSB
+	unsigned int hysteresis;   // LSB
+	unsigned int min_interval; // ms
+} adc_channel_config;
+
+// adc_configure - sets up a channel from a "-a" command line argument:
+// 	channel:rate[:deadband[:hysteresis[:min_interval]]] or channel:off
+// 	Must be called before adc_thread_create. Returns 0 if spec is invalid.
+extern int adc_configure(const char *spec);
 
 extern int adc_thread_create(robot_queue *q);
 extern int adc_thread_destroy(); 
@@ -0,0 +1,375 @@
+//    i2c_thread.c - owns the i2c bus and runs queued bus commands
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// i2c_thread.c
+//
+// The event dispatch loop must never wait on the bus: one NAKed or slow
+// transaction would hold up every motor event queued behind it. Handlers
+// instead queue bus commands here and a single worker thread carries them
+// out in order. Writes are fire-and-forget, reads report back through a
+// completion callback.
+//
+// The ADC thread (adc.c) still goes to the bus itself. It already runs off
+// the dispatch loop and only waits on its own reads, which it times to the
+// robostix's sample clock. Queuing them here would put those reads behind
+// motor writes and delay them. Both threads share the bus lock in
+// mod_i2c-io.c, so the bus is never used by two at once.
+//
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include "robot_log.h"
+#include "mod_i2c-io.h"
+#include "i2c_thread.h"
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	i2c_cmd_type type;
+	int a;              // motor, port, var or encoder number
+	int b;              // position, pin or direction
+	int c;              // pin value or variable data
+	i2c_read_cb cb;
+	void *arg;
+	uint8_t vars[I2C_READ_VARS_MAX]; // bulk read, a is the count
+	long long queued;   // time the command was queued (usec)
+} i2c_cmd;
+
+typedef struct {
+	unsigned int count;
+	long long wait_total;   // time spent in the queue (usec)
+	long long wait_max;
+	long long bus_total;    // time spent on the bus (usec)
+	long long bus_max;
+} i2c_cmd_stats;
+
+//---------------------------------------------------------------------------//
+// Private Function Prototypes
+//
+static void *i2c_thread_main(void *arg);
+static int merge_vars(i2c_cmd *queued, const i2c_cmd *cmd);
+static int i2c_enqueue(const i2c_cmd *cmd);
+static void i2c_execute(const i2c_cmd *cmd);
+static long long now_usec();
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static pthread_t tid = 0;  // Thread ID of the i2c thread
+static pthread_mutex_t qlock = PTHREAD_MUTEX_INITIALIZER; // queue and statistics
+static sem_t pending;      // counts commands waiting in the queue
+static volatile int running = 0;
+
+static i2c_cmd queue[I2C_QUEUE_SIZE];
+static int head_index = 0;
+static int length = 0;
+static unsigned int dropped = 0;
+
+static i2c_cmd_stats stats[I2C_CMD_COUNT];
+static const char *cmd_names[I2C_CMD_COUNT] = {
+	"motor", "pin", "set_var", "read_var", "steer", "read_vars"
+};
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+int i2c_thread_create() {
+	sem_init(&pending, 0, 0);
+	head_index = 0;
+	length = 0;
+	memset(stats, 0, sizeof(stats));
+	running = 1;
+
+	// create the thread
+	if(pthread_create(&tid, NULL, i2c_thread_main, NULL) != 0) {
+		running = 0;
+		return 0;
+	}
+	return 1; // exit true
+}
+
+int i2c_thread_destroy() {
+	if (tid <= 0) {
+		return 0;
+	}
+
+	// let the worker finish what is queued (e.g. the shutdown LEDs), then
+	// wake it so it sees the flag
+	running = 0;
+	sem_post(&pending);
+
+	// reap the thread
+	if (pthread_join(tid, NULL) != 0) {
+		return 0;
+	}
+	tid = 0;
+	return 1;
+}
+
+int i2c_async_set_motor(int motor, int position) {
+	i2c_cmd cmd;
+	cmd.type = I2C_CMD_MOTOR;
+	cmd.a = motor;
+	cmd.b = position;
+	return i2c_enqueue(&cmd);
+}
+
+int i2c_async_set_pin(uint8_t port, uint8_t pin, uint8_t value) {
+	i2c_cmd cmd;
+	cmd.type = I2C_CMD_PIN;
+	cmd.a = port;
+	cmd.b = pin;
+	cmd.c = value;
+	return i2c_enqueue(&cmd);
+}
+
+int i2c_async_set_variable(uint8_t var, short data) {
+	i2c_cmd cmd;
+	cmd.type = I2C_CMD_SET_VAR;
+	cmd.a = var;
+	cmd.c = data;
+	return i2c_enqueue(&cmd);
+}
+
+int i2c_async_steer(int encNumber, uint16_t direction) {
+	i2c_cmd cmd;
+	cmd.type = I2C_CMD_STEER;
+	cmd.a = encNumber;
+	cmd.b = direction;
+	return i2c_enqueue(&cmd);
+}
+
+int i2c_async_read_variable(uint8_t var, i2c_read_cb cb, void *arg) {
+	i2c_cmd cmd;
+	cmd.type = I2C_CMD_READ_VAR;
+	cmd.a = var;
+	cmd.cb = cb;
+	cmd.arg = arg;
+	return i2c_enqueue(&cmd);
+}
+
+int i2c_async_read_variables(const uint8_t *vars, int n, i2c_read_cb cb, void *arg) {
+	i2c_cmd cmd;
+	if (n <= 0 || n > I2C_READ_VARS_MAX) {
+		return 0;
+	}
+	cmd.type = I2C_CMD_READ_VARS;
+	cmd.a = n;
+	memcpy(cmd.vars, vars, n);
+	cmd.cb = cb;
+	cmd.arg = arg;
+	return i2c_enqueue(&cmd);
+}
+
+void i2c_thread_log_stats(int level) {
+	i2c_cmd_stats snap[I2C_CMD_COUNT];
+	unsigned int snap_dropped;
+	int depth;
+	int i;
+
+	pthread_mutex_lock(&qlock);
+	memcpy(snap, stats, sizeof(snap));
+	memset(stats, 0, sizeof(stats));
+	snap_dropped = dropped;
+	dropped = 0;
+	depth = length;
+	pthread_mutex_unlock(&qlock);
+
+	for(i = 0; i < I2C_CMD_COUNT; i++) {
+		if (snap[i].count == 0) {
+			continue;
+		}
+		log_string(level, "i2c %-8s n=%u wait avg/max=%lld/%lld us bus avg/max=%lld/%lld us",
+				cmd_names[i], snap[i].count,
+				snap[i].wait_total / snap[i].count, snap[i].wait_max,
+				snap[i].bus_total / snap[i].count, snap[i].bus_max);
+	}
+	if (snap_dropped) {
+		log_string(level, "i2c queue full, dropped %u commands (depth %d)", snap_dropped, depth);
+	}
+}
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// merge_vars - adds the variables of a bulk read to a queued one, if
+// 	they all fit
+static int merge_vars(i2c_cmd *queued, const i2c_cmd *cmd) {
+	uint8_t vars[I2C_READ_VARS_MAX];
+	int n = queued->a;
+	int i, j;
+
+	memcpy(vars, queued->vars, n);
+	for(i = 0; i < cmd->a; i++) {
+		for(j = 0; j < n && vars[j] != cmd->vars[i]; j++)
+			;
+		if (j == n) {
+			if (n == I2C_READ_VARS_MAX) {
+				return 0;
+			}
+			vars[n++] = cmd->vars[i];
+		}
+	}
+	memcpy(queued->vars, vars, n);
+	queued->a = n;
+	return 1;
+}
+
+static int i2c_enqueue(const i2c_cmd *cmd) {
+	int i, idx;
+
+	if (!running) {
+		return 0;
+	}
+	pthread_mutex_lock(&qlock);
+
+	// a newer position for a motor makes any queued one stale
+	if (cmd->type == I2C_CMD_MOTOR) {
+		for(i = 0; i < length; i++) {
+			idx = (head_index + i) % I2C_QUEUE_SIZE;
+			if (queue[idx].type == I2C_CMD_MOTOR && queue[idx].a == cmd->a) {
+				queue[idx].b = cmd->b;
+				pthread_mutex_unlock(&qlock);
+				return 1;
+			}
+		}
+	}
+
+	// so does a bulk read still waiting, as long as the variables fit
+	if (cmd->type == I2C_CMD_READ_VARS) {
+		for(i = 0; i < length; i++) {
+			idx = (head_index + i) % I2C_QUEUE_SIZE;
+			if (queue[idx].type == I2C_CMD_READ_VARS && queue[idx].cb == cmd->cb &&
+					merge_vars(&queue[idx], cmd)) {
+				pthread_mutex_unlock(&qlock);
+				return 1;
+			}
+		}
+	}
+
+	if (length >= I2C_QUEUE_SIZE) {
+		dropped++;
+		pthread_mutex_unlock(&qlock);
+		return 0;
+	}
+
+	idx = (head_index + length) % I2C_QUEUE_SIZE;
+	queue[idx] = *cmd;
+	queue[idx].queued = now_usec();
+	length++;
+	pthread_mutex_unlock(&qlock);
+
+	sem_post(&pending);
+	return 1;
+}
+
+void *i2c_thread_main(void *arg) {
+	sigset_t signal_mask;
+	i2c_cmd cmd;
+	long long start, end;
+	i2c_cmd_stats *s;
+
+	// termination and dump signals belong to the main thread
+	sigemptyset(&signal_mask);
+	sigaddset(&signal_mask, SIGINT);
+	sigaddset(&signal_mask, SIGTERM);
+	sigaddset(&signal_mask, SIGHUP);
+	sigaddset(&signal_mask, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &signal_mask, NULL);
+
+	while(1) {
+		sem_wait(&pending);
+
+		pthread_mutex_lock(&qlock);
+		if (length == 0) {
+			pthread_mutex_unlock(&qlock);
+			if (!running) {
+				break;
+			}
+			continue;
+		}
+		cmd = queue[head_index];
+		head_index = (head_index + 1) % I2C_QUEUE_SIZE;
+		length--;
+		pthread_mutex_unlock(&qlock);
+
+		start = now_usec();
+		i2c_execute(&cmd);
+		end = now_usec();
+
+		pthread_mutex_lock(&qlock);
+		s = &stats[cmd.type];
+		s->count++;
+		s->wait_total += start - cmd.queued;
+		if (start - cmd.queued > s->wait_max) {
+			s->wait_max = start - cmd.queued;
+		}
+		s->bus_total += end - start;
+		if (end - start > s->bus_max) {
+			s->bus_max = end - start;
+		}
+		pthread_mutex_unlock(&qlock);
+	}
+	return NULL;
+}
+
+static void i2c_execute(const i2c_cmd *cmd) {
+	signed short data;
+	signed short values[I2C_READ_VARS_MAX];
+	int i;
+
+	switch(cmd->type) {
+		case I2C_CMD_MOTOR:
+			setMotor(cmd->a, cmd->b);
+			break;
+		case I2C_CMD_PIN:
+			setPin(cmd->a, cmd->b, cmd->c);
+			break;
+		case I2C_CMD_SET_VAR:
+			setVariable(cmd->a, cmd->c);
+			break;
+		case I2C_CMD_READ_VAR:
+			if (readVariable(cmd->a, &data) && cmd->cb) {
+				cmd->cb(cmd->a, data, cmd->arg);
+			}
+			break;
+		case I2C_CMD_STEER:
+			steer(cmd->a, cmd->b);
+			break;
+		case I2C_CMD_READ_VARS:
+			if (readVariables(cmd->vars, cmd->a, values) && cmd->cb) {
+				for(i = 0; i < cmd->a; i++) {
+					cmd->cb(cmd->vars[i], values[i], cmd->arg);
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+static long long now_usec() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,72 @@
+//    i2c_thread.h - interface for the asynchronous i2c worker
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef I2C_THREAD_H
+#define I2C_THREAD_H
+
+#include <stdint.h>
+
+#define I2C_QUEUE_SIZE 64 //Number of bus commands that may be pending
+#define I2C_READ_VARS_MAX 15 //Variables in one bulk read, I2C_IO_MAX_READ_VARS
+
+// Kinds of bus commands, also used to index the latency statistics
+typedef enum {
+	I2C_CMD_MOTOR = 0,
+	I2C_CMD_PIN,
+	I2C_CMD_SET_VAR,
+	I2C_CMD_READ_VAR,
+	I2C_CMD_STEER,
+	I2C_CMD_READ_VARS,
+	I2C_CMD_COUNT
+} i2c_cmd_type;
+
+// Completion callback for reads. Runs on the i2c worker thread, so it
+// must not block for long (send_event and robot_queue_enqueue are fine).
+typedef void (*i2c_read_cb)(uint8_t var, signed short value, void *arg);
+
+// i2c_thread_create - starts the worker that owns the i2c bus.
+// 	init() must already have been called.
+extern int i2c_thread_create();
+
+// i2c_thread_destroy - finishes any pending commands and stops the worker
+extern int i2c_thread_destroy();
+
+// Fire-and-forget writes. Each returns 0 if the command could not be
+// queued, non-zero otherwise. A motor write replaces any write to the same
+// motor that is still waiting in the queue.
+extern int i2c_async_set_motor(int motor, int position);
+extern int i2c_async_set_pin(uint8_t port, uint8_t pin, uint8_t value);
+extern int i2c_async_set_variable(uint8_t var, short data);
+extern int i2c_async_steer(int encNumber, uint16_t direction);
+
+// i2c_async_read_variable - queues a variable read, cb is called with the
+// result once the bus transaction completes, and not at all if it fails
+extern int i2c_async_read_variable(uint8_t var, i2c_read_cb cb, void *arg);
+
+// i2c_async_read_variables - queues a read of up to I2C_READ_VARS_MAX
+// 	variables in one bus transaction, cb is called for each in turn unless
+// 	the transaction fails. If
+// 	a bulk read with the same cb is still waiting, the variables are added
+// 	to it instead.
+extern int i2c_async_read_variables(const uint8_t *vars, int n, i2c_read_cb cb, void *arg);
+
+// i2c_thread_log_stats - logs queue latency and bus time per command type
+// 	since the last call, then resets the counters
+extern void i2c_thread_log_stats(int level);
+
+#endif //!I2C_THREAD_H
@@ -32,14 +32,17 @@
 #include <signal.h>
 #include <unistd.h>
 #include <sys/timeb.h>
-#include <semaphore.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "AvrInfo.h"
 #include "i2c-dev.h"
 #include "i2c-api.h"
 #include "i2c-io-api.h"
+#include "i2c-emu.h"
 #include "BootLoader-api.h"
 #include "Log.h"
+#include "robot_log.h"
 #include "mod_i2c-io.h"
 
 // ---- Public Variables ----------------------------------------------------
@@ -171,62 +174,175 @@ enum
 
 
 
-static int i2cDev = -1;
-static sem_t i2clock;
+static int i2cFd = -1;
+static int i2cDev = -1;		//Handle for the robostix (0x0b, CRC)
+static int encDev[2] = {-1, -1};	//Handles for encoder boards 0 and 1 (no CRC)
+static int ioVersion = 0;		//I2C_IO_API_VERSION of the robostix firmware, 0 if unknown
+
+// The bus lock is a plain pthread mutex (a futex, so an uncontended
+// lock/unlock never enters the kernel). Signal safety is handled once at
+// thread setup instead of per call: every thread that uses these functions
+// blocks SIGINT/SIGTERM/SIGHUP when it starts, and the signal handlers
+// never touch the bus.
+static pthread_mutex_t i2clock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+	unsigned int count;      // number of times the lock was taken
+	unsigned int contended;  // times the lock was already held
+	long long wait_total;    // time spent waiting for the lock (usec)
+	long long wait_max;
+	long long hold_total;    // time spent holding the lock (usec)
+	long long hold_max;
+} i2c_lock_stats;
+
+static i2c_lock_stats lock_stats[I2C_CALLER_COUNT];
+static const char *caller_names[I2C_CALLER_COUNT] = {
+	"motor", "adc", "gpio", "var", "enc", "reg"
+};
+static long long hold_start;     // valid while the lock is held
+static i2c_caller hold_caller;
 
 // ---- Private Function Prototypes -----------------------------------------
 
 static void writeReg(int RevNum, int data);
 const char         *i2cDevName = "/dev/i2c-0";
 
-static int lock () {
-	sigset_t   signal_mask;  /* signals to block         */
-
-	// List of signals to block
-	sigemptyset (&signal_mask);
-	sigaddset (&signal_mask, SIGINT);
-	sigaddset (&signal_mask, SIGTERM);
-	sigaddset (&signal_mask, SIGHUP);
-	// Block signals and lock the queue
-	if (pthread_sigmask(SIG_BLOCK, &signal_mask, NULL) == 0) {
-		return !(sem_wait(&i2clock));
+static long long now_usec(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void lock (i2c_caller caller) {
+	long long start, waited;
+	i2c_lock_stats *st = &lock_stats[caller];
+
+	if (pthread_mutex_trylock(&i2clock) == 0) {
+		hold_start = now_usec();
 	} else {
-		return 0;
+		start = now_usec();
+		pthread_mutex_lock(&i2clock);
+		hold_start = now_usec();
+		waited = hold_start - start;
+		st->contended++;
+		st->wait_total += waited;
+		if (waited > st->wait_max)
+			st->wait_max = waited;
 	}
+	st->count++;
+	hold_caller = caller;
 }
-static int unlock () {
-	sigset_t   signal_mask;  /* signals to block         */
-
-	// List of signals to block
-	sigemptyset (&signal_mask);
-	sigaddset (&signal_mask, SIGINT);
-	sigaddset (&signal_mask, SIGTERM);
-	sigaddset (&signal_mask, SIGHUP);
-
-	// Unlock the queue and unblock signals
-	if (sem_post(&i2clock) == 0) {
-		return !pthread_sigmask(SIG_UNBLOCK, &signal_mask, NULL);
-	} else {
-		return 0;
+
+static void unlock () {
+	i2c_lock_stats *st = &lock_stats[hold_caller];
+	long long held = now_usec() - hold_start;
+
+	st->hold_total += held;
+	if (held > st->hold_max)
+		st->hold_max = held;
+	pthread_mutex_unlock(&i2clock);
+}
+
+//********************************************************************************
+/**
+ *	Logs bus lock statistics per caller since the last call, then resets them
+ */
+
+void i2c_lock_log_stats(int level){
+	i2c_lock_stats snap[I2C_CALLER_COUNT];
+	int i;
+
+	pthread_mutex_lock(&i2clock);
+	memcpy(snap, lock_stats, sizeof(snap));
+	memset(lock_stats, 0, sizeof(lock_stats));
+	pthread_mutex_unlock(&i2clock);
+
+	for(i = 0; i < I2C_CALLER_COUNT; i++){
+		if(snap[i].count == 0)
+			continue;
+		log_string(level, "i2c lock %-5s n=%u contended=%u wait avg/max=%lld/%lld us hold avg/max=%lld/%lld us",
+				caller_names[i], snap[i].count, snap[i].contended,
+				snap[i].contended ? snap[i].wait_total / snap[i].contended : 0,
+				snap[i].wait_max,
+				snap[i].hold_total / snap[i].count, snap[i].hold_max);
 	}
 }
 
 
 
+//********************************************************************************
+/**
+ *	Logs the i2c-api transaction profile (per command latency histograms and
+ *	error counts). Holds the bus lock so the numbers are consistent.
+ */
+
+void i2c_profile_dump(void){
+	pthread_mutex_lock(&i2clock);
+	I2cProfileDump();
+	pthread_mutex_unlock(&i2clock);
+}
+
+
+//********************************************************************************
+/**
+ *	Counts the failed transactions in the i2c-api profile. Only tries the
+ *	bus lock, so the caller is never held up by a slow transaction; if the
+ *	bus is busy the previous count is returned.
+ */
+
+unsigned i2cErrors(void){
+	static I2C_ProfEntry_t prof[I2C_PROF_SLOTS];
+	static unsigned errors = 0;
+	int n, i, j;
+	if(pthread_mutex_trylock(&i2clock) != 0)
+		return errors;
+	n = I2cProfileGet(prof, I2C_PROF_SLOTS);
+	pthread_mutex_unlock(&i2clock);
+	errors = 0;
+	for(i = 0; i < n; i++)
+		for(j = I2C_PROF_OK + 1; j < I2C_PROF_NUM_OUTCOMES; j++)
+			errors += prof[i].outcome[j];
+	return errors;
+}
+
+
+
 //********************************************************************************
 /**
  *	Initilization for i2c-io code
  */
 
 void init(int i2cslave){
-	sem_init(&i2clock,0,1);
-	lock();
-	if (( i2cDev = open( i2cDevName, O_RDWR )) < 0 )
+	const char *emu;
+	lock(I2C_CALLER_REG);
+	if (( emu = getenv( "ROBOT_I2C_EMU" )) != NULL )
+	{
+		// Run against the in-process emulator instead of the robostix.
+		// The value is the bus clock in Hz, empty for the default.
+		if (( i2cFd = I2cEmuOpen()) < 0 )
+			exit( 1 );
+		if ( *emu != '\0' )
+			I2cEmuSetBusSpeed( strtoul( emu, NULL, 0 ));
+	}
+	else if (( i2cFd = open( i2cDevName, O_RDWR )) < 0 )
 	{
 		LogError( "Error  opening '%s': %s\n", i2cDevName, strerror( errno ));
 		exit( 1 );
 	}
-	I2cSetSlaveAddress( i2cDev, 0x0b, I2C_USE_CRC );
+	// Each handle carries its own slave address, so talking to the encoder
+	// boards never requires switching the robostix address
+	i2cDev = I2cSlaveHandle( i2cFd, i2cslave, I2C_USE_CRC );
+	encDev[0] = I2cSlaveHandle( i2cFd, 0x36, I2C_NO_CRC );
+	encDev[1] = I2cSlaveHandle( i2cFd, 0x3E, I2C_NO_CRC );
+	I2cProfileEnable( 1 );
+
+	// Newer commands are only sent to firmware which understands them
+	{
+		I2C_IO_Info_t info;
+		if ( I2C_IO_GetInfo( i2cDev, &info ))
+			ioVersion = info.version;
+		log_string( -1, "i2c-io API version %d", ioVersion );
+	}
 	unlock();
 }
 // End Init
@@ -296,7 +412,7 @@ void setMotor(int motor, int position){
 		if(position > 255) position = 255;
 		if(position < 0) position = 0;
 		uint16_t regVal16 = (((position*8u)+500)*2); 		//Equation to convert 0-255 to 500-2500 (from gumstix wiki)
-		lock();
+		lock(I2C_CALLER_MOTOR);
 		I2C_IO_WriteReg16( i2cDev, motor_regs[motor], regVal16 ); //Send register write command for the correct motor register
 		unlock();
 	}
@@ -320,7 +436,7 @@ void setServo(int servo, int position){
 void setMotorPWM(int motor, int msLength){
 	if( motor <= 5  && motor >= 0) {                             //Check and make sure the motor is one we know about
 		int motor_regs[] = { OCR3A , OCR3B , OCR3C , OCR1A , OCR1B , OCR1C };  //Register map
-		lock();
+		lock(I2C_CALLER_MOTOR);
 		I2C_IO_WriteReg16( i2cDev, motor_regs[motor], msLength * 2 ); //Send register write command for the correct motor register, multiply times 2 to allow the correct value
 		unlock();
 	}
@@ -342,7 +458,7 @@ void setServoPWM(int motor, int msLength){
 
 int getPin(uint8_t portNum, uint8_t pin){
 	uint8_t pinVal;
-	lock();
+	lock(I2C_CALLER_GPIO);
 	if ( I2C_IO_GetGPIO( i2cDev, portNum, &pinVal ))
 	{
 		unlock();
@@ -359,7 +475,7 @@ int getPin(uint8_t portNum, uint8_t pin){
 
 int getDir(uint8_t portNum, uint8_t pin){
 	uint8_t pinVal;
-	lock();
+	lock(I2C_CALLER_GPIO);
 	if ( I2C_IO_GetGPIODir( i2cDev, portNum, &pinVal ))
 	{
 		unlock();
@@ -384,7 +500,7 @@ int getDir(uint8_t portNum, uint8_t pin){
 
 uint16_t getADC(uint8_t pin){
 	uint16_t    adcVal;
-	lock();
+	lock(I2C_CALLER_ADC);
 	if ( I2C_IO_GetADC( i2cDev, pin, &adcVal ))
 	{
 		unlock();
@@ -394,6 +510,62 @@ uint16_t getADC(uint8_t pin){
 	return 0;
 }
 
+//******************************************************************
+/* getADCMulti: Gets several ADC values with a single bus transaction
+ *  Bit n of mask selects pin n, vals[n] is filled in for each selected pin.
+ *  Firmware older than i2c-io API version 3 gets one read per pin, still
+ *  under a single hold of the bus. Returns 1 on success, 0 if a transfer
+ *  failed.
+ */
+
+int getADCMulti(uint8_t mask, uint16_t vals[8]){
+	int rc, i;
+	lock(I2C_CALLER_ADC);
+	if(ioVersion >= 3){
+		rc = I2C_IO_GetADCMulti( i2cDev, mask, vals );
+	} else {
+		rc = 1;
+		for(i = 0; i < 8 && rc; i++)
+			if(mask & (1 << i))
+				rc = I2C_IO_GetADC( i2cDev, i, &vals[i] );
+	}
+	unlock();
+	return rc ? 1 : 0;
+}
+
+//******************************************************************
+/* fifoConfig: Starts the robostix sampling the ADCs in adcMask every
+ *  periodMs milliseconds into its sample FIFO. A period of 0 stops it.
+ *  Returns 1 on success. Needs i2c-io API version 4 or later.
+ */
+
+int fifoConfig(uint8_t adcMask, uint8_t periodMs){
+	int rc;
+	if(ioVersion < 4)
+		return 0; // write-only, so older firmware wouldn't report an error
+	lock(I2C_CALLER_ADC);
+	rc = I2C_IO_FifoConfig( i2cDev, adcMask, periodMs );
+	unlock();
+	return rc ? 1 : 0;
+}
+
+//******************************************************************
+/* fifoRead: Moves up to max samples out of the robostix sample FIFO.
+ *  overflow is set to the number of samples the robostix dropped since
+ *  the last read. Returns the number of samples, or -1 if the transfer
+ *  failed before any arrived.
+ */
+
+int fifoRead(I2C_IO_FifoSample_t *samples, int max, unsigned *overflow){
+	int rc, count;
+	lock(I2C_CALLER_ADC);
+	rc = I2C_IO_FifoRead( i2cDev, samples, max, &count, overflow );
+	unlock();
+	if(!rc && count == 0)
+		return -1;
+	return count;
+}
+
 
 void setPin(uint8_t portNum, uint8_t pin, uint8_t value){
 	if(value == 0 || value == 1){
@@ -404,7 +576,7 @@ void setPin(uint8_t portNum, uint8_t pin, uint8_t value){
 			pinVal = 0;
 		else
 			pinVal = pinMask;
-		lock();
+		lock(I2C_CALLER_GPIO);
 		I2C_IO_SetGPIO( i2cDev, portNum, pinMask, pinVal );
 		unlock();
 	}
@@ -419,7 +591,7 @@ void setDir(uint8_t portNum, uint8_t pin, uint8_t value){
 			pinVal = pinMask;
 		if(value == 0)
 			pinVal = 0;
-		lock();
+		lock(I2C_CALLER_GPIO);
 		I2C_IO_SetGPIODir( i2cDev, portNum, pinMask, pinVal );
 		unlock();
 	}
@@ -429,80 +601,90 @@ void writeReg(int RegNum, int data){
 	if((RegNum >> 8) == 1){ //If is16Bit is true
 		uint16_t regVal16 = data; //create 16 bit unsigned it from data
 		RegNum = RegNum & ~0x100; //Remove is16Bit bit from regNum
-		lock();
+		lock(I2C_CALLER_REG);
 		I2C_IO_WriteReg16( i2cDev, RegNum, regVal16 ); //Write Register
 		unlock();
 	}
 	if((RegNum >> 8) == 0){ //If is16Bit is false
 		uint8_t regVal8 = data; //Create 8 bit unsigned int from data
-		lock();
+		lock(I2C_CALLER_REG);
 		I2C_IO_WriteReg8( i2cDev, RegNum, regVal8 );//Write Register
 		unlock();
 	}
 }
 
 unsigned short readEnc(int encNumber){
-	unsigned char addr = 0;
-	switch (encNumber){
-		case 0:
-			addr = 0x36;
-			break;
-		case 1:
-			addr = 0x3E;
-			break;
-		default:
-			return 0;
-	}
-	short temp = 0;
-	lock();
-	I2cSetSlaveAddress( i2cDev, addr, 0 );
-	I2cReadBytes( i2cDev, 10, &temp, 2);
-	I2cSetSlaveAddress( i2cDev, 0x0b, I2C_USE_CRC );
+	if(encNumber < 0 || encNumber > 1)
+		return 0;
+	unsigned short temp = 0;
+	lock(I2C_CALLER_ENC);
+	I2cReadBytes( encDev[encNumber], 10, &temp, 2);
 	unlock();
 	temp = ((temp & 0xFF) << 8) | ((temp & 0xFF00) >> 8);
 	return temp;
 }
+
 	
 void setVariable(uint8_t var, short data){
-	unsigned char d [3];
-	d[0] = var;
-	d[1] = (data >> 8) & 0xFF;
-	d[2] = data & 0xFF;
-	lock();
-	I2cWriteBytes( i2cDev, 11, &d, 3);
+	lock(I2C_CALLER_VAR);
+	I2C_IO_WriteVar( i2cDev, var, (uint16_t)data );
 	unlock();
 }
 
-signed short readVariable(uint8_t var){
-	unsigned char d [3];
-	d[0] = var;
-	d[1] = 0x00;
-	d[2] = 0x00;
-	lock();
-	I2cReadBytes( i2cDev, 12, &d, 2);
+//******************************************************************
+/* readVariable: Reads one variable into val. Returns 1 on success.
+ */
+
+int readVariable(uint8_t var, signed short *val){
+	uint16_t data = 0;
+	int rc;
+	lock(I2C_CALLER_VAR);
+	rc = I2C_IO_ReadVar( i2cDev, var, &data );
+	unlock();
+	*val = rc ? (signed short)data : 0;
+	return rc ? 1 : 0;
+}
+
+//******************************************************************
+/* readVariables: Reads n variables, vals[i] being vars[i]. Firmware
+ *  older than i2c-io API version 5 gets one read per variable, still
+ *  under a single hold of the bus. Returns 1 on success.
+ */
+
+int readVariables(const uint8_t *vars, int n, signed short *vals){
+	uint16_t data[I2C_IO_MAX_READ_VARS];
+	int rc, i;
+	if(n > I2C_IO_MAX_READ_VARS)
+		return 0;
+	lock(I2C_CALLER_VAR);
+	if(ioVersion >= 5){
+		rc = I2C_IO_ReadVarMulti( i2cDev, vars, n, data );
+	} else {
+		rc = 1;
+		for(i = 0; i < n && rc; i++)
+			rc = I2C_IO_ReadVar( i2cDev, vars[i], &data[i] );
+	}
 	unlock();
-	signed short data = (signed short)d[1];
-	data |= (signed short)d[2] << 8;
-	return data;
+	for(i = 0; i < n; i++)
+		vals[i] = rc ? (signed short)data[i] : 0;
+	return rc ? 1 : 0;
 }
 
 
 void steer(int encNumber, uint16_t direction){
-	unsigned char addr = 0;
+	int dev;
 	switch (encNumber){
 		case 1:
-			addr = 0x36;
+			dev = encDev[0];
 			break;
 		case 0:
-			addr = 0x3E;
+			dev = encDev[1];
 			break;
 		default:
 			return;
 	}
 	direction = ((direction & 0xFF) << 8) | ((direction & 0xFF00) >> 8);
-	lock();
-	I2cSetSlaveAddress( i2cDev, addr, 0);
-	I2cWriteBytes( i2cDev, 1, &direction, 2);
-	I2cSetSlaveAddress( i2cDev, 0x0b, I2C_USE_CRC);
+	lock(I2C_CALLER_MOTOR);
+	I2cWriteBytes( dev, 1, &direction, 2);
 	unlock();
 }
@@ -18,6 +18,20 @@
 #include "i2c-io-api.h"
 #include "BootLoader-api.h"
 #include "Log.h"
+
+// Who is holding the bus lock, used to break down the lock statistics
+typedef enum {
+	I2C_CALLER_MOTOR = 0,	//setMotor, setMotorPWM, steer
+	I2C_CALLER_ADC,		//getADC, getADCMulti, fifoConfig, fifoRead
+	I2C_CALLER_GPIO,	//getPin, getDir, setPin, setDir
+	I2C_CALLER_VAR,		//setVariable, readVariable
+	I2C_CALLER_ENC,		//readEnc
+	I2C_CALLER_REG,		//init, servoInit register writes
+	I2C_CALLER_COUNT
+} i2c_caller;
+
+// None of the functions below may be called from a signal handler, and
+// threads calling them should block SIGINT/SIGTERM/SIGHUP at startup.
 extern void init(int i2cSlave); //Initiization (connects gumstix to robostix) **REQUIRED BEFORE OTHER COMMANDS**
 extern void servoInit(); //Intitialize the servo/motor timers *Required for servo control*
 extern void setMotor(int motor, int position); //Sets a motor or servo based on a 0-255 value
@@ -28,10 +42,17 @@ extern int getPin(uint8_t portNum, uint8_t pin); //Returns the value of a pin (1
 extern int getDir(uint8_t portNum, uint8_t pin); //Returns the direction of a pin (1 out or 0 in)
 extern void setMotorDR(int motor, int position, int percent); //Servo control using dual rate setup
 extern uint16_t getADC(uint8_t pin); //Get ADC value, returned as a 16 bit unsigned integer
+extern int getADCMulti(uint8_t mask, uint16_t vals[8]); //Reads every ADC set in mask in one transaction, vals indexed by pin (1 on success)
+extern int fifoConfig(uint8_t adcMask, uint8_t periodMs); //Stream the ADCs in adcMask into the robostix sample FIFO (0 ms stops it)
+extern int fifoRead(I2C_IO_FifoSample_t *samples, int max, unsigned *overflow); //Drain the sample FIFO, returns the count or -1
 extern void setPin(uint8_t port, uint8_t pin, uint8_t value); //Set pin (faster)
 extern void setDir(uint8_t port, uint8_t pin, uint8_t value); //SetDir (faster) (0=off)
 extern unsigned short readEnc(int encNumber);
 extern void setVariable(uint8_t var, short data);
 extern void steer(int encNumber, uint16_t direction);
-extern signed short readVariable(uint8_t var);
+extern int readVariable(uint8_t var, signed short *val); //1 on success
+extern int readVariables(const uint8_t *vars, int n, signed short *vals); //Reads up to I2C_IO_MAX_READ_VARS variables in one transaction (1 on success)
+extern void i2c_lock_log_stats(int level); //Log wait/hold time of the bus lock per caller, then reset
+extern unsigned i2cErrors(void); //Failed bus transactions since startup, never waits for the bus
+extern void i2c_profile_dump(void); //Log per command bus latency histograms and error counts
 #endif // !MOD_I2C_IO_H
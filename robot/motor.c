@@ -0,0 +1,269 @@
+//    motor.c - fixed rate motor output stage
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// motor.c
+//
+// MOTOR events arrive as fast as the controller sends them, but the servo
+// pulses only go out once every 20 ms frame. Event handlers record the
+// latest position per channel here and a thread writes the channels that
+// changed once per frame, so the bus load stays bounded however fast the
+// sticks move. Acceleration limiting happens at the same point.
+//
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include "robot_log.h"
+#include "i2c_thread.h"
+#include "motor.h"
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	int target;     // last position commanded
+	int current;    // last position written to the robostix
+	int dirty;      // current has not caught up with target
+	int slew;       // limit the change per frame with dvmaxlut
+} motor_channel;
+
+//---------------------------------------------------------------------------//
+// Private Function Prototypes
+//
+static void *motor_thread_main(void *arg);
+static void motor_flush();
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static pthread_t tid = 0;  // Thread ID of the motor thread
+static pthread_mutex_t mlock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int running = 0;
+
+static motor_channel channels[MOTOR_COUNT];
+static unsigned int received = 0; // motor_set calls since the last stats
+static unsigned int written = 0;  // bus writes since the last stats
+static unsigned int limited = 0;  // frames where a channel was slew limited
+
+// Largest change allowed per frame, indexed by the current position. Small
+// around neutral so the drive doesn't jerk when starting or reversing.
+// Generated by mklut.py
+static const unsigned char dvmaxlut[] = {
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 62, 62, 62, 62, 62, 61, 61, 61,
+    61, 60, 60, 60, 59, 59, 58, 58, 58, 57,
+    56, 56, 55, 55, 54, 53, 53, 52, 51, 50,
+    49, 48, 47, 47, 46, 44, 43, 42, 41, 40,
+    39, 38, 36, 35, 34, 33, 31, 30, 29, 27,
+    26, 25, 23, 22, 21, 20, 18, 17, 16, 15,
+    14, 13, 12, 11, 10,  9,  8,  7,  7,  6,
+     5,  5,  5,  4,  4,  4,  4,  4,  4,  4,
+     4,  4,  5,  5,  5,  6,  7,  7,  8,  9,
+    10, 11, 12, 13, 14, 15, 16, 17, 18, 20,
+    21, 22, 23, 25, 26, 27, 29, 30, 31, 33,
+    34, 35, 36, 38, 39, 40, 41, 42, 43, 44,
+    46, 47, 47, 48, 49, 50, 51, 52, 53, 53,
+    54, 55, 55, 56, 56, 57, 58, 58, 58, 59,
+    59, 60, 60, 60, 61, 61, 61, 61, 62, 62,
+    62, 62, 62, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64
+};
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+int motor_thread_create() {
+	int i;
+
+	// servoInit() leaves every output at neutral
+	for(i = 0; i < MOTOR_COUNT; i++) {
+		channels[i].target = MOTOR_NEUTRAL;
+		channels[i].current = MOTOR_NEUTRAL;
+		channels[i].dirty = 0;
+		channels[i].slew = i < MOTOR_SLEW_DEFAULT;
+	}
+	running = 1;
+
+	// create the thread
+	if(pthread_create(&tid, NULL, motor_thread_main, NULL) != 0) {
+		running = 0;
+		return 0;
+	}
+	return 1; // exit true
+}
+
+int motor_thread_destroy() {
+	int i;
+
+	if (tid <= 0) {
+		return 0;
+	}
+
+	running = 0;
+	if (pthread_join(tid, NULL) != 0) {
+		return 0;
+	}
+	tid = 0;
+
+	// shutting down, so stop now rather than ramping
+	for(i = 0; i < MOTOR_COUNT; i++) {
+		channels[i].target = MOTOR_NEUTRAL;
+		channels[i].slew = 0;
+		channels[i].dirty = 1;
+	}
+	motor_flush();
+	return 1;
+}
+
+void motor_set(int motor, int position) {
+	if (motor < 0 || motor >= MOTOR_COUNT) {
+		return;
+	}
+	if (position < 0) {
+		position = 0;
+	}
+	if (position > 255) {
+		position = 255;
+	}
+
+	pthread_mutex_lock(&mlock);
+	channels[motor].target = position;
+	channels[motor].dirty = 1;
+	received++;
+	pthread_mutex_unlock(&mlock);
+}
+
+void motor_set_slew(int motor, int enabled) {
+	if (motor < 0 || motor >= MOTOR_COUNT) {
+		return;
+	}
+	pthread_mutex_lock(&mlock);
+	channels[motor].slew = enabled;
+	pthread_mutex_unlock(&mlock);
+}
+
+int motor_get(int motor) {
+	int position;
+
+	if (motor < 0 || motor >= MOTOR_COUNT) {
+		return MOTOR_NEUTRAL;
+	}
+	pthread_mutex_lock(&mlock);
+	position = channels[motor].current;
+	pthread_mutex_unlock(&mlock);
+	return position;
+}
+
+void motor_log_stats(int level) {
+	unsigned int snap_received, snap_written, snap_limited;
+
+	pthread_mutex_lock(&mlock);
+	snap_received = received;
+	snap_written = written;
+	snap_limited = limited;
+	received = written = limited = 0;
+	pthread_mutex_unlock(&mlock);
+
+	if (snap_received || snap_written) {
+		log_string(level, "motor positions received=%u written=%u slew limited=%u",
+				snap_received, snap_written, snap_limited);
+	}
+}
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+static void *motor_thread_main(void *arg) {
+	sigset_t signal_mask;
+	struct timespec next;
+
+	// termination and dump signals belong to the main thread
+	sigemptyset(&signal_mask);
+	sigaddset(&signal_mask, SIGINT);
+	sigaddset(&signal_mask, SIGTERM);
+	sigaddset(&signal_mask, SIGHUP);
+	sigaddset(&signal_mask, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &signal_mask, NULL);
+
+	// an absolute schedule keeps the frames from drifting
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while(running) {
+		next.tv_nsec += MOTOR_FRAME_USEC * 1000;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		motor_flush();
+	}
+	return NULL;
+}
+
+// Moves each dirty channel toward its target, at most dvmaxlut[current]
+// per frame when slew limited, and queues the writes on the i2c thread
+static void motor_flush() {
+	int out[MOTOR_COUNT];
+	int send[MOTOR_COUNT];
+	int i, dv, dvmax;
+
+	pthread_mutex_lock(&mlock);
+	for(i = 0; i < MOTOR_COUNT; i++) {
+		motor_channel *c = &channels[i];
+
+		send[i] = c->dirty;
+		if (!c->dirty) {
+			continue;
+		}
+		dv = c->target - c->current;
+		if (dv == 0) {
+			// set back to where it already is
+			c->dirty = 0;
+			send[i] = 0;
+			continue;
+		}
+		if (c->slew) {
+			// the table stops one short of 255
+			dvmax = dvmaxlut[c->current < (int)sizeof(dvmaxlut) ? c->current : (int)sizeof(dvmaxlut) - 1];
+			if (dv > dvmax || -dv > dvmax) {
+				dv = dv > 0 ? dvmax : -dvmax;
+				limited++;
+			}
+		}
+		c->current += dv;
+		c->dirty = c->current != c->target;
+		out[i] = c->current;
+		written++;
+	}
+	pthread_mutex_unlock(&mlock);
+
+	for(i = 0; i < MOTOR_COUNT; i++) {
+		if (send[i]) {
+			i2c_async_set_motor(i, out[i]);
+		}
+	}
+}
@@ -0,0 +1,51 @@
+//    motor.h - interface for the fixed rate motor output stage
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef MOTOR_H
+#define MOTOR_H
+
+#define MOTOR_COUNT 8 //Motor/servo channels handled by the output stage
+#define MOTOR_NEUTRAL 127
+#define MOTOR_FRAME_USEC 20000 //One servo frame, outputs are flushed this often
+#define MOTOR_SLEW_DEFAULT 4 //Channels below this are slew limited by default
+
+// motor_thread_create - starts the thread that flushes motor outputs.
+// 	i2c_thread_create() must already have been called.
+extern int motor_thread_create();
+
+// motor_thread_destroy - stops the flush thread and sends every channel
+// 	straight to neutral, without slew limiting
+extern int motor_thread_destroy();
+
+// motor_set - records the commanded position (0-255) for a channel. It is
+// 	sent at the next servo frame; if several arrive within one frame only
+// 	the last is sent.
+extern void motor_set(int motor, int position);
+
+// motor_get - the position last written to the robostix for a channel
+extern int motor_get(int motor);
+
+// motor_set_slew - turns acceleration limiting on or off for a channel.
+// 	Drive motors want it, servos and on/off actuators don't.
+extern void motor_set_slew(int motor, int enabled);
+
+// motor_log_stats - logs positions received and bus writes made since the
+// 	last call, then resets the counters
+extern void motor_log_stats(int level);
+
+#endif //!MOTOR_H
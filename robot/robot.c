@@ -21,51 +21,39 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
+#include <time.h>
 #include "robot_comm.h"
+#include "robot_rel.h"
+#include "robot_mp.h"
+#include "robot_jb.h"
+#include "timebase.h"
 #include "robot_log.h"
 #include "events.h"
 #include "timer.h"
 #include "mod_i2c-io.h"
+#include "i2c_thread.h"
+#include "motor.h"
 #include "robot_queue.h"
 #include "profile.c"
 #include "adc.h"
+#include "var_sub.h"
+#include "tlm.h"
+#include "link.h"
 
 void term_handler(int signal);
 
+// set by term_handler, the main loop exits and shuts down cleanly
+static volatile sig_atomic_t quit = 0;
+
+// set by SIGUSR1, the main loop dumps the i2c transaction profile
+static volatile sig_atomic_t dump_profile = 0;
+void profile_handler(int signal);
+
 // usage information
 void usage(char *progname);
 
 void failsafe_mode(robot_queue *q);
 
-const unsigned char dvmaxlut[] = {
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 63, 63, 63, 63, 63, 63, 63,
-    63, 63, 62, 62, 62, 62, 62, 61, 61, 61,
-    61, 60, 60, 60, 59, 59, 58, 58, 58, 57,
-    56, 56, 55, 55, 54, 53, 53, 52, 51, 50,
-    49, 48, 47, 47, 46, 44, 43, 42, 41, 40,
-    39, 38, 36, 35, 34, 33, 31, 30, 29, 27,
-    26, 25, 23, 22, 21, 20, 18, 17, 16, 15,
-    14, 13, 12, 11, 10,  9,  8,  7,  7,  6,
-     5,  5,  5,  4,  4,  4,  4,  4,  4,  4,
-     4,  4,  5,  5,  5,  6,  7,  7,  8,  9,
-    10, 11, 12, 13, 14, 15, 16, 17, 18, 20,
-    21, 22, 23, 25, 26, 27, 29, 30, 31, 33,
-    34, 35, 36, 38, 39, 40, 41, 42, 43, 44,
-    46, 47, 47, 48, 49, 50, 51, 52, 53, 53,
-    54, 55, 55, 56, 56, 57, 58, 58, 58, 59,
-    59, 60, 60, 60, 61, 61, 61, 61, 62, 62,
-    62, 62, 62, 63, 63, 63, 63, 63, 63, 63,
-    63, 63, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64
-};
-
 int main(int argc, char *argv[])
 {
 	unsigned int server_port;
@@ -73,11 +61,12 @@ int main(int argc, char *argv[])
     robot_event ev;
 	unsigned int failcount;
 	int opt;
+	struct timespec start, end; // time spent on each event
 
 	log_level = 0;
 	setProfile('p');
 	server_port = 0;
-	 while((opt = getopt(argc, argv, "p:v:j:")) != -1)
+	 while((opt = getopt(argc, argv, "p:v:a:b:j:t:LT")) != -1)
 		 switch (opt)
 		 {
 			 case 'p':
@@ -86,8 +75,33 @@ int main(int argc, char *argv[])
 			 case 'v':
 				 log_level = atoi(optarg);
 			 	 break;
+			 case 'a':
+				 if(!adc_configure(optarg)) {
+					 usage(argv[0]);
+					 exit(1);
+				 }
+			 	 break;
+			 case 'b':
+				 if(!jb_configure(optarg)) {
+					 usage(argv[0]);
+					 exit(1);
+				 }
+			 	 break;
+			 case 't':
+				 if(!tlm_configure(optarg)) {
+					 usage(argv[0]);
+					 exit(1);
+				 }
+			 	 break;
+			 case 'L':
+				 net_set_low_latency(1);
+			 	 break;
+			 case 'T':
+				 log_times = 1;
+			 	 break;
 			 case 'j':
 				 setProfile(optarg[0]);
+			 	 break;
 			 case '?':
 				 usage(argv[0]);
 				 exit(1);
@@ -106,6 +120,15 @@ int main(int argc, char *argv[])
 	init(0x0b);
 	log_string(-10, "servoInit");
 	servoInit();
+	// From here on the i2c thread owns the bus
+	if(!i2c_thread_create()){
+		log_string(2, "Error running the i2c thread");
+		exit(1);
+	}
+	if(!motor_thread_create()){
+		log_string(2, "Error running the motor thread");
+		exit(1);
+	}
 
 	// Open up the socket
 	if(!net_thread_server_create(&q, server_port)) {
@@ -113,6 +136,12 @@ int main(int argc, char *argv[])
 		exit(1);
 	}
 
+	if(!jb_thread_create(&q)) {
+		log_string(2, "Error running the playout thread");
+		exit(1);
+	}
+
+	timer_enable_control_tick();
 	if(!timer_thread_create(&q)){
 		log_string(2, "Error running the timer thread");
 		exit(1);
@@ -135,13 +164,22 @@ int main(int argc, char *argv[])
 		log_errno(0, "Error setting the SIGINT handler");
 	if(signal(SIGTERM, term_handler) == SIG_ERR)
 		log_errno(0, "Error setting the SIGTERM handler");
+	if(signal(SIGUSR1, profile_handler) == SIG_ERR)
+		log_errno(0, "Error setting the SIGUSR1 handler");
 
 
-	while(1) {
+	while(!quit) {
 		robot_queue_wait_event(&q, &ev);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if(dump_profile) {
+			dump_profile = 0;
+			i2c_profile_dump();
+		}
 		switch (ev.command & 0xF0) {
 			case ROBOT_EVENT_CMD:
 				failcount = 0;
+				if(ev.command == ROBOT_EVENT_CMD_START)
+					var_sub_clear();
 				on_command_code(&ev);
 				break;
 			case ROBOT_EVENT_NET:
@@ -154,28 +192,7 @@ int main(int argc, char *argv[])
 				break;
 			case ROBOT_EVENT_MOTOR:
 				failcount = 0;
-
-		/*
-                // update the state
-                if (ev.index < 4) {
-                    last_motors[ev.index] = ev.value;
-                    vf = last_motors + ev.index;
-                    *vf = ev.value;
-                    vi = cur_motors + ev.index;
-                    dv = (int)*vf - (int)*vi; 
-                    // if the motor tries to accelerate too fast limit it
-                    if ((dv > dvmaxlut[*vi]) || (-dv > dvmaxlut[*vi])) {
-                        log_string(0, "Over accelerated");
-                        dv = dvmaxlut[*vi] * ( dv > 0 ? 1 : -1 );
-                        log_string(0, "vi= %d, vf=%d, dv=%d", *vi, *vf, dv);
-                    }
-                    *vi += dv;
-                    ev.value = *vi;
-
-                }
-		*/
 				on_motor(&ev);
-
 				break;
 			case ROBOT_EVENT_JOY_BUTTON:
 				failcount = 0;
@@ -186,6 +203,7 @@ int main(int argc, char *argv[])
 				break;
 			case ROBOT_EVENT_ADC:
 				failcount = 0;
+				tlm_adc(ev.index, ev.value);
 				on_adc_change(&ev);
 				break;
 			case ROBOT_EVENT_SET_VAR:
@@ -195,11 +213,15 @@ int main(int argc, char *argv[])
 				break;
 			case ROBOT_EVENT_READ_VAR:
 				failcount = 0;
-				on_read_variable(&ev);
+				if(ev.command == ROBOT_EVENT_READ_VAR_SUBSCRIBE)
+					var_sub_event(&ev);
+				else
+					on_read_variable(&ev);
 				break;
 			case ROBOT_EVENT_TIMER:
 				if(ev.index == 1){
 					on_10hz_timer(&ev);
+					link_tick();
 					failcount++;
 					if(failcount >= 5)
 						failsafe_mode(&q);
@@ -215,33 +237,76 @@ int main(int argc, char *argv[])
 		    */
 
 				}
-                else if(ev.index == 2)
+                else if(ev.index == 2){
 					on_1hz_timer(&ev);
+					motor_log_stats(-1);
+					i2c_thread_log_stats(-1);
+					i2c_lock_log_stats(-1);
+					rel_log_stats(-1);
+					var_sub_log_stats(-1);
+					link_log_stats(-1);
+					mp_log_stats(-1);
+					jb_log_stats(-1);
+					timebase_log_stats(-1);
+					net_log_stats(-1);
+				}
+				else if(ev.index == 3){
+					on_control_tick(&ev);
+					rel_tick();
+					var_sub_tick();
+					tlm_tick(&q);
+				}
 		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		tlm_loop_time((end.tv_sec - start.tv_sec) * 1000000L +
+				(end.tv_nsec - start.tv_nsec) / 1000);
 	}
 
 	on_shutdown();
+#ifndef NO_ADC
+	adc_thread_destroy();
+#endif
+	motor_thread_destroy();
+	i2c_thread_destroy();
 	net_thread_destroy();
+	jb_thread_destroy();
 
 	return 0;
 }
 
 // handles signals that tell the controller to shutdown
 void term_handler(int signal) { // Signal handler
-	on_shutdown();
+	// Only note the request here. Shutting down touches the bus and the
+	// network, neither of which is safe from inside a signal handler; the
+	// main loop notices within one timer tick.
+	quit = 1;
+}
 
-	net_thread_destroy();
 
-	exit(0);
+// kill -USR1 <pid> dumps the i2c profile
+void profile_handler(int signal) {
+	dump_profile = 1;
 }
 
-
 void usage(char *progname) {
-	log_string(3, "%s: [-p port (31337)] [-v verbosity (0)]\n", progname);
+	log_string(3, "%s: [-p port (31337)] [-v verbosity (0)]"
+			" [-j joystick profile (p), the controller's -j, for its -k]"
+			" [-a adc:rate[:deadband[:hysteresis[:min_ms]]] | -a adc:off]..."
+			" [-t telemetry rate (10)[:var,var...]]"
+			" [-b playout delay ms[:max ms (100)], with the controller's -s]"
+			" [-T time log lines on the controller's clock]"
+			" [-L low latency socket]\n", progname);
 }
 
 void failsafe_mode(robot_queue *q) {
 	robot_event ev;
+	// stop mixing the drive here first, or the next control tick would
+	// put the last stick positions straight back on the motors
+	ev.command = ROBOT_EVENT_CMD_KINEMATICS;
+	ev.index = 0;
+	ev.value = 0;
+	robot_queue_enqueue(q, &ev);
+
 	ev.command = ROBOT_EVENT_SET_VAR;
 	ev.index = 12;
 	ev.value = 0;
@@ -141,6 +141,9 @@ void on_1hz_timer(robot_event *ev){
 void on_10hz_timer(robot_event *ev){
 }
 
+void on_control_tick(robot_event *ev){
+}
+
 void on_command_code(robot_event *ev) {
 	robot_event send_ev;
 	switch(ev->command) {
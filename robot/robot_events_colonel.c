@@ -35,20 +35,35 @@
 #include "robot_log.h"
 #include "events.h"
 #include "mod_i2c-io.h"
+#include "i2c_thread.h"
+#include "motor.h"
 #include "profile.h"
+#include "drive.h"
 
 
 
+static mixer drive;
+static int kinematics = 0; // mixing the drive here, see drive.h
+
+// drive outputs are handled as if the controller had sent them
+static int drive_output(robot_event *ev) {
+	on_motor(ev);
+	return 1;
+}
+
 void on_init() {
 	robot_event ev;
 	ev.command = ROBOT_EVENT_CMD_START;
 	ev.index = 0;
 	ev.value = 0;
 
+	drive_setup(&drive);
+	drive.sink = drive_output;
+
 	log_string(-1, "Robot is initializing");
 	send_event(&ev);
-	steer(0, 0);
-	steer(1, 0);
+	i2c_async_steer(0, 0);
+	i2c_async_steer(1, 0);
 }
 
 void on_shutdown() {
@@ -58,45 +73,48 @@ void on_shutdown() {
 	ev.value = 0;
 
 	log_string(-1, "Robot is shutting down");
-	setPin(1,4,1);
-	setPin(6,3,1);
+	i2c_async_set_pin(1,4,1);
+	i2c_async_set_pin(6,3,1);
 	send_event(&ev);
 }
 
 int gripper = 0, hold = 0, shoot = 0;
 void on_button_up(robot_event *ev) {
+	drive_button(&drive, ev);
 	if(ev->index == CON_ARM_UP || ev->index == CON_ARM_DOWN){
-        setPin(2,2,0);
+        i2c_async_set_pin(2,2,0);
 	}
 }
 
 void on_button_down(robot_event *ev) {	
+	drive_button(&drive, ev);
 
 	if(ev->index == CON_ARM_UP){
-        setPin(2,2,1);
-        setPin(2,3,1);
+        i2c_async_set_pin(2,2,1);
+        i2c_async_set_pin(2,3,1);
 	}
 	if(ev->index == CON_ARM_DOWN){
-        setPin(2,2,1);
-        setPin(2,3,0);
+        i2c_async_set_pin(2,2,1);
+        i2c_async_set_pin(2,3,0);
 	}
 	if(ev->index == CON_GRIP){
 		gripper = 1-gripper;
-		setPin(2,0,gripper);
+		i2c_async_set_pin(2,0,gripper);
 	}
     if(ev->index == CON_FRONT && gripper == 0){
         hold = 1 - hold;
-        setPin(2,1,hold);
+        i2c_async_set_pin(2,1,hold);
     }
 	if(ev->index == 0x00){
 		shoot = 1-shoot;
-		setPin(2,4,shoot);
-		setPin(2,5,shoot);
-		setPin(2,6,shoot);
+		i2c_async_set_pin(2,4,shoot);
+		i2c_async_set_pin(2,5,shoot);
+		i2c_async_set_pin(2,6,shoot);
 	}
 }
 
 void on_axis_change(robot_event *ev){
+	mixer_axis(&drive, ev);
 }
 
 void on_adc_change(robot_event *ev){
@@ -104,9 +122,9 @@ void on_adc_change(robot_event *ev){
 
 void on_motor(robot_event *ev){ 
 	if(ev->index < 6)
-		setMotor(ev->index, ev->value);
+		motor_set(ev->index, ev->value);
 	if(ev->index > 5 && ev->index < 8)
-		steer(ev->index - 6, ev->value);
+		i2c_async_steer(ev->index - 6, ev->value);
 }
 
 void on_status_code(robot_event *ev) {
@@ -130,6 +148,11 @@ void on_1hz_timer(robot_event *ev){
 void on_10hz_timer(robot_event *ev){
 }
 
+void on_control_tick(robot_event *ev){
+	if(kinematics)
+		drive_tick(&drive);
+}
+
 void on_command_code(robot_event *ev) {
     static int flasher = 0;
 	robot_event send_ev;
@@ -139,18 +162,24 @@ void on_command_code(robot_event *ev) {
 			send_ev.index = 0;
 			send_ev.value = 0;
 			send_event(&send_ev);
-			setPin(6,3,flasher);
+			i2c_async_set_pin(6,3,flasher);
 			flasher = 1 - flasher;
 			break;
 		case ROBOT_EVENT_CMD_START:
 			break;
 		case ROBOT_EVENT_CMD_STOP:
-			setPin(6,3,1);
-			setPin(1,4,1);
+			i2c_async_set_pin(6,3,1);
+			i2c_async_set_pin(1,4,1);
+			kinematics = 0;
 
 			break;
 		case ROBOT_EVENT_CMD_REBOOT:
 			break;
+		case ROBOT_EVENT_CMD_KINEMATICS:
+			if(kinematics != (ev->value != 0))
+				log_string(-1, "Drive mixed on the %s", ev->value ? "robot" : "controller");
+			kinematics = (ev->value != 0);
+			break;
 		default:
 			// unknown command code datagram
 			break;
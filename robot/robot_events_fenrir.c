@@ -36,6 +36,8 @@
 #include "robot_log.h"
 #include "events.h"
 #include "mod_i2c-io.h"
+#include "i2c_thread.h"
+#include "motor.h"
 #include "profile.h"
 
 int flasher = 0;
@@ -47,6 +49,9 @@ void on_init() {
 	ev.value = 0;
 
 	log_string(-1, "Robot is initializing");
+	// gripper and suction are switched, not driven
+	motor_set_slew(2, 0);
+	motor_set_slew(3, 0);
 	send_event(&ev);
 }
 
@@ -57,18 +62,18 @@ void on_shutdown() {
 	ev.value = 0;
 
 	log_string(-1, "Robot is shutting down");
-	setPin(1,4,1);
-	setPin(6,3,1);
+	i2c_async_set_pin(1,4,1);
+	i2c_async_set_pin(6,3,1);
 	send_event(&ev);
 }
 int gripper = 0, suck = 0, drum = 0;
 void on_button_up(robot_event *ev) {
 	
 	if(ev->index == 0x04){
-		setMotor(2,127);
+		motor_set(2,127);
 	}
 	if(ev->index == 0x06){
-		setMotor(2,127);
+		motor_set(2,127);
 	}
 	
 }
@@ -76,17 +81,17 @@ void on_button_up(robot_event *ev) {
 void on_button_down(robot_event *ev) {	
 	
 	if(ev->index == 0x04){
-		setMotor(2,180);
+		motor_set(2,180);
 	}
 	if(ev->index == 0x06){
-		setMotor(2,1);
+		motor_set(2,1);
 	}
 	if(ev->index == 0x01){
 		if(!suck){
-			setMotor(3,1);
+			motor_set(3,1);
 			suck = 1;
 		} else { 
-			setMotor(3,127);
+			motor_set(3,127);
 			suck = 0;
 		}
 
@@ -105,13 +110,13 @@ void on_adc_change(robot_event *ev){
 
 void on_motor(robot_event *ev){
 	if(ev->index == 0){
-		setMotor(0, ev->value);
+		motor_set(0, ev->value);
 	} else if(ev->index == 1){
-		setMotor(1, ev->value);
+		motor_set(1, ev->value);
 	} else if(ev->index == 2){
-		setMotor(2, ev->value);
+		motor_set(2, ev->value);
 	} else if(ev->index == 3){
-		setMotor(3, ev->value);
+		motor_set(3, ev->value);
 	}
 }
 
@@ -132,25 +137,32 @@ void on_status_code(robot_event *ev) {
 
 void on_set_variable(robot_event *ev) {
 	log_string(0,"Set var: %d to %d. robot_events_fenrir.c", ev->index, ev->value);
-	setVariable(ev->index, ev->value);
+	i2c_async_set_variable(ev->index, ev->value);
 }
 
-void on_read_variable(robot_event *ev) {
-	signed short data = readVariable(ev->index);
-	log_string(0,"Read var: %d is %d, robot_events_fenrir.c", ev->index, data);
+// runs on the i2c thread once the read completes
+static void read_variable_done(uint8_t var, signed short data, void *arg) {
+	log_string(0,"Read var: %d is %d, robot_events_fenrir.c", var, data);
 	robot_event send_ev;
 	send_ev.command = ROBOT_EVENT_READ_VAR;
-	send_ev.index = ev->index;
+	send_ev.index = var;
 	send_ev.value = data;
 	send_event(&send_ev);
 }
 
+void on_read_variable(robot_event *ev) {
+	i2c_async_read_variable(ev->index, read_variable_done, NULL);
+}
+
 void on_1hz_timer(robot_event *ev){
 }
 
 void on_10hz_timer(robot_event *ev){
 }
 
+void on_control_tick(robot_event *ev){
+}
+
 void on_command_code(robot_event *ev) {
 	robot_event send_ev;
 	switch(ev->command) {
@@ -159,14 +171,14 @@ void on_command_code(robot_event *ev) {
 			send_ev.index = 0;
 			send_ev.value = 0;
 			send_event(&send_ev);
-			setPin(6,3,flasher);
+			i2c_async_set_pin(6,3,flasher);
 			flasher = 1 - flasher;
 			break;
 		case ROBOT_EVENT_CMD_START:
 			break;
 		case ROBOT_EVENT_CMD_STOP:
-			setPin(6,3,1);
-			setPin(2,4,1);
+			i2c_async_set_pin(6,3,1);
+			i2c_async_set_pin(2,4,1);
 
 			break;
 		case ROBOT_EVENT_CMD_REBOOT:
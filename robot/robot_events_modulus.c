@@ -35,6 +35,8 @@
 #include "robot_log.h"
 #include "events.h"
 #include "mod_i2c-io.h"
+#include "i2c_thread.h"
+#include "motor.h"
 #include "profile.h"
 
 int flasher = 0;
@@ -60,21 +62,21 @@ void on_shutdown() {
 }
 int gripper = 0, suck = 0, drum = 0;
 void on_button_up(robot_event *ev) {
-if(ev->index == 0) setPin(2,0,0);
-if(ev->index == 1) setPin(2,1,0);
-if(ev->index == 2) setPin(2,2,0);
-if(ev->index == 3) setPin(2,3,0);
-if(ev->index == 4) setPin(2,4,0);
-if(ev->index == 5) setPin(2,5,0);
+if(ev->index == 0) i2c_async_set_pin(2,0,0);
+if(ev->index == 1) i2c_async_set_pin(2,1,0);
+if(ev->index == 2) i2c_async_set_pin(2,2,0);
+if(ev->index == 3) i2c_async_set_pin(2,3,0);
+if(ev->index == 4) i2c_async_set_pin(2,4,0);
+if(ev->index == 5) i2c_async_set_pin(2,5,0);
 }
 
 void on_button_down(robot_event *ev) {	
-if(ev->index == 0) setPin(2,0,1);
-if(ev->index == 1) setPin(2,1,1);
-if(ev->index == 2) setPin(2,2,1;
-if(ev->index == 3) setPin(2,3,1);
-if(ev->index == 4) setPin(2,4,1);
-if(ev->index == 5) setPin(2,5,1);
+if(ev->index == 0) i2c_async_set_pin(2,0,1);
+if(ev->index == 1) i2c_async_set_pin(2,1,1);
+if(ev->index == 2) i2c_async_set_pin(2,2,1);
+if(ev->index == 3) i2c_async_set_pin(2,3,1);
+if(ev->index == 4) i2c_async_set_pin(2,4,1);
+if(ev->index == 5) i2c_async_set_pin(2,5,1);
 }
 
 void on_axis_change(robot_event *ev){
@@ -85,10 +87,10 @@ void on_adc_change(robot_event *ev){
 }
 
 void on_motor(robot_event *ev) {
-	if(ev->index == 0) setMotor(0, ev->value);
-	if(ev->index == 1) setMotor(1, ev->value);
-	if(ev->index == 3) setMotor(2, ev->value);
-	if(ev->index == 4) setMotor(3, ev->value);
+	if(ev->index == 0) motor_set(0, ev->value);
+	if(ev->index == 1) motor_set(1, ev->value);
+	if(ev->index == 3) motor_set(2, ev->value);
+	if(ev->index == 4) motor_set(3, ev->value);
 }
 
 void on_status_code(robot_event *ev) {
@@ -112,6 +114,9 @@ void on_1hz_timer(robot_event *ev){
 void on_10hz_timer(robot_event *ev){
 }
 
+void on_control_tick(robot_event *ev){
+}
+
 void on_command_code(robot_event *ev) {
 	robot_event send_ev;
 	switch(ev->command) {
@@ -120,14 +125,14 @@ void on_command_code(robot_event *ev) {
 			send_ev.index = 0;
 			send_ev.value = 0;
 			send_event(&send_ev);
-			setPin(6,3,flasher);
+			i2c_async_set_pin(6,3,flasher);
 			flasher = 1 - flasher;
 			break;
 		case ROBOT_EVENT_CMD_START:
 			break;
 		case ROBOT_EVENT_CMD_STOP:
-			setPin(6,3,1);
-			setPin(1,4,1);
+			i2c_async_set_pin(6,3,1);
+			i2c_async_set_pin(1,4,1);
 
 			break;
 		case ROBOT_EVENT_CMD_REBOOT:
@@ -105,7 +105,7 @@ int main(int argc, char *argv[])
        LogError( "Error  opening '%s': %s\n", i2cDevName, strerror( errno ));
        exit( 1 );
    }
-   I2cSetSlaveAddress( i2cDev, gI2cAddr, I2C_USE_CRC ); // set I2C slave device
+   i2cDev = I2cSlaveHandle( i2cDev, gI2cAddr, I2C_USE_CRC ); // set I2C slave device
    
    ProcessWriteRegCommand("TCCR1A", 0xAA);
    ProcessWriteRegCommand("TCCR1B", 0x1A);
@@ -172,7 +172,7 @@ int main(int argc, char *argv[])
       }*/
 	//usleep(10000);      
    }
-close( i2cDev );
+close( I2C_HANDLE_FD( i2cDev ));
 }
 
 void error(char *msg)
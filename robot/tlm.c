@@ -0,0 +1,161 @@
+//    tlm.c - gathers the robot's state into telemetry frames
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// tlm.c
+//
+// Everything but the robostix variables is at hand on the main loop. The
+// variables are read in one bulk read per frame on the i2c thread, so a
+// frame carries the values from the read queued for the frame before.
+//
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "robot_comm.h"
+#include "robot_log.h"
+#include "timer.h"
+#include "telemetry.h"
+#include "mod_i2c-io.h"
+#include "i2c_thread.h"
+#include "motor.h"
+#include "link.h"
+#include "tlm.h"
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static int period = TIMER_CONTROL_HZ / TLM_DEFAULT_HZ; // control ticks per frame, 0 if off
+static int ticks = 0;
+static int frames = 0;          // since the last keyframe
+
+static uint8_t vars[TELEMETRY_VARS];
+static int num_vars = 0;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER; // var_values
+static signed short var_values[TELEMETRY_VARS];
+
+static unsigned short adc[8];
+static long loop_max = 0;
+static unsigned int events = 0;
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// var_done - runs on the i2c thread for each variable read
+static void var_done(uint8_t var, signed short value, void *arg) {
+	int i;
+
+	pthread_mutex_lock(&lock);
+	for(i = 0; i < num_vars; i++) {
+		if(vars[i] == var) {
+			var_values[i] = value;
+		}
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+int tlm_configure(const char *spec) {
+	char *end;
+	long hz, var;
+
+	hz = strtol(spec, &end, 10);
+	if(end == spec || hz < 0 || hz > TIMER_CONTROL_HZ) {
+		return 0;
+	}
+	period = hz ? TIMER_CONTROL_HZ / hz : 0;
+
+	num_vars = 0;
+	if(*end == ':') {
+		do {
+			spec = end + 1;
+			var = strtol(spec, &end, 10);
+			if(end == spec || var < 0 || var > 255 || num_vars == TELEMETRY_VARS) {
+				return 0;
+			}
+			vars[num_vars++] = var;
+		} while(*end == ',');
+	}
+	return *end == '\0';
+}
+
+void tlm_adc(int channel, unsigned short value) {
+	if(channel >= 0 && channel < 8) {
+		adc[channel] = value;
+	}
+}
+
+void tlm_loop_time(long usec) {
+	events++;
+	if(usec > loop_max) {
+		loop_max = usec;
+	}
+}
+
+void tlm_tick(robot_queue *q) {
+	unsigned short cur[TELEMETRY_FIELDS];
+	unsigned char buf[TELEMETRY_MAX_FRAME];
+	int every; // control ticks between frames
+	int key, len, i;
+
+	if(period == 0) {
+		return;
+	}
+	// fewer frames on a bad link, but always at least the keyframe
+	every = period * link_scale();
+	if(every > TIMER_CONTROL_HZ) {
+		every = TIMER_CONTROL_HZ;
+	}
+	if(++ticks < every) {
+		return;
+	}
+	ticks = 0;
+
+	memset(cur, 0, sizeof(cur));
+	for(i = 0; i < 8; i++) {
+		cur[TELEMETRY_MOTOR + i] = motor_get(i);
+		cur[TELEMETRY_ADC + i] = adc[i];
+	}
+	pthread_mutex_lock(&lock);
+	for(i = 0; i < num_vars; i++) {
+		cur[TELEMETRY_VAR + i] = var_values[i];
+	}
+	pthread_mutex_unlock(&lock);
+	cur[TELEMETRY_QUEUE] = robot_queue_get_length(q);
+	cur[TELEMETRY_I2C_ERRORS] = i2cErrors();
+	cur[TELEMETRY_LOOP_MAX] = loop_max > 0xFFFF ? 0xFFFF : loop_max;
+	cur[TELEMETRY_EVENTS] = events;
+	loop_max = 0;
+	events = 0;
+
+	if(num_vars > 0) {
+		i2c_async_read_variables(vars, num_vars, var_done, NULL);
+	}
+
+	key = (frames == 0);
+	if(++frames >= TIMER_CONTROL_HZ / every) {
+		frames = 0; // a keyframe a second
+	}
+	if((len = telemetry_encode(cur, key, buf)) > 0) {
+		send_datagram(buf, len);
+	}
+}
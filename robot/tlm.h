@@ -0,0 +1,41 @@
+//    tlm.h - gathers the robot's state into telemetry frames
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef TLM_H
+#define TLM_H
+
+#include "robot_queue.h"
+
+#define TLM_DEFAULT_HZ 10
+
+// tlm_configure - sets up telemetry from a "-t" command line argument:
+// 	rate[:var,var...], up to TELEMETRY_VARS robostix variables, with a
+// 	rate of 0 turning it off. Returns 0 if spec is invalid.
+extern int tlm_configure(const char *spec);
+
+// tlm_adc - notes the latest reading of an ADC channel
+extern void tlm_adc(int channel, unsigned short value);
+
+// tlm_loop_time - notes how long the main loop took over one event
+extern void tlm_loop_time(long usec);
+
+// tlm_tick - sends a frame when one is due, once per control tick. The rate
+// 	is divided by link_scale(), down to the keyframe once a second.
+extern void tlm_tick(robot_queue *q);
+
+#endif //!TLM_H
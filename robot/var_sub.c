@@ -0,0 +1,178 @@
+//    var_sub.c - pushes robostix variables to the controller as they change
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// var_sub.c
+//
+// The main loop decides which variables are due and queues one bulk read
+// on the i2c thread; the values come back on that thread, which compares
+// them with what was last sent. The table is shared, so it's locked.
+//
+#include <pthread.h>
+#include <stdlib.h>
+#include "robot_comm.h"
+#include "robot_log.h"
+#include "timer.h"
+#include "i2c_thread.h"
+#include "var_sub.h"
+
+//---------------------------------------------------------------------------//
+// Private Types
+//
+typedef struct {
+	uint8_t var;
+	int period;         // control ticks between reads
+	int threshold;      // smallest change that is sent
+	int countdown;      // ticks until the next read
+	int quiet;          // ticks since the value was last sent
+	int sent;           // a value has been sent
+	signed short last;  // value last sent
+} var_sub;
+
+//---------------------------------------------------------------------------//
+// Private Globals
+//
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static var_sub subs[VAR_SUB_MAX];
+static int num_subs = 0;
+
+static unsigned int count_reads = 0;
+static unsigned int count_sent = 0;
+static unsigned int count_held = 0;
+
+//---------------------------------------------------------------------------//
+// Private Function Implementations
+//
+
+// read_done - runs on the i2c thread for each variable read
+static void read_done(uint8_t var, signed short value, void *arg) {
+	robot_event ev;
+	var_sub *s;
+	int i;
+	int send = 0;
+
+	pthread_mutex_lock(&lock);
+	for(i = 0; i < num_subs && subs[i].var != var; i++)
+		;
+	if(i < num_subs) {
+		s = &subs[i];
+		if(!s->sent || abs(value - s->last) >= s->threshold ||
+				s->quiet >= TIMER_CONTROL_HZ / VAR_SUB_KEEPALIVE_HZ) {
+			s->sent = 1;
+			s->last = value;
+			s->quiet = 0;
+			send = 1;
+			count_sent++;
+		} else {
+			count_held++;
+		}
+	}
+	pthread_mutex_unlock(&lock);
+
+	if(send) {
+		ev.command = ROBOT_EVENT_READ_VAR;
+		ev.index = var;
+		ev.value = value;
+		send_event(&ev);
+	}
+}
+
+//---------------------------------------------------------------------------//
+// Public Function Implementations
+//
+
+void var_sub_event(const robot_event *ev) {
+	int hz = ev->value >> 8;
+	int threshold = ev->value & 0xFF;
+	var_sub *s;
+	int i;
+
+	pthread_mutex_lock(&lock);
+	for(i = 0; i < num_subs && subs[i].var != ev->index; i++)
+		;
+	if(hz == 0) {
+		if(i < num_subs) {
+			subs[i] = subs[--num_subs];
+			log_string(-1, "Unsubscribed from var %d", ev->index);
+		}
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+	if(i == num_subs) {
+		if(num_subs == VAR_SUB_MAX) {
+			pthread_mutex_unlock(&lock);
+			log_string(0, "Too many subscriptions, ignoring var %d", ev->index);
+			return;
+		}
+		s = &subs[num_subs++];
+		s->var = ev->index;
+		s->countdown = 0;
+		s->quiet = 0;
+		s->sent = 0;
+		log_string(-1, "Subscribed to var %d at %d Hz, threshold %d",
+				ev->index, hz, threshold);
+	}
+	// the controller resubscribes now and then, which changes nothing
+	s = &subs[i];
+	s->period = hz >= TIMER_CONTROL_HZ ? 1 : TIMER_CONTROL_HZ / hz;
+	s->threshold = threshold > 0 ? threshold : 1;
+	pthread_mutex_unlock(&lock);
+}
+
+void var_sub_tick() {
+	uint8_t vars[I2C_READ_VARS_MAX];
+	int n = 0;
+	int i;
+
+	pthread_mutex_lock(&lock);
+	for(i = 0; i < num_subs; i++) {
+		subs[i].quiet++;
+		if(--subs[i].countdown > 0) {
+			continue;
+		}
+		subs[i].countdown = subs[i].period;
+		vars[n++] = subs[i].var;
+		if(n == I2C_READ_VARS_MAX) {
+			i2c_async_read_variables(vars, n, read_done, NULL);
+			count_reads++;
+			n = 0;
+		}
+	}
+	if(n > 0) {
+		i2c_async_read_variables(vars, n, read_done, NULL);
+		count_reads++;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void var_sub_clear() {
+	pthread_mutex_lock(&lock);
+	num_subs = 0;
+	pthread_mutex_unlock(&lock);
+}
+
+void var_sub_log_stats(int level) {
+	pthread_mutex_lock(&lock);
+	if(count_reads) {
+		log_string(level, "var_sub: %d vars, %u reads, %u sent, %u held",
+				num_subs, count_reads, count_sent, count_held);
+	}
+	count_reads = 0;
+	count_sent = 0;
+	count_held = 0;
+	pthread_mutex_unlock(&lock);
+}
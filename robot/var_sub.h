@@ -0,0 +1,44 @@
+//    var_sub.h - pushes robostix variables to the controller as they change
+//    Copyright (C) 2007  Illinois Institute of Technology Robotics
+//	  <robotics@iit.edu>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License along
+//    with this program; if not, write to the Free Software Foundation, Inc.,
+//    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef VAR_SUB_H
+#define VAR_SUB_H
+
+#include "events.h"
+
+#define VAR_SUB_MAX 16 // variables that can be subscribed to at once
+#define VAR_SUB_KEEPALIVE_HZ 1 // an unchanged value is still sent this often
+
+// var_sub_event - handles a ROBOT_EVENT_READ_VAR_SUBSCRIBE from the
+// 	controller. The variable is then sampled rate times a second, every
+// 	variable due on a control tick being read in one bus transaction,
+// 	and sent back as a ROBOT_EVENT_READ_VAR when it has moved by at least
+// 	the threshold. A rate of 0 unsubscribes.
+extern void var_sub_event(const robot_event *ev);
+
+// var_sub_tick - queues the reads that are due, once per control tick
+extern void var_sub_tick();
+
+// var_sub_clear - drops every subscription, eg. when a controller starts
+extern void var_sub_clear();
+
+// var_sub_log_stats - logs the reads and the values sent and held back
+// 	since the last call, then resets the counts
+extern void var_sub_log_stats(int level);
+
+#endif //!VAR_SUB_H